@@ -0,0 +1 @@
+/usr/share/aclocal/ltversion.m4
\ No newline at end of file
@@ -48,6 +48,11 @@
  * The tl_array allows using a tl_allocator implementation for handling
  * objects with custom allocation, copy and deallocation mechanics.
  *
+ * An array can be initialized with \ref tl_array_init_inline to use a caller
+ * supplied buffer (e.g. on the stack) for its first few elements. The array
+ * only allocates memory once it outgrows that buffer, which makes short lived
+ * arrays with a handful of elements as cheap as a local variable.
+ *
  * \note Never keep points to elements inside a tl_array. When the array is
  *       resized, its memory location can change, rendering the pointer
  *       invalid.
@@ -95,6 +100,12 @@ struct tl_array {
 
 	/** \brief Pointer to an allocator or NULL if not used */
 	tl_allocator *alloc;
+
+	/**
+	 * \brief A caller supplied buffer used until the array outgrows it
+	 *        or NULL if not used
+	 */
+	void *inline_data;
 };
 
 /**
@@ -130,6 +141,38 @@ static TL_INLINE void tl_array_init(tl_array *vec, size_t elementsize,
 	vec->alloc = alloc;
 }
 
+/**
+ * \brief Initialize a dynamic array that starts out in a caller supplied
+ *        buffer
+ *
+ * \memberof tl_array
+ *
+ * The array uses the buffer until more than count elements are needed, at
+ * which point the elements are moved to dynamically allocated memory. The
+ * buffer is never freed by the array and must remain valid until the array
+ * is cleaned up. Apart from that, the array can be used like any other.
+ *
+ * \param vec         A pointer to an uninitialized dynamic array
+ * \param elementsize The size of a single element
+ * \param alloc       A pointer to an allocator or NULL if not used
+ * \param buffer      A pointer to a buffer, suitably aligned for the
+ *                    elements and large enough to hold count of them
+ * \param count       The number of elements that fit into the buffer
+ */
+static TL_INLINE void tl_array_init_inline(tl_array *vec, size_t elementsize,
+					   tl_allocator *alloc, void *buffer,
+					   size_t count)
+{
+	assert(vec && buffer);
+
+	memset(vec, 0, sizeof(*vec));
+	vec->unitsize = elementsize;
+	vec->alloc = alloc;
+	vec->data = buffer;
+	vec->inline_data = buffer;
+	vec->reserved = count;
+}
+
 /**
  * \brief Free the memory used by a array and reset its fields
  *
@@ -141,7 +184,9 @@ static TL_INLINE void tl_array_cleanup(tl_array *vec)
 {
 	assert(vec);
 	tl_allocator_cleanup(vec->alloc, vec->data, vec->unitsize, vec->used);
-	free(vec->data);
+
+	if (vec->data != vec->inline_data)
+		free(vec->data);
 }
 
 /**
@@ -410,6 +455,30 @@ TLAPI int tl_array_append_array(tl_array *vec, const void *data, size_t count);
 TLAPI int tl_array_insert_sorted(tl_array *vec, tl_compare cmp,
 				 const void *element);
 
+/**
+ * \brief Insert a batch of elements into a sorted array
+ *
+ * \memberof tl_array
+ *
+ * The elements are copied and sorted (stable), then merged into the array
+ * from the back, moving every existing element at most once. The result is
+ * the same as calling \ref tl_array_insert_sorted for every element in
+ * order.
+ *
+ * \note This function runs in O(M*log(M) + N) time for inserting M elements
+ *       into an array of N elements
+ *
+ * \param vec   A pointer to an array, sorted in ascending order with respect
+ *              to the given comparison function
+ * \param cmp   A comparison function used to compare elements
+ * \param data  A pointer to an array of elements to insert, in any order
+ * \param count The number of elements to insert
+ *
+ * \return Non-zero on success, zero on failure (out of memory)
+ */
+TLAPI int tl_array_insert_sorted_batch(tl_array *vec, tl_compare cmp,
+				       const void *data, size_t count);
+
 /**
  * \brief Remove the first element of an array
  *
@@ -525,6 +594,97 @@ TLAPI void *tl_array_search(const tl_array *arr, tl_compare cmp,
 TLAPI void *tl_array_search_unsorted(const tl_array *arr, tl_compare cmp,
 				     const void *key);
 
+/**
+ * \brief Remove consecutive duplicates from an array
+ *
+ * \memberof tl_array
+ *
+ * Of every run of elements that compare equal, only the first one is kept.
+ * Applied to a sorted array, this turns it into a sorted set as expected by
+ * \ref tl_array_union, \ref tl_array_intersection and
+ * \ref tl_array_difference.
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr A pointer to an array
+ * \param cmp A function used to compare two elements or NULL if the elements
+ *            are unsigned integers of 32 or 64 bit
+ */
+TLAPI void tl_array_unique(tl_array *arr, tl_compare cmp);
+
+/**
+ * \brief Compute the union of two sorted sets
+ *
+ * \memberof tl_array
+ *
+ * Both input arrays must be sorted in ascending order and must not contain
+ * duplicates. If one of them is much larger than the other, the position of
+ * each element of the smaller one in the larger one is determined using an
+ * exponential search and the elements in between are copied in bulk.
+ *
+ * If cmp is NULL, the elements are compared as unsigned integers of 32 or
+ * 64 bit (depending on the element size), which is a lot faster than going
+ * through a function pointer.
+ *
+ * \note This function runs in linear time, or O(M*log(N/M)) time for a small
+ *       array of M elements and a large array of N elements
+ *
+ * \param dst A pointer to an array to store the result in. Previous contents
+ *            are discarded. Must not be one of the input arrays.
+ * \param a   A pointer to the first input array
+ * \param b   A pointer to the second input array
+ * \param cmp A function used to compare two elements or NULL
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_array_union(tl_array *dst, const tl_array *a, const tl_array *b,
+			 tl_compare cmp);
+
+/**
+ * \brief Compute the intersection of two sorted sets
+ *
+ * \memberof tl_array
+ *
+ * The same requirements as for \ref tl_array_union apply. For integer
+ * elements (cmp is NULL) of arrays with similar sizes, blocks of elements
+ * are compared against each other using SSE2 instructions if available.
+ *
+ * \note This function runs in linear time, or O(M*log(N/M)) time for a small
+ *       array of M elements and a large array of N elements
+ *
+ * \param dst A pointer to an array to store the result in. Previous contents
+ *            are discarded. Must not be one of the input arrays.
+ * \param a   A pointer to the first input array
+ * \param b   A pointer to the second input array
+ * \param cmp A function used to compare two elements or NULL
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_array_intersection(tl_array *dst, const tl_array *a,
+				const tl_array *b, tl_compare cmp);
+
+/**
+ * \brief Compute the elements of a sorted set that are not in another one
+ *
+ * \memberof tl_array
+ *
+ * The same requirements and optimizations as for
+ * \ref tl_array_intersection apply.
+ *
+ * \note This function runs in linear time, or O(M*log(N/M)) time for a small
+ *       array of M elements and a large array of N elements
+ *
+ * \param dst A pointer to an array to store the result in. Previous contents
+ *            are discarded. Must not be one of the input arrays.
+ * \param a   A pointer to the array to take the elements from
+ * \param b   A pointer to the array of elements to leave out
+ * \param cmp A function used to compare two elements or NULL
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_array_difference(tl_array *dst, const tl_array *a,
+			      const tl_array *b, tl_compare cmp);
+
 /**
  * \brief Shrink the reserved elements to one half if an array is
  *        less than a quarter filled
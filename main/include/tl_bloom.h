@@ -0,0 +1,215 @@
+/*
+ * tl_bloom.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_bloom.h
+ *
+ * \brief Contains a blocked Bloom filter implementation
+ */
+#ifndef TL_BLOOM_H
+#define TL_BLOOM_H
+
+/**
+ * \page containers Containers
+ *
+ * \section tl_bloom Blocked Bloom filter
+ *
+ * The tl_bloom data structure implements an approximate set membership test.
+ * Arbitrary data blocks can be added to the filter, but not removed, and the
+ * filter can be asked whether a data block has been added before. The answer
+ * is either "definitely not" or "probably yes". The rate of false positives
+ * is configured when creating the filter and determines how much memory the
+ * filter needs (roughly 1.6 bytes per key for a rate of 1%).
+ *
+ * A typical use is to put a filter in front of a large \ref tl_hashmap or
+ * \ref tl_rbtree that is mostly probed for keys that are not stored in it,
+ * so that most misses are rejected without walking a bucket chain or a path
+ * down the tree.
+ *
+ * Unlike a classic Bloom filter, the bits of a single key are not spread
+ * across the entire bit array. The array is split into blocks of 512 bit,
+ * i.e. a typical cache line, and all bits of a key are set in the same
+ * block. A query thus touches exactly one cache line. To make up for the
+ * slightly higher false positive rate of this layout, the filter is sized
+ * up by an eighth.
+ *
+ * The block and the bits inside the block are selected using two
+ * \ref tl_hash_murmur3_32 hashes of the data with different seeds.
+ *
+ * A filter can be serialized into a \ref tl_blob in a platform independent
+ * format (all values are stored little endian) and restored from it.
+ */
+
+#include "tl_predef.h"
+
+/** \brief The size of a filter block in 64 bit words */
+#define TL_BLOOM_BLOCK_WORDS 8
+
+/**
+ * \struct tl_bloom
+ *
+ * \brief A blocked Bloom filter
+ *
+ * For a detailed description, see \ref tl_bloom.
+ */
+struct tl_bloom {
+	/** \brief A pointer to the blocks, aligned to the block size */
+	tl_u64 *blocks;
+
+	/** \brief The number of blocks */
+	size_t blockcount;
+
+	/** \brief The number of keys added to the filter so far */
+	size_t count;
+
+	/** \brief The number of bits set per key */
+	unsigned int k;
+
+	/** \brief The seed used for hashing the keys */
+	tl_u32 seed;
+
+	/** \brief The unaligned block memory, used internally */
+	void *mem;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize a Bloom filter
+ *
+ * \memberof tl_bloom
+ *
+ * \param bloom    A pointer to an uninitialized Bloom filter
+ * \param capacity The expected number of keys that will be added
+ * \param fp_rate  The desired false positive rate once the filter holds
+ *                 capacity keys, e.g. 0.01 for 1%. Must be larger than zero
+ *                 and less than one.
+ * \param seed     A seed for the hash function. Two filters can only be
+ *                 compared or merged if they use the same seed.
+ *
+ * \return Non-zero on success, zero if out of memory or the arguments
+ *         are invalid
+ */
+TLAPI int tl_bloom_init(tl_bloom *bloom, size_t capacity, double fp_rate,
+			tl_u32 seed);
+
+/**
+ * \brief Free all memory used by a Bloom filter
+ *
+ * \memberof tl_bloom
+ *
+ * \param bloom A pointer to a Bloom filter
+ */
+TLAPI void tl_bloom_cleanup(tl_bloom *bloom);
+
+/**
+ * \brief Remove all keys from a Bloom filter
+ *
+ * \memberof tl_bloom
+ *
+ * \note This function runs in linear time
+ *
+ * \param bloom A pointer to a Bloom filter
+ */
+TLAPI void tl_bloom_clear(tl_bloom *bloom);
+
+/**
+ * \brief Add a key to a Bloom filter
+ *
+ * \memberof tl_bloom
+ *
+ * \note This function runs in constant time
+ *
+ * \param bloom A pointer to a Bloom filter
+ * \param data  A pointer to the key data
+ * \param size  The number of bytes in the key
+ */
+TLAPI void tl_bloom_add(tl_bloom *bloom, const void *data, size_t size);
+
+/**
+ * \brief Check if a key has possibly been added to a Bloom filter
+ *
+ * \memberof tl_bloom
+ *
+ * \note This function runs in constant time
+ *
+ * \param bloom A pointer to a Bloom filter
+ * \param data  A pointer to the key data
+ * \param size  The number of bytes in the key
+ *
+ * \return Zero if the key has definitely not been added, non-zero if it
+ *         probably has been added.
+ */
+TLAPI int tl_bloom_contains(const tl_bloom *bloom, const void *data,
+			    size_t size);
+
+/**
+ * \brief Merge the keys of one Bloom filter into another
+ *
+ * \memberof tl_bloom
+ *
+ * \note This function runs in linear time
+ *
+ * \param dst A pointer to the Bloom filter to add the keys to
+ * \param src A pointer to the Bloom filter to take the keys from
+ *
+ * \return Non-zero on success, zero if the filters have a different size,
+ *         number of bits per key or seed.
+ */
+TLAPI int tl_bloom_merge(tl_bloom *dst, const tl_bloom *src);
+
+/**
+ * \brief Serialize a Bloom filter into a blob
+ *
+ * \memberof tl_bloom
+ *
+ * \param bloom A pointer to a Bloom filter
+ * \param blob  A pointer to an uninitialized blob to write the filter to
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_bloom_serialize(const tl_bloom *bloom, tl_blob *blob);
+
+/**
+ * \brief Initialize a Bloom filter from a serialized representation
+ *
+ * \memberof tl_bloom
+ *
+ * \param bloom A pointer to an uninitialized Bloom filter
+ * \param blob  A pointer to a blob produced by \ref tl_bloom_serialize
+ *
+ * \return Non-zero on success, zero if out of memory or the blob does not
+ *         contain a valid Bloom filter
+ */
+TLAPI int tl_bloom_deserialize(tl_bloom *bloom, const tl_blob *blob);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_BLOOM_H */
+
@@ -0,0 +1,392 @@
+/*
+ * tl_colarray.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_colarray.h
+ *
+ * \brief Contains a column oriented (struct of arrays) record container
+ */
+#ifndef TL_COLARRAY_H
+#define TL_COLARRAY_H
+
+/**
+ * \page containers Containers
+ *
+ * \section tl_colarray Column array
+ *
+ * A \ref tl_array of records stores each record in one piece. Looking at a
+ * single field of every record then pulls all the other fields through the
+ * cache as well.
+ *
+ * The tl_colarray stores the same records as a set of arrays, one per field
+ * (column). Records are still added, read and removed as a whole, using a
+ * description of where each field is located within a record structure,
+ * but processing a single field of many records only touches the memory of
+ * that column.
+ *
+ * The \ref tl_colarray_scan function uses that layout to find the indices of
+ * all records where a numeric field compares in a given way to a constant,
+ * processing several rows at once using SSE2 instructions if available.
+ * \ref tl_colarray_filter narrows down such a list of indices with further
+ * conditions on other columns.
+ *
+ * The fields are copied with memcpy, the tl_colarray does not support
+ * tl_allocator implementations.
+ *
+ * \note Never keep pointers to elements inside a tl_colarray. When the
+ *       columns are resized, their memory location can change, rendering
+ *       the pointers invalid.
+ */
+
+#include "tl_predef.h"
+
+/**
+ * \enum TL_COLUMN_TYPE
+ *
+ * \brief The data type of a column, used for scanning
+ */
+typedef enum {
+	/** \brief A 32 bit unsigned integer (tl_u32) */
+	TL_COLUMN_U32 = 0,
+
+	/** \brief A 32 bit signed integer (tl_s32) */
+	TL_COLUMN_S32 = 1,
+
+	/** \brief A 64 bit unsigned integer (tl_u64) */
+	TL_COLUMN_U64 = 2,
+
+	/** \brief A 64 bit signed integer (tl_s64) */
+	TL_COLUMN_S64 = 3,
+
+	/** \brief A single precision floating point number */
+	TL_COLUMN_FLOAT = 4,
+
+	/** \brief A double precision floating point number */
+	TL_COLUMN_DOUBLE = 5
+} TL_COLUMN_TYPE;
+
+/**
+ * \enum TL_SCAN_OP
+ *
+ * \brief How a column value is compared to the value scanned for
+ */
+typedef enum {
+	/** \brief Select rows where the column is less than the value */
+	TL_SCAN_LESS = 0,
+
+	/** \brief Select rows where the column is less or equal to the value */
+	TL_SCAN_LESS_EQUAL = 1,
+
+	/** \brief Select rows where the column is greater than the value */
+	TL_SCAN_GREATER = 2,
+
+	/** \brief Select rows where the column is not less than the value */
+	TL_SCAN_GREATER_EQUAL = 3,
+
+	/** \brief Select rows where the column is equal to the value */
+	TL_SCAN_EQUAL = 4,
+
+	/** \brief Select rows where the column is not equal to the value */
+	TL_SCAN_NOT_EQUAL = 5
+} TL_SCAN_OP;
+
+/**
+ * \struct tl_colarray_field
+ *
+ * \brief Describes where a column is located in a record structure
+ */
+struct tl_colarray_field {
+	/** \brief The byte offset of the field, e.g. obtained with offsetof */
+	size_t offset;
+
+	/** \brief The size of the field in bytes */
+	size_t size;
+};
+
+/**
+ * \struct tl_colarray
+ *
+ * \brief A container that stores records column by column
+ *
+ * For a detailed description, see \ref tl_colarray.
+ */
+struct tl_colarray {
+	/** \brief An array of pointers to the data of each column */
+	char **columns;
+
+	/** \brief The location of each column within a record */
+	tl_colarray_field *fields;
+
+	/** \brief The number of columns */
+	size_t colcount;
+
+	/** \brief Number of rows available in each column */
+	size_t reserved;
+
+	/** \brief Number of rows used */
+	size_t used;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize a column array
+ *
+ * \memberof tl_colarray
+ *
+ * \param arr    A pointer to an uninitialized column array
+ * \param fields An array of field descriptions, one per column. The array
+ *               is copied.
+ * \param count  The number of columns
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_colarray_init(tl_colarray *arr, const tl_colarray_field *fields,
+			   size_t count);
+
+/**
+ * \brief Free all the memory used by a column array
+ *
+ * \memberof tl_colarray
+ *
+ * \param arr A pointer to a column array
+ */
+TLAPI void tl_colarray_cleanup(tl_colarray *arr);
+
+/**
+ * \brief Make sure a column array can hold a number of rows without
+ *        resizing the columns
+ *
+ * \memberof tl_colarray
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr  A pointer to a column array
+ * \param size The number of rows to reserve space for
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_colarray_reserve(tl_colarray *arr, size_t size);
+
+/**
+ * \brief Append a record to a column array
+ *
+ * \memberof tl_colarray
+ *
+ * \note This function runs in constant amortized time
+ *
+ * \param arr    A pointer to a column array
+ * \param record A pointer to a record structure to copy the fields from
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_colarray_append(tl_colarray *arr, const void *record);
+
+/**
+ * \brief Append an array of records to a column array
+ *
+ * \memberof tl_colarray
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr        A pointer to a column array
+ * \param records    A pointer to an array of record structures
+ * \param recordsize The size of a record structure, i.e. the distance
+ *                   between two records in the array
+ * \param count      The number of records to append
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_colarray_append_array(tl_colarray *arr, const void *records,
+				   size_t recordsize, size_t count);
+
+/**
+ * \brief Copy the fields of a row into a record structure
+ *
+ * \memberof tl_colarray
+ *
+ * \note This function runs in linear time with respect to the number of
+ *       columns
+ *
+ * \param arr    A pointer to a column array
+ * \param idx    The index of the row
+ * \param record A pointer to a record structure to copy the fields to
+ *
+ * \return Non-zero on success, zero if the index is out of bounds
+ */
+TLAPI int tl_colarray_get(const tl_colarray *arr, size_t idx, void *record);
+
+/**
+ * \brief Overwrite a row with the fields of a record structure
+ *
+ * \memberof tl_colarray
+ *
+ * \note This function runs in linear time with respect to the number of
+ *       columns
+ *
+ * \param arr    A pointer to a column array
+ * \param idx    The index of the row
+ * \param record A pointer to a record structure to copy the fields from
+ *
+ * \return Non-zero on success, zero if the index is out of bounds
+ */
+TLAPI int tl_colarray_set(tl_colarray *arr, size_t idx, const void *record);
+
+/**
+ * \brief Remove a range of rows from a column array
+ *
+ * \memberof tl_colarray
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr   A pointer to a column array
+ * \param idx   The index of the first row to remove
+ * \param count The number of rows to remove
+ */
+TLAPI void tl_colarray_remove(tl_colarray *arr, size_t idx, size_t count);
+
+/**
+ * \brief Get the indices of all rows where a column compares in a given way
+ *        to a value
+ *
+ * \memberof tl_colarray
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr   A pointer to a column array
+ * \param col   The index of the column to scan. The size of the column must
+ *              match the type.
+ * \param type  The data type of the column
+ * \param op    How to compare the column entries to the value
+ * \param value A pointer to the value to compare against, of the given type
+ * \param out   A pointer to an array of size_t elements. The indices of the
+ *              matching rows are appended to it in ascending order.
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_colarray_scan(const tl_colarray *arr, size_t col,
+			   TL_COLUMN_TYPE type, TL_SCAN_OP op,
+			   const void *value, tl_array *out);
+
+/**
+ * \brief Remove the indices of all rows from a list where a column does not
+ *        compare in a given way to a value
+ *
+ * \memberof tl_colarray
+ *
+ * This can be used on the result of \ref tl_colarray_scan to combine the
+ * conditions on multiple columns.
+ *
+ * \note This function runs in linear time with respect to the number of
+ *       indices
+ *
+ * \param arr     A pointer to a column array
+ * \param col     The index of the column to test. The size of the column
+ *                must match the type.
+ * \param type    The data type of the column
+ * \param op      How to compare the column entries to the value
+ * \param value   A pointer to the value to compare against, of the given type
+ * \param indices A pointer to an array of size_t row indices
+ */
+TLAPI void tl_colarray_filter(const tl_colarray *arr, size_t col,
+			      TL_COLUMN_TYPE type, TL_SCAN_OP op,
+			      const void *value, tl_array *indices);
+
+/**
+ * \brief Get a pointer to the contiguous data of a column
+ *
+ * \memberof tl_colarray
+ *
+ * \param arr A pointer to a column array
+ * \param col The index of the column
+ *
+ * \return A pointer to the first entry of the column
+ */
+static TL_INLINE void *tl_colarray_column(const tl_colarray *arr, size_t col)
+{
+	assert(arr && col < arr->colcount);
+	return arr->columns[col];
+}
+
+/**
+ * \brief Get a pointer to a single field of a row in a column array
+ *
+ * \memberof tl_colarray
+ *
+ * \param arr A pointer to a column array
+ * \param col The index of the column
+ * \param idx The index of the row
+ *
+ * \return A pointer to the field or NULL if the index is out of bounds
+ */
+static TL_INLINE void *tl_colarray_at(const tl_colarray *arr, size_t col,
+				      size_t idx)
+{
+	assert(arr && col < arr->colcount);
+
+	if (idx >= arr->used)
+		return NULL;
+
+	return arr->columns[col] + idx * arr->fields[col].size;
+}
+
+/**
+ * \brief Get the number of rows currently in a column array
+ *
+ * \memberof tl_colarray
+ *
+ * \param arr A pointer to a column array
+ *
+ * \return The number of rows in the array
+ */
+static TL_INLINE size_t tl_colarray_get_size(const tl_colarray *arr)
+{
+	assert(arr);
+	return arr->used;
+}
+
+/**
+ * \brief Returns non-zero if a given column array contains no rows
+ *
+ * \memberof tl_colarray
+ *
+ * \param arr A pointer to a column array
+ *
+ * \return Non-zero if the array is empty, zero if not
+ */
+static TL_INLINE int tl_colarray_is_empty(const tl_colarray *arr)
+{
+	assert(arr);
+	return arr->used == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_COLARRAY_H */
+
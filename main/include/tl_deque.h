@@ -0,0 +1,446 @@
+/*
+ * tl_deque.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_deque.h
+ *
+ * \brief Contains a double ended queue based on a ring buffer
+ */
+#ifndef TL_DEQUE_H
+#define TL_DEQUE_H
+
+/**
+ * \page containers Containers
+ *
+ * \section tl_deque Double ended queue
+ *
+ * The tl_deque data structure implements a double ended queue on top of a
+ * growable ring buffer. Elements can be added to or removed from either end
+ * in constant amortized time, without moving any of the other elements as
+ * \ref tl_array_prepend or \ref tl_array_remove_first do, and without
+ * allocating a node per element like the \ref tl_list.
+ *
+ * The elements are stored in a single block of memory with a power of two
+ * size, starting at an arbitrary offset and wrapping around at the end. The
+ * stored elements thus occupy at most two contiguous segments, which can be
+ * accessed directly using \ref tl_deque_get_segment, e.g. for copying them
+ * in bulk.
+ *
+ * When the buffer is full, its size is doubled. The buffer is never shrunk
+ * automatically, since a queue that has been filled up once will usually be
+ * filled up again.
+ *
+ * \note Never keep pointers to elements inside a tl_deque. When the buffer is
+ *       resized, its memory location can change, rendering the pointer
+ *       invalid.
+ *
+ * To sumarize:
+ * \li Random access is done in constant time
+ * \li Adding or removing at either end is done in constant amortized time,
+ *     linear at worst
+ * \li Removing from the middle is done in linear time
+ */
+
+#include "tl_predef.h"
+#include "tl_allocator.h"
+
+#include <string.h>
+
+/**
+ * \struct tl_deque
+ *
+ * \brief A double ended queue stored in a growable ring buffer
+ *
+ * For a detailed description, see \ref tl_deque.
+ */
+struct tl_deque {
+	/** \brief The ring buffer */
+	void *data;
+
+	/** \brief The number of elements that fit in the buffer */
+	size_t reserved;
+
+	/** \brief The buffer index of the first element */
+	size_t head;
+
+	/** \brief The number of elements in the queue */
+	size_t used;
+
+	/** \brief The size of an individual element in bytes */
+	size_t unitsize;
+
+	/** \brief Pointer to an allocator or NULL if not used */
+	tl_allocator *alloc;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \param deque       A pointer to an uninitialized double ended queue
+ * \param elementsize The size of a single element
+ * \param alloc       A pointer to an allocator or NULL if not used
+ */
+static TL_INLINE void tl_deque_init(tl_deque *deque, size_t elementsize,
+				    tl_allocator *alloc)
+{
+	assert(deque);
+
+	memset(deque, 0, sizeof(*deque));
+	deque->unitsize = elementsize;
+	deque->alloc = alloc;
+}
+
+/**
+ * \brief Free all the memory used by a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in linear time
+ *
+ * \param deque A pointer to a double ended queue
+ */
+TLAPI void tl_deque_cleanup(tl_deque *deque);
+
+/**
+ * \brief Remove all elements from a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in linear time
+ *
+ * \param deque A pointer to a double ended queue
+ */
+TLAPI void tl_deque_clear(tl_deque *deque);
+
+/**
+ * \brief Make sure a double ended queue can hold a number of elements
+ *        without growing
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in linear time
+ *
+ * \param deque A pointer to a double ended queue
+ * \param size  The number of elements to reserve space for. Rounded up to a
+ *              power of two.
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_deque_reserve(tl_deque *deque, size_t size);
+
+/**
+ * \brief Add an element to the end of a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in constant amortized time
+ *
+ * \param deque   A pointer to a double ended queue
+ * \param element A pointer to the element to copy
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_deque_append(tl_deque *deque, const void *element);
+
+/**
+ * \brief Add an element to the front of a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in constant amortized time
+ *
+ * \param deque   A pointer to a double ended queue
+ * \param element A pointer to the element to copy
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_deque_prepend(tl_deque *deque, const void *element);
+
+/**
+ * \brief Append an array of elements to a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in linear time
+ *
+ * \param deque A pointer to a double ended queue
+ * \param data  A pointer to an array of elements
+ * \param count The number of elements to append
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_deque_append_array(tl_deque *deque, const void *data,
+				size_t count);
+
+/**
+ * \brief Remove the first element of a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in constant time
+ *
+ * \param deque A pointer to a double ended queue
+ */
+TLAPI void tl_deque_remove_first(tl_deque *deque);
+
+/**
+ * \brief Remove the last element of a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in constant time
+ *
+ * \param deque A pointer to a double ended queue
+ */
+TLAPI void tl_deque_remove_last(tl_deque *deque);
+
+/**
+ * \brief Remove a range of elements from a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * The elements on the shorter side of the range are moved to close the gap.
+ *
+ * \note This function runs in linear time
+ *
+ * \param deque A pointer to a double ended queue
+ * \param idx   The index of the first element to remove
+ * \param count The number of elements to remove
+ */
+TLAPI void tl_deque_remove(tl_deque *deque, size_t idx, size_t count);
+
+/**
+ * \brief Move elements from the front of a double ended queue to an array
+ *
+ * \memberof tl_deque
+ *
+ * The elements are copied to the array in queue order and removed from the
+ * queue without being cleaned up, i.e. the array takes over ownership.
+ *
+ * \note This function runs in linear time with respect to the number of
+ *       elements moved
+ *
+ * \param deque A pointer to a double ended queue
+ * \param data  A pointer to an array large enough to hold count elements
+ * \param count The maximum number of elements to move
+ *
+ * \return The number of elements actually moved
+ */
+TLAPI size_t tl_deque_drop_first(tl_deque *deque, void *data, size_t count);
+
+/**
+ * \brief Move elements from the back of a double ended queue to an array
+ *
+ * \memberof tl_deque
+ *
+ * The elements are copied to the array in queue order and removed from the
+ * queue without being cleaned up, i.e. the array takes over ownership.
+ *
+ * \note This function runs in linear time with respect to the number of
+ *       elements moved
+ *
+ * \param deque A pointer to a double ended queue
+ * \param data  A pointer to an array large enough to hold count elements
+ * \param count The maximum number of elements to move
+ *
+ * \return The number of elements actually moved
+ */
+TLAPI size_t tl_deque_drop_last(tl_deque *deque, void *data, size_t count);
+
+/**
+ * \brief Copy the contents of a double ended queue to an array
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in linear time
+ *
+ * \param deque A pointer to a double ended queue
+ * \param data  A pointer to an array, large enough to hold at least as many
+ *              elements as the queue contains
+ */
+TLAPI void tl_deque_to_array(const tl_deque *deque, void *data);
+
+/**
+ * \brief Get a pointer to an element in a double ended queue by its index
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in constant time
+ *
+ * \param deque A pointer to a double ended queue
+ * \param idx   The index of the element, counting from the front
+ *
+ * \return A pointer to the element or NULL if the index is out of bounds
+ */
+static TL_INLINE void *tl_deque_at(const tl_deque *deque, size_t idx)
+{
+	assert(deque);
+
+	if (idx >= deque->used)
+		return NULL;
+
+	idx = (deque->head + idx) & (deque->reserved - 1);
+	return (char *)deque->data + idx * deque->unitsize;
+}
+
+/**
+ * \brief Get the contiguous run of elements starting at an index
+ *
+ * \memberof tl_deque
+ *
+ * Since the elements wrap around at the end of the ring buffer, they form
+ * at most two contiguous segments. Starting with index 0 and advancing the
+ * index by the returned count visits all of them.
+ *
+ * \note This function runs in constant time
+ *
+ * \param deque A pointer to a double ended queue
+ * \param idx   The index of the first element, counting from the front
+ * \param count Returns the number of elements stored contiguously in memory
+ *              starting at the returned pointer
+ *
+ * \return A pointer to the element or NULL if the index is out of bounds
+ */
+static TL_INLINE void *tl_deque_get_segment(const tl_deque *deque, size_t idx,
+					    size_t *count)
+{
+	size_t pos;
+
+	assert(deque && count);
+
+	if (idx >= deque->used) {
+		*count = 0;
+		return NULL;
+	}
+
+	pos = (deque->head + idx) & (deque->reserved - 1);
+	*count = deque->reserved - pos;
+
+	if (*count > deque->used - idx)
+		*count = deque->used - idx;
+
+	return (char *)deque->data + pos * deque->unitsize;
+}
+
+/**
+ * \brief Returns non-zero if a given double ended queue contains no elements
+ *
+ * \memberof tl_deque
+ *
+ * \note This function runs in constant time
+ *
+ * \param deque A pointer to a double ended queue
+ *
+ * \return Non-zero if the queue is empty, zero if not
+ */
+static TL_INLINE int tl_deque_is_empty(const tl_deque *deque)
+{
+	assert(deque);
+	return deque->used == 0;
+}
+
+/**
+ * \brief Get the number of elements currently in a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \param deque A pointer to a double ended queue
+ *
+ * \return The number of elements in the queue
+ */
+static TL_INLINE size_t tl_deque_get_size(const tl_deque *deque)
+{
+	assert(deque);
+	return deque->used;
+}
+
+/**
+ * \brief Get a pointer to the first element in a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \param deque A pointer to a double ended queue
+ *
+ * \return A pointer to the first element or NULL if empty
+ */
+static TL_INLINE void *tl_deque_get_first(const tl_deque *deque)
+{
+	return tl_deque_at(deque, 0);
+}
+
+/**
+ * \brief Get a pointer to the last element in a double ended queue
+ *
+ * \memberof tl_deque
+ *
+ * \param deque A pointer to a double ended queue
+ *
+ * \return A pointer to the last element or NULL if empty
+ */
+static TL_INLINE void *tl_deque_get_last(const tl_deque *deque)
+{
+	assert(deque);
+	return deque->used ? tl_deque_at(deque, deque->used - 1) : NULL;
+}
+
+/**
+ * \brief Get an iterator to the first element
+ *
+ * \memberof tl_deque
+ *
+ * \note Requesting the key of the iterator returns NULL
+ *
+ * \param deque A pointer to a double ended queue
+ *
+ * \return A pointer to an iterator or NULL on failure
+ */
+TLAPI tl_iterator *tl_deque_first(tl_deque *deque);
+
+/**
+ * \brief Get an iterator to the last element that moves backwards through
+ *        the queue
+ *
+ * \memberof tl_deque
+ *
+ * \note Requesting the key of the iterator returns NULL
+ *
+ * \param deque A pointer to a double ended queue
+ *
+ * \return A pointer to an iterator or NULL on failure
+ */
+TLAPI tl_iterator *tl_deque_last(tl_deque *deque);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_DEQUE_H */
+
@@ -0,0 +1,276 @@
+/*
+ * tl_flatmap.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_flatmap.h
+ *
+ * \brief Contains an open addressing hash map implementation
+ */
+#ifndef TL_FLATMAP_H
+#define TL_FLATMAP_H
+
+/**
+ * \page kvcontainers Key-Value-Containers
+ *
+ * \section tl_flatmap Flat hash map
+ *
+ * The tl_flatmap data structure implements an open addressing hash map,
+ * allowing a mapping of arbitrary key-objects to arbitrary value objects,
+ * just like the \ref tl_hashmap.
+ *
+ * Instead of chaining colliding entries in separately allocated nodes, all
+ * entries are stored in a single, contiguous array of slots. In addition, a
+ * separate array holds one control byte per slot, that tells if the slot is
+ * empty, was deleted or is in use. For used slots, the control byte also
+ * holds 7 bits of the key hash.
+ *
+ * The slots are processed in groups of 16. When looking for a key, the
+ * control bytes of an entire group are compared against the hash bits of the
+ * key at once (using SSE2 instructions if available) and only the keys of
+ * matching slots are actually compared. If the key is not found in a group
+ * and the group has no empty slots, the next group in the probe sequence is
+ * examined.
+ *
+ * Compared to the \ref tl_hashmap, this avoids pointer chasing and allocator
+ * traffic for colliding entries and usually requires only a single key
+ * comparison per lookup. On the other hand, the map has to be rehashed once
+ * it fills up and a key can only be stored once.
+ *
+ * \note Never keep pointers to values inside a tl_flatmap. When the map is
+ *       rehashed, the entries are moved, rendering the pointers invalid.
+ */
+
+#include "tl_predef.h"
+
+/**
+ * \struct tl_flatmap
+ *
+ * \brief An open addressing hash map with group wise probing
+ *
+ * For a detailed description, see \ref tl_flatmap.
+ */
+struct tl_flatmap {
+	/** \brief One control byte per slot */
+	tl_u8 *ctrl;
+
+	/** \brief An array of slots, each holding a key and a value */
+	char *slots;
+
+	/** \brief The size of a key object */
+	size_t keysize;
+
+	/** \brief The key size rounded up to a multiple of sizeof(void*) */
+	size_t keysize_padded;
+
+	/** \brief The size of a value object */
+	size_t objsize;
+
+	/** \brief The size of a single slot */
+	size_t slotsize;
+
+	/** \brief The number of slots, a power of two and at least 16 */
+	size_t bincount;
+
+	/** \brief The number of entries stored in the map */
+	size_t count;
+
+	/** \brief The number of empty slots that can be used before growing */
+	size_t growth_left;
+
+	/** \brief A function used to compute the hash value of a key object */
+	tl_hash hash;
+
+	/** \brief A function used to compare two key objects */
+	tl_compare compare;
+
+	/** \brief A pointer to an allocator for keys or NULL if not used */
+	tl_allocator *keyalloc;
+
+	/** \brief A pointer to an allocator for values or NULL if not used */
+	tl_allocator *objalloc;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize a flat hash map
+ *
+ * \memberof tl_flatmap
+ *
+ * \param map        A pointer to a flat hash map
+ * \param keysize    The size of a key object
+ * \param objsize    The size of a value object
+ * \param bincount   The number of slots to create initially. Rounded up to
+ *                   a power of two, at least 16.
+ * \param keyhash    A function to compute a hash of a key
+ * \param keycompare A function to compare two key objects for equality
+ * \param keyalloc   A pointer to an allocator for keys or NULL if not used
+ * \param valalloc   A pointer to an allocator for values or NULL if not used
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_flatmap_init(tl_flatmap *map, size_t keysize, size_t objsize,
+			  size_t bincount, tl_hash keyhash,
+			  tl_compare keycompare, tl_allocator *keyalloc,
+			  tl_allocator *valalloc);
+
+/**
+ * \brief Free all the memory used by a flat hash map
+ *
+ * \memberof tl_flatmap
+ *
+ * \note This function runs in linear time
+ *
+ * \param map A pointer to a flat hash map
+ */
+TLAPI void tl_flatmap_cleanup(tl_flatmap *map);
+
+/**
+ * \brief Overwrite a flat hash map with a copy of another flat hash map
+ *
+ * \memberof tl_flatmap
+ *
+ * \note This function runs in linear time
+ *
+ * \param dst A pointer to the destination map. Previous contents
+ *            are discarded.
+ * \param src A pointer to the source map
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_flatmap_copy(tl_flatmap *dst, const tl_flatmap *src);
+
+/**
+ * \brief Discard all contents of a flat hash map
+ *
+ * \memberof tl_flatmap
+ *
+ * \note This function runs in linear time
+ *
+ * \param map A pointer to a flat hash map
+ */
+TLAPI void tl_flatmap_clear(tl_flatmap *map);
+
+/**
+ * \brief Add an object to a flat hash map
+ *
+ * \memberof tl_flatmap
+ *
+ * \note This function runs in constant amortized time, linear if the map
+ *       has to be rehashed
+ *
+ * Unlike \ref tl_hashmap_insert, a key can only be stored once. If an entry
+ * with an equivalent key already exists, its value is overwritten.
+ *
+ * \param map    A pointer to a flat hash map
+ * \param key    The key to asociate the object with
+ * \param object The object to store in the map
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_flatmap_insert(tl_flatmap *map, const void *key,
+			    const void *object);
+
+/**
+ * \brief Overwrite the value of an existing entry in a flat hash map
+ *
+ * \memberof tl_flatmap
+ *
+ * \note This function runs in constant average time
+ *
+ * \param map    A pointer to a flat hash map
+ * \param key    A pointer to the key of the entry to overwrite
+ * \param object A pointer to the value to write over the existing one
+ *
+ * \return Non-zero on success, zero if the entry could not be found.
+ */
+TLAPI int tl_flatmap_set(tl_flatmap *map, const void *key, const void *object);
+
+/**
+ * \brief Get an object stored in a flat hash map by its key
+ *
+ * \memberof tl_flatmap
+ *
+ * \note This function runs in constant average time
+ *
+ * \param map A pointer to a flat hash map
+ * \param key A pointer to the key object to look for
+ *
+ * \return A pointer to the object stored in the map or NULL if not found
+ */
+TLAPI void *tl_flatmap_at(const tl_flatmap *map, const void *key);
+
+/**
+ * \brief Remove an object stored in a flat hash map
+ *
+ * \memberof tl_flatmap
+ *
+ * \note This function runs in constant average time
+ *
+ * \param map    A pointer to a flat hash map
+ * \param key    A pointer to the key object to look for
+ * \param object If not NULL, the object stored in the map is memcopied to
+ *               this location.
+ *
+ * \return Non-zero if the object was found, zero if not.
+ */
+TLAPI int tl_flatmap_remove(tl_flatmap *map, const void *key, void *object);
+
+/**
+ * \brief Returns non-zero if a given flat hash map contains no entries
+ *
+ * \memberof tl_flatmap
+ *
+ * \note This function runs in constant time
+ *
+ * \param map A pointer to a flat hash map
+ *
+ * \return Non-zero if the map is empty, zero if not
+ */
+static TL_INLINE int tl_flatmap_is_empty(const tl_flatmap *map)
+{
+	assert(map);
+	return map->count == 0;
+}
+
+/**
+ * \brief Get an iterator that iterates over a flat hash map
+ *
+ * \memberof tl_flatmap
+ *
+ * \param map A pointer to a flat hash map
+ *
+ * \return A pointer to an iterator or NULL on failure
+ */
+TLAPI tl_iterator *tl_flatmap_get_iterator(tl_flatmap *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_FLATMAP_H */
+
@@ -59,6 +59,24 @@
  * \f$\mathcal{O}(\log{n})\f$.
  * An example where a hash map is preferable could be an asociative array that
  * maps strings to objects.
+ *
+ * By default, the number of bins is fixed at initialization time. Using
+ * \ref tl_hashmap_set_max_load, a hash map can be configured to double the
+ * number of bins once the average number of entries per bin exceeds a given
+ * limit. The entries are not rehashed all at once, instead every insert or
+ * remove operation moves a small number of bins over to the new table, so no
+ * single operation has to pay for rehashing the entire map.
+ *
+ * The first entry of every bin is stored inline in the bin array. Further
+ * entries with colliding hashes are taken from a pool of larger memory
+ * blocks owned by the map. Removed entries are kept on a free list for
+ * reuse and the blocks are only released all at once when the map is
+ * cleared or cleaned up.
+ *
+ * Every entry also caches the full hash value of its key. When searching a
+ * chain, the key comparison function is only called for entries with a
+ * matching hash, and moving entries to a larger table during growing never
+ * has to call the hash function again.
  */
 
 #include "tl_predef.h"
@@ -73,6 +91,14 @@
 struct tl_hashmap_entry {
 	/** \brief Linked list pointer */
 	tl_hashmap_entry *next;
+
+	/**
+	 * \brief The full hash value of the key
+	 *
+	 * Stored so that key comparisons can be skipped for entries with a
+	 * different hash and the map can be grown without hashing again.
+	 */
+	unsigned long hash;
 };
 
 /**
@@ -136,6 +162,85 @@ struct tl_hashmap {
 
 	/** \brief A pointer to an allocator for values or NULL if not used */
 	tl_allocator *objalloc;
+
+	/** \brief The number of entries currently stored in the map */
+	size_t count;
+
+	/**
+	 * \brief The maximum average number of entries per bin in percent
+	 *
+	 * If the number of entries exceeds this fraction of the number of
+	 * bins, the bin count is doubled. Zero if the map never grows.
+	 */
+	unsigned int max_load;
+
+	/** \brief While growing, the bins of the previous, smaller table */
+	char *old_bins;
+
+	/** \brief While growing, the usage bitmap of the previous table */
+	int *old_bitmap;
+
+	/** \brief While growing, the number of bins of the previous table */
+	size_t old_bincount;
+
+	/** \brief While growing, the next bin of the previous table to move */
+	size_t rehash_idx;
+
+	/** \brief Unused overflow entries, linked via their next pointer */
+	tl_hashmap_entry *free_list;
+
+	/** \brief Linked list of memory blocks holding overflow entries */
+	void *pool;
+
+	/** \brief Number of never used entries left in the newest pool block */
+	size_t pool_avail;
+
+	/** \brief State of a bulk fill in progress, NULL otherwise */
+	void *bulk;
+};
+
+/**
+ * \brief Number of entries in the chain length histogram of
+ *        \ref tl_hashmap_stats
+ */
+#define TL_HASHMAP_HISTOGRAM_SIZE 8
+
+/**
+ * \struct tl_hashmap_stats
+ *
+ * \brief Occupancy and collision statistics of a tl_hashmap
+ *
+ * \see tl_hashmap_get_stats
+ */
+struct tl_hashmap_stats {
+	/** \brief The number of entries stored in the map */
+	size_t count;
+
+	/** \brief The number of bins, including the old table while growing */
+	size_t bincount;
+
+	/** \brief The number of bins holding at least one entry */
+	size_t used_bins;
+
+	/** \brief The average number of entries per bin */
+	double load_factor;
+
+	/** \brief The length of the longest chain */
+	size_t longest_chain;
+
+	/**
+	 * \brief Chain length histogram
+	 *
+	 * Entry i holds the number of bins with exactly i entries, the last
+	 * entry holds the number of bins with at least that many entries.
+	 */
+	size_t chain_histogram[TL_HASHMAP_HISTOGRAM_SIZE];
+
+	/** \brief The total number of bytes allocated for overflow entries */
+	size_t overflow_bytes;
+
+	/** \brief The number of overflow entries currently not in use */
+	size_t overflow_free;
 };
 
 #ifdef __cplusplus
@@ -164,6 +269,24 @@ TLAPI int tl_hashmap_init(tl_hashmap *map, size_t keysize, size_t objsize,
 			  tl_compare keycompare, tl_allocator *keyalloc,
 			  tl_allocator *valalloc);
 
+/**
+ * \brief Configure a hash map to automatically grow
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs in constant time
+ *
+ * Once the number of entries in the map exceeds max_load percent of the
+ * number of bins, a table with twice the number of bins is allocated. The
+ * entries are moved over to the new table incrementally, a few bins at a time
+ * on every call to \ref tl_hashmap_insert or \ref tl_hashmap_remove.
+ *
+ * \param map      A pointer to a hash map
+ * \param max_load The maximum average number of entries per bin in percent
+ *                 (e.g. 75). Zero to disable growing.
+ */
+TLAPI void tl_hashmap_set_max_load(tl_hashmap *map, unsigned int max_load);
+
 /**
  * \brief Free all the memory used by a hash map
  *
@@ -222,6 +345,10 @@ static TL_INLINE void *tl_hashmap_entry_get_value(const tl_hashmap *map,
  *
  * \note This function runs in constant time
  *
+ * \note While a map is growing, some entries may still be stored in the
+ *       bins of the previous table, which are not accessible through
+ *       this function.
+ *
  * \param map A pointer to a hash map
  * \param idx The index of the bin
  *
@@ -230,6 +357,23 @@ static TL_INLINE void *tl_hashmap_entry_get_value(const tl_hashmap *map,
  */
 TLAPI tl_hashmap_entry *tl_hashmap_get_bin(const tl_hashmap *map, size_t idx);
 
+/**
+ * \brief Gather occupancy and collision statistics of a hash map
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs in linear time
+ *
+ * The statistics can be used to tell whether a slow hash map suffers from
+ * a bad hash function (few used bins, long chains), or simply from too few
+ * bins (high load factor, but evenly distributed chains).
+ *
+ * \param map   A pointer to a hash map
+ * \param stats A pointer to a structure to write the statistics to
+ */
+TLAPI void tl_hashmap_get_stats(const tl_hashmap *map,
+				tl_hashmap_stats *stats);
+
 /**
  * \brief Overwrite a hash map with a copy of another hash map
  *
@@ -262,7 +406,8 @@ TLAPI void tl_hashmap_clear(tl_hashmap *map);
  *
  * \memberof tl_hashmap
  *
- * \note This function runs in constant time
+ * \note This function runs in constant time. If the map is configured to
+ *       grow, a growing step is performed.
  *
  * This function does NOT fail if the entry already exits. If a new entry with
  * an equivalent key is added, it will override the existing one and once
@@ -311,6 +456,87 @@ TLAPI int tl_hashmap_set(tl_hashmap *map, const void *key, const void *object);
  */
 TLAPI void *tl_hashmap_at(const tl_hashmap *map, const void *key);
 
+/**
+ * \brief Get the value stored for a key, adding a new entry if not found
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs roughly in constant time. If a new entry is
+ *       added and the map is configured to grow, a growing step is
+ *       performed.
+ *
+ * The key is hashed and looked up only once. If an entry with an equivalent
+ * key exists, a pointer to its value is returned. Otherwise, a new entry with
+ * a copy of the key is added and a pointer to its value is returned. The new
+ * value is initialized using the init function of the value allocator, or
+ * set to all zero bytes if there is none, so it can later be released by
+ * \ref tl_hashmap_remove or \ref tl_hashmap_clear like any other value.
+ *
+ * This allows updating an aggregate in a single step, for instance:
+ * \code{.c}
+ * long *counter = tl_hashmap_emplace(&map, key, NULL);
+ *
+ * if (counter)
+ *     *counter += 1;
+ * \endcode
+ *
+ * \param map     A pointer to a hashmap
+ * \param key     A pointer to the key object to look for
+ * \param created If not NULL, set to non-zero if a new entry was added,
+ *                zero if an existing one was found
+ *
+ * \return A pointer to the value stored in the map, or NULL if a new entry
+ *         was needed but the map ran out of memory
+ */
+TLAPI void *tl_hashmap_emplace(tl_hashmap *map, const void *key,
+			       int *created);
+
+/**
+ * \brief Add a number of objects to a hashmap at once
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs in linear time in the number of objects
+ *
+ * This has the same effect as calling \ref tl_hashmap_insert for every key
+ * object pair in order, but the keys are hashed in small groups up front
+ * and the target bins are prefetched, so that the cache misses for
+ * different keys overlap instead of being taken one after another.
+ *
+ * \param map     A pointer to a hashmap
+ * \param keys    A pointer to an array of count key objects
+ * \param objects A pointer to an array of count value objects
+ * \param count   The number of key value pairs to insert
+ *
+ * \return The number of objects inserted. If smaller than count, the map ran
+ *         out of memory and only the first objects were inserted.
+ */
+TLAPI size_t tl_hashmap_insert_batch(tl_hashmap *map, const void *keys,
+				     const void *objects, size_t count);
+
+/**
+ * \brief Get a number of objects stored in a hashmap at once
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs in linear time in the number of keys
+ *
+ * This has the same effect as calling \ref tl_hashmap_at for every key, but
+ * the keys are hashed in small groups up front and the target bins are
+ * prefetched before resolving any of them, so that the cache misses for
+ * different keys overlap instead of being taken one after another.
+ *
+ * \param map   A pointer to a hashmap
+ * \param keys  A pointer to an array of count key objects
+ * \param count The number of keys to look up
+ * \param out   An array of count pointers. Receives a pointer to the object
+ *              stored for each key, or NULL if the key was not found.
+ *
+ * \return The number of keys that were found
+ */
+TLAPI size_t tl_hashmap_at_batch(const tl_hashmap *map, const void *keys,
+				 size_t count, void **out);
+
 /**
  * \brief Remove an object stored in a hash map
  *
@@ -320,6 +546,8 @@ TLAPI void *tl_hashmap_at(const tl_hashmap *map, const void *key);
  *       small linear iterating over keys with the same hash) or linear in
  *       worst case if all keys generate the same hash value
  *
+ * If the map is currently growing, a growing step is performed.
+ *
  * \param map    A pointer to a hash map
  * \param key    A pointer to the key object to look for
  * \param object If not NULL, the object stored in the map is memcopied to
@@ -334,7 +562,7 @@ TLAPI int tl_hashmap_remove(tl_hashmap *map, const void *key, void *object);
  *
  * \memberof tl_hashmap
  *
- * \note The run time of this function is proportional to the number of bins
+ * \note This function runs in constant time
  *
  * \param map A pointer to a hash map
  *
@@ -342,6 +570,85 @@ TLAPI int tl_hashmap_remove(tl_hashmap *map, const void *key, void *object);
  */
 TLAPI int tl_hashmap_is_empty(const tl_hashmap *map);
 
+/**
+ * \brief Prepare an empty hash map for being filled in bulk
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs in linear time in the number of bins
+ *
+ * A new, empty table with the given number of bins is allocated and split
+ * up into ranges of consecutive bins. The ranges can then be filled
+ * independently with \ref tl_hashmap_bulk_fill, for instance by different
+ * threads, and the result is committed with \ref tl_hashmap_bulk_end.
+ * Until then, no other function may be called on the map.
+ *
+ * Range i covers the bins from i times the returned width up to, but not
+ * including, (i + 1) times the width, or up to the end of the table for the
+ * last range. The width is always a multiple of the bits in a word of the
+ * usage bitmap, so different ranges never share any memory.
+ *
+ * \param map      A pointer to an empty hash map
+ * \param bincount The number of bins of the new table
+ * \param ranges   On input, the maximum number of ranges to split the table
+ *                 into. On output, the actual number of ranges.
+ *
+ * \return The number of bins per range, or zero if out of memory or the
+ *         map is not empty
+ */
+TLAPI size_t tl_hashmap_bulk_begin(tl_hashmap *map, size_t bincount,
+				   size_t *ranges);
+
+/**
+ * \brief Fill one bin range of a hash map prepared for a bulk fill
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs in linear time in the number of entries
+ *
+ * The key value pairs are added in the given order, with the same result as
+ * inserting them with \ref tl_hashmap_insert. The hash of every key must
+ * select a bin of the range, i.e. the hash modulo the bin count of the map
+ * divided by the range width must yield the range index.
+ *
+ * Calls for different ranges can run concurrently, all other state of the
+ * map is left alone. If the map uses allocators, their copy functions are
+ * called from all of those threads.
+ *
+ * \param map     A pointer to a hash map prepared with
+ *                \ref tl_hashmap_bulk_begin
+ * \param range   The index of the range to fill. Each range can only be
+ *                filled once.
+ * \param keys    An array of key objects
+ * \param objects An array of value objects
+ * \param hashes  An array with the hash value of each key object
+ * \param indices The indices into the above arrays of the pairs to add
+ * \param count   The number of entries in the index array
+ *
+ * \return Non-zero on success, zero if out of memory. On failure, the range
+ *         is left empty.
+ */
+TLAPI int tl_hashmap_bulk_fill(tl_hashmap *map, size_t range,
+			       const void *keys, const void *objects,
+			       const unsigned long *hashes,
+			       const size_t *indices, size_t count);
+
+/**
+ * \brief Finish a bulk fill of a hash map
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs in linear time in the number of ranges, or in
+ *       the number of bins if the fill is discarded and allocators are used
+ *
+ * \param map    A pointer to a hash map prepared with
+ *               \ref tl_hashmap_bulk_begin
+ * \param commit If non-zero, the map takes over the new table with all
+ *               entries added to it. If zero, the new table is discarded and
+ *               the map is left as it was before the bulk fill.
+ */
+TLAPI void tl_hashmap_bulk_end(tl_hashmap *map, int commit);
+
 /**
  * \brief Get an iterator that iterates over a hash map
  *
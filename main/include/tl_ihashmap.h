@@ -0,0 +1,237 @@
+/*
+ * tl_ihashmap.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_ihashmap.h
+ *
+ * \brief Contains an intrusive hash map
+ */
+#ifndef TL_IHASHMAP_H
+#define TL_IHASHMAP_H
+
+/**
+ * \page kvcontainers Key-Value-Containers
+ *
+ * \section tl_ihashmap Intrusive hash map
+ *
+ * The tl_ihashmap data structure is an intrusive variant of the
+ * \ref tl_hashmap. Instead of copying keys and values into entries that it
+ * allocates itself, the map chains together objects that are owned by the
+ * caller. Every object embeds a \ref tl_ihashmap_node and the map only
+ * modifies the contents of that node.
+ *
+ * Inserting or removing an object never copies anything. The only memory
+ * the map allocates is its array of bins. Once the number of objects
+ * exceeds the number of bins, the bin array is doubled in size. If that
+ * fails, the map simply continues with longer chains, so inserting can
+ * not fail.
+ *
+ * The map is initialized with the offset of the node within the objects
+ * (usually determined using offsetof), a hash function and a comparison
+ * function, both called with pointers to objects. Lookups are done with a
+ * pointer to an object (e.g. a temporary on the stack) that only needs to
+ * have the fields set that the hash and comparison functions look at. The
+ * hash value of every linked object is cached in its node.
+ *
+ * Unlike the \ref tl_hashmap, the keys in an intrusive map are unique.
+ *
+ * An object must not be freed or modified in a way that changes its hash
+ * while it is linked into a map and can only be in one map at a time for
+ * every embedded node.
+ */
+
+#include "tl_predef.h"
+
+/**
+ * \struct tl_ihashmap_node
+ *
+ * \brief A node embedded in objects linked into a tl_ihashmap
+ */
+struct tl_ihashmap_node {
+	/** \brief A pointer to the next node in the same bin */
+	tl_ihashmap_node *next;
+
+	/** \brief The cached hash value of the object */
+	unsigned long hash;
+};
+
+/**
+ * \struct tl_ihashmap
+ *
+ * \brief An intrusive, separate chaining hash map
+ *
+ * For a detailed description, see \ref tl_ihashmap.
+ */
+struct tl_ihashmap {
+	/** \brief An array of bins, each pointing to the first node */
+	tl_ihashmap_node **bins;
+
+	/** \brief The number of bins */
+	size_t bincount;
+
+	/** \brief The number of objects in the map */
+	size_t count;
+
+	/** \brief The offset of the tl_ihashmap_node within the objects */
+	size_t offset;
+
+	/** \brief Computes the hash value of an object */
+	tl_hash hash;
+
+	/** \brief Compares two objects for equality */
+	tl_compare compare;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize an intrusive hash map
+ *
+ * \memberof tl_ihashmap
+ *
+ * \param map      A pointer to an intrusive hash map
+ * \param bincount The initial number of bins
+ * \param offset   The offset of the embedded tl_ihashmap_node within
+ *                 the objects
+ * \param hash     A function used to compute the hash value of an object
+ * \param compare  A function used to compare two objects for equality
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_ihashmap_init(tl_ihashmap *map, size_t bincount, size_t offset,
+			   tl_hash hash, tl_compare compare);
+
+/**
+ * \brief Free the bins of an intrusive hash map
+ *
+ * \memberof tl_ihashmap
+ *
+ * The objects themselves are not touched.
+ *
+ * \param map A pointer to an intrusive hash map
+ */
+TLAPI void tl_ihashmap_cleanup(tl_ihashmap *map);
+
+/**
+ * \brief Unlink all objects from an intrusive hash map
+ *
+ * \memberof tl_ihashmap
+ *
+ * \note This function runs in linear time in the number of bins
+ *
+ * The objects themselves are not touched.
+ *
+ * \param map A pointer to an intrusive hash map
+ */
+TLAPI void tl_ihashmap_clear(tl_ihashmap *map);
+
+/**
+ * \brief Link an object into an intrusive hash map
+ *
+ * \memberof tl_ihashmap
+ *
+ * \note This function runs in constant average time, linear if the bin
+ *       array is resized
+ *
+ * \param map A pointer to an intrusive hash map
+ * \param obj A pointer to the object to insert
+ *
+ * \return NULL on success. If an object with an equivalent key is already in
+ *         the map, a pointer to it is returned and obj is not inserted.
+ */
+TLAPI void *tl_ihashmap_insert(tl_ihashmap *map, void *obj);
+
+/**
+ * \brief Find an object in an intrusive hash map
+ *
+ * \memberof tl_ihashmap
+ *
+ * \note This function runs in constant average time
+ *
+ * \param map A pointer to an intrusive hash map
+ * \param key A pointer to an object that compares equal to the one to find
+ *
+ * \return A pointer to the object or NULL if not found
+ */
+TLAPI void *tl_ihashmap_find(const tl_ihashmap *map, const void *key);
+
+/**
+ * \brief Unlink an object from an intrusive hash map
+ *
+ * \memberof tl_ihashmap
+ *
+ * \note This function runs in constant average time
+ *
+ * \param map A pointer to an intrusive hash map
+ * \param key A pointer to an object that compares equal to the one to
+ *            remove, or the object itself
+ *
+ * \return A pointer to the removed object or NULL if not found
+ */
+TLAPI void *tl_ihashmap_remove(tl_ihashmap *map, const void *key);
+
+/**
+ * \brief Get the next object of an intrusive hash map in iteration order
+ *
+ * \memberof tl_ihashmap
+ *
+ * \note This function runs in constant average time
+ *
+ * The objects are returned in bin order. Removing the object last returned
+ * would break the chain, so get the next object before removing it.
+ *
+ * \param map A pointer to an intrusive hash map
+ * \param obj A pointer to an object linked into the map, or NULL to get the
+ *            first object
+ *
+ * \return A pointer to the next object or NULL if there is none
+ */
+TLAPI void *tl_ihashmap_get_next(const tl_ihashmap *map, const void *obj);
+
+/**
+ * \brief Returns non-zero if an intrusive hash map is empty
+ *
+ * \memberof tl_ihashmap
+ *
+ * \note This function runs in constant time
+ *
+ * \param map A pointer to an intrusive hash map
+ *
+ * \return Non-zero if the map is empty, zero if not
+ */
+static TL_INLINE int tl_ihashmap_is_empty(const tl_ihashmap *map)
+{
+	assert(map);
+	return map->count == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_IHASHMAP_H */
+
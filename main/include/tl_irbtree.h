@@ -0,0 +1,248 @@
+/*
+ * tl_irbtree.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_irbtree.h
+ *
+ * \brief Contains an intrusive red-black tree
+ */
+#ifndef TOOLS_IRBTREE_H
+#define TOOLS_IRBTREE_H
+
+/**
+ * \page kvcontainers Key-Value-Containers
+ *
+ * \section tl_irbtree Intrusive red-black tree
+ *
+ * The tl_irbtree data structure is an intrusive variant of the
+ * \ref tl_rbtree. Instead of allocating nodes and copying keys and values
+ * into them, the tree links together objects that are owned by the caller.
+ * Every object embeds a \ref tl_rbtree_node and the tree only modifies the
+ * contents of that node. Inserting or removing an object never allocates
+ * or copies anything.
+ *
+ * The tree is initialized with the offset of the node within the objects
+ * (usually determined using offsetof) and a comparison function that is
+ * called with pointers to two objects. Lookups are done with a pointer to an
+ * object (e.g. a temporary on the stack) that only needs to have the fields
+ * set that the comparison function looks at.
+ *
+ * Unlike the \ref tl_rbtree, the keys in an intrusive tree are unique.
+ *
+ * An object must not be freed or modified in a way that changes its
+ * ordering while it is linked into a tree and can only be in one tree at a
+ * time for every embedded node.
+ *
+ * Here is an example of what using an intrusive tree might look like:
+ * \code{.c}
+ * struct item {
+ *     int id;
+ *     tl_rbtree_node link;
+ * };
+ *
+ * int compare_items(const void *a, const void *b)
+ * {
+ *     return ((const struct item *)a)->id - ((const struct item *)b)->id;
+ * }
+ *
+ * ....
+ *
+ * struct item *it, key;
+ * tl_irbtree tree;
+ *
+ * tl_irbtree_init(&tree, offsetof(struct item, link), compare_items);
+ *
+ * tl_irbtree_insert(&tree, some_item);
+ *
+ * key.id = 42;
+ * it = tl_irbtree_find(&tree, &key);
+ * \endcode
+ */
+
+#include "tl_predef.h"
+#include "tl_rbtree.h"
+
+/**
+ * \struct tl_irbtree
+ *
+ * \brief An intrusive red-black tree
+ *
+ * For a detailed description, see \ref tl_irbtree.
+ */
+struct tl_irbtree {
+	/** \brief A pointer to the node of the root object */
+	tl_rbtree_node *root;
+
+	/** \brief Compares two objects */
+	tl_compare compare;
+
+	/** \brief The offset of the tl_rbtree_node within the objects */
+	size_t offset;
+
+	/** \brief The number of objects in the tree */
+	size_t size;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize an intrusive red-black tree
+ *
+ * \memberof tl_irbtree
+ *
+ * \param tree    A pointer to an intrusive red-black tree
+ * \param offset  The offset of the embedded tl_rbtree_node within
+ *                the objects
+ * \param compare A function used to compare two objects
+ */
+TLAPI void tl_irbtree_init(tl_irbtree *tree, size_t offset,
+			   tl_compare compare);
+
+/**
+ * \brief Unlink all objects from an intrusive red-black tree
+ *
+ * \memberof tl_irbtree
+ *
+ * \note This function runs in constant time
+ *
+ * The objects themselves are not touched.
+ *
+ * \param tree A pointer to an intrusive red-black tree
+ */
+TLAPI void tl_irbtree_clear(tl_irbtree *tree);
+
+/**
+ * \brief Link an object into an intrusive red-black tree
+ *
+ * \memberof tl_irbtree
+ *
+ * \note This function runs in logarithmic time
+ *
+ * \param tree A pointer to an intrusive red-black tree
+ * \param obj  A pointer to the object to insert
+ *
+ * \return NULL on success. If an object with an equivalent key is already in
+ *         the tree, a pointer to it is returned and obj is not inserted.
+ */
+TLAPI void *tl_irbtree_insert(tl_irbtree *tree, void *obj);
+
+/**
+ * \brief Find an object in an intrusive red-black tree
+ *
+ * \memberof tl_irbtree
+ *
+ * \note This function runs in logarithmic time
+ *
+ * \param tree A pointer to an intrusive red-black tree
+ * \param key  A pointer to an object that compares equal to the one to find
+ *
+ * \return A pointer to the object or NULL if not found
+ */
+TLAPI void *tl_irbtree_find(const tl_irbtree *tree, const void *key);
+
+/**
+ * \brief Unlink an object from an intrusive red-black tree
+ *
+ * \memberof tl_irbtree
+ *
+ * \note This function runs in logarithmic time
+ *
+ * \param tree A pointer to an intrusive red-black tree
+ * \param key  A pointer to an object that compares equal to the one to
+ *             remove, or the object itself
+ *
+ * \return A pointer to the removed object or NULL if not found
+ */
+TLAPI void *tl_irbtree_remove(tl_irbtree *tree, const void *key);
+
+/**
+ * \brief Get the smallest object in an intrusive red-black tree
+ *
+ * \memberof tl_irbtree
+ *
+ * \note This function runs in logarithmic time
+ *
+ * \param tree A pointer to an intrusive red-black tree
+ *
+ * \return A pointer to the object or NULL if the tree is empty
+ */
+TLAPI void *tl_irbtree_get_min(const tl_irbtree *tree);
+
+/**
+ * \brief Get the largest object in an intrusive red-black tree
+ *
+ * \memberof tl_irbtree
+ *
+ * \note This function runs in logarithmic time
+ *
+ * \param tree A pointer to an intrusive red-black tree
+ *
+ * \return A pointer to the object or NULL if the tree is empty
+ */
+TLAPI void *tl_irbtree_get_max(const tl_irbtree *tree);
+
+/**
+ * \brief Get the next larger object in an intrusive red-black tree
+ *
+ * \memberof tl_irbtree
+ *
+ * \note This function runs in logarithmic time
+ *
+ * This can be used to iterate over the tree in order. The given object does
+ * not have to be in the tree, so it is safe to remove it while iterating.
+ *
+ * \param tree A pointer to an intrusive red-black tree
+ * \param key  A pointer to an object, or NULL to get the smallest object
+ *
+ * \return A pointer to the smallest object that is larger than key, or NULL
+ *         if there is none
+ */
+TLAPI void *tl_irbtree_get_next(const tl_irbtree *tree, const void *key);
+
+/**
+ * \brief Returns non-zero if an intrusive red-black tree is empty
+ *
+ * \memberof tl_irbtree
+ *
+ * \note This function runs in constant time
+ *
+ * \param tree A pointer to an intrusive red-black tree
+ *
+ * \return Non-zero if the tree is empty, zero if not
+ */
+static TL_INLINE int tl_irbtree_is_empty(const tl_irbtree *tree)
+{
+	assert(tree);
+	return tree->size == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOOLS_IRBTREE_H */
+
@@ -0,0 +1,236 @@
+/*
+ * tl_lrucache.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_lrucache.h
+ *
+ * \brief Contains a least recently used cache implementation
+ */
+#ifndef TL_LRUCACHE_H
+#define TL_LRUCACHE_H
+
+/**
+ * \page kvcontainers Key-Value-Containers
+ *
+ * \section tl_lrucache LRU cache
+ *
+ * The tl_lrucache data structure maps keys to values, like a
+ * \ref tl_hashmap, but only up to a fixed capacity. Once the capacity is
+ * exceeded, the least recently used entries are evicted from the cache.
+ *
+ * Every entry has a cost that is specified when inserting it. The capacity
+ * of the cache limits the sum of the costs of all entries. By always using
+ * a cost of 1, the capacity limits the number of entries. By using the size
+ * of the value in bytes (including any data it owns), it limits the amount
+ * of memory used.
+ *
+ * Internally, the cache uses a \ref tl_hashmap that maps each key to a
+ * separately allocated node holding the value. The nodes are linked into a
+ * doubly linked list ordered by the last time they were accessed. Looking
+ * up, inserting and evicting an entry thus all run in constant average
+ * time, with a single hash map lookup each.
+ *
+ * When an entry is evicted, the cleanup functions of the key and value
+ * allocators are called, which can be used as an eviction callback, e.g.
+ * for releasing resources referenced by the value.
+ *
+ * For a thread safe version that can be shared by multiple threads, see
+ * \ref sharedcache.
+ */
+
+#include "tl_predef.h"
+#include "tl_hashmap.h"
+
+/**
+ * \struct tl_lrucache
+ *
+ * \brief A hash map with a bounded capacity and LRU eviction
+ *
+ * For a detailed description, see \ref tl_lrucache.
+ */
+struct tl_lrucache {
+	/** \brief Maps keys to pointers to the list nodes */
+	tl_hashmap map;
+
+	/** \brief The most recently used node */
+	tl_list_node *first;
+
+	/** \brief The least recently used node, evicted next */
+	tl_list_node *last;
+
+	/** \brief The size of a value object */
+	size_t objsize;
+
+	/** \brief The offset of the value within a node */
+	size_t objoffset;
+
+	/** \brief The maximum sum of the costs of all entries */
+	size_t capacity;
+
+	/** \brief The current sum of the costs of all entries */
+	size_t used;
+
+	/** \brief A pointer to an allocator for values or NULL if not used */
+	tl_allocator *objalloc;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize an LRU cache
+ *
+ * \memberof tl_lrucache
+ *
+ * \param cache      A pointer to an LRU cache
+ * \param keysize    The size of a key object
+ * \param objsize    The size of a value object
+ * \param capacity   The maximum sum of the costs of all entries
+ * \param keyhash    A function to compute a hash of a key
+ * \param keycompare A function to compare two key objects for equality
+ * \param keyalloc   A pointer to an allocator for keys or NULL if not used
+ * \param valalloc   A pointer to an allocator for values or NULL if not used
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_lrucache_init(tl_lrucache *cache, size_t keysize, size_t objsize,
+			   size_t capacity, tl_hash keyhash,
+			   tl_compare keycompare, tl_allocator *keyalloc,
+			   tl_allocator *valalloc);
+
+/**
+ * \brief Free all the memory used by an LRU cache
+ *
+ * \memberof tl_lrucache
+ *
+ * \note This function runs in linear time
+ *
+ * \param cache A pointer to an LRU cache
+ */
+TLAPI void tl_lrucache_cleanup(tl_lrucache *cache);
+
+/**
+ * \brief Remove all entries from an LRU cache
+ *
+ * \memberof tl_lrucache
+ *
+ * \note This function runs in linear time
+ *
+ * \param cache A pointer to an LRU cache
+ */
+TLAPI void tl_lrucache_clear(tl_lrucache *cache);
+
+/**
+ * \brief Get a value from an LRU cache and mark it as most recently used
+ *
+ * \memberof tl_lrucache
+ *
+ * \note This function runs in constant average time
+ *
+ * \param cache A pointer to an LRU cache
+ * \param key   A pointer to the key object to look for
+ *
+ * \return A pointer to the value, valid until the entry is removed or
+ *         evicted, or NULL if not found
+ */
+TLAPI void *tl_lrucache_get(tl_lrucache *cache, const void *key);
+
+/**
+ * \brief Add or overwrite an entry in an LRU cache
+ *
+ * \memberof tl_lrucache
+ *
+ * \note This function runs in constant average time, plus the time needed
+ *       to evict entries
+ *
+ * The entry is marked as most recently used. Afterwards, the least recently
+ * used entries are evicted until the total cost is within the capacity
+ * again. The new entry itself is never evicted, even if its cost alone
+ * exceeds the capacity.
+ *
+ * \param cache  A pointer to an LRU cache
+ * \param key    A pointer to the key object
+ * \param object A pointer to the value object to copy into the cache
+ * \param cost   The cost of the entry, counted against the capacity
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_lrucache_put(tl_lrucache *cache, const void *key,
+			  const void *object, size_t cost);
+
+/**
+ * \brief Remove an entry from an LRU cache
+ *
+ * \memberof tl_lrucache
+ *
+ * \note This function runs in constant average time
+ *
+ * \param cache  A pointer to an LRU cache
+ * \param key    A pointer to the key object to look for
+ * \param object If not NULL, the value is memcopied to this location
+ *               instead of being cleaned up.
+ *
+ * \return Non-zero if the entry was found, zero if not
+ */
+TLAPI int tl_lrucache_remove(tl_lrucache *cache, const void *key,
+			     void *object);
+
+/**
+ * \brief Evict the least recently used entry from an LRU cache
+ *
+ * \memberof tl_lrucache
+ *
+ * \note This function runs in constant average time
+ *
+ * \param cache A pointer to an LRU cache
+ *
+ * \return Non-zero if an entry was evicted, zero if the cache is empty
+ */
+TLAPI int tl_lrucache_evict(tl_lrucache *cache);
+
+/**
+ * \brief Get the number of entries in an LRU cache
+ *
+ * \memberof tl_lrucache
+ *
+ * \note This function runs in constant time
+ *
+ * \param cache A pointer to an LRU cache
+ *
+ * \return The number of entries
+ */
+static TL_INLINE size_t tl_lrucache_count(const tl_lrucache *cache)
+{
+	assert(cache);
+	return cache->map.count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_LRUCACHE_H */
+
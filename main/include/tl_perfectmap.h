@@ -0,0 +1,199 @@
+/*
+ * tl_perfectmap.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_perfectmap.h
+ *
+ * \brief Contains a minimal perfect hash map for static key sets
+ */
+#ifndef TL_PERFECTMAP_H
+#define TL_PERFECTMAP_H
+
+/**
+ * \page kvcontainers Key-Value-Containers
+ *
+ * \section tl_perfectmap Minimal perfect hash map
+ *
+ * The tl_perfectmap data structure maps a fixed set of keys to values. The
+ * map is built once from an array of keys and an array of values and cannot
+ * be modified afterwards, which makes it suitable for lookup tables that
+ * are created at startup and never change (e.g. keyword tables).
+ *
+ * In exchange, lookups never have to deal with collisions. The map uses a
+ * minimal perfect hash function in the "hash and displace" style of the CHD
+ * algorithm: the keys are distributed into small buckets and for every
+ * bucket, a "pilot" value is searched that places all its keys in distinct,
+ * so far unused slots. The map has exactly one slot per key and a lookup
+ * computes the hash of the key, reads the pilot of its bucket, computes the
+ * slot and does a single key comparison.
+ *
+ * The keys are hashed and compared as raw byte blocks using
+ * \ref tl_hash_murmur3_32, so a key must not contain padding bytes or
+ * pointers. Keys of varying length (e.g. strings) can be stored in fixed
+ * size, zero padded buffers.
+ *
+ * The entire map is stored in a single block of memory without any
+ * pointers, so it can be serialized to a \ref tl_blob and loaded again
+ * with a single copy. Keys and values are stored as they are, all other
+ * fields are stored little endian.
+ */
+
+#include "tl_predef.h"
+
+/**
+ * \struct tl_perfectmap
+ *
+ * \brief A static hash map based on a minimal perfect hash function
+ *
+ * For a detailed description, see \ref tl_perfectmap.
+ */
+struct tl_perfectmap {
+	/** \brief The memory block holding the pilots and the slots */
+	void *data;
+
+	/** \brief One pilot value per bucket */
+	tl_u32 *pilots;
+
+	/** \brief An array of slots, each holding a key and a value */
+	char *slots;
+
+	/** \brief The number of buckets */
+	size_t bucketcount;
+
+	/** \brief The number of keys, which is also the number of slots */
+	size_t count;
+
+	/** \brief The size of a key object */
+	size_t keysize;
+
+	/** \brief The key size rounded up to a multiple of 8 */
+	size_t keysize_padded;
+
+	/** \brief The size of a value object */
+	size_t objsize;
+
+	/** \brief The size of a single slot */
+	size_t slotsize;
+
+	/** \brief The seed used for hashing the keys */
+	tl_u32 seed;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Build a perfect hash map from an array of keys and values
+ *
+ * \memberof tl_perfectmap
+ *
+ * \note This function runs in linear average time
+ *
+ * \param map    A pointer to an uninitialized perfect hash map
+ * \param keys   An array of distinct key objects
+ * \param values An array of value objects with the same number of elements
+ *               as the key array
+ *
+ * \return Non-zero on success, zero if out of memory or the key array
+ *         contains duplicates
+ */
+TLAPI int tl_perfectmap_init(tl_perfectmap *map, const tl_array *keys,
+			     const tl_array *values);
+
+/**
+ * \brief Free all the memory used by a perfect hash map
+ *
+ * \memberof tl_perfectmap
+ *
+ * \param map A pointer to a perfect hash map
+ */
+TLAPI void tl_perfectmap_cleanup(tl_perfectmap *map);
+
+/**
+ * \brief Get an object stored in a perfect hash map by its key
+ *
+ * \memberof tl_perfectmap
+ *
+ * \note This function runs in constant worst case time
+ *
+ * \param map A pointer to a perfect hash map
+ * \param key A pointer to the key object to look for
+ *
+ * \return A pointer to the object stored in the map or NULL if not found
+ */
+TLAPI void *tl_perfectmap_at(const tl_perfectmap *map, const void *key);
+
+/**
+ * \brief Get a key stored in a perfect hash map by its slot index
+ *
+ * \memberof tl_perfectmap
+ *
+ * This can be used to iterate over all keys of the map, with the value
+ * stored right after the key at an offset of keysize_padded.
+ *
+ * \param map A pointer to a perfect hash map
+ * \param idx A slot index, less than the number of keys in the map
+ *
+ * \return A pointer to the key or NULL if the index is out of bounds
+ */
+static TL_INLINE void *tl_perfectmap_key_at(const tl_perfectmap *map,
+					    size_t idx)
+{
+	assert(map);
+	return idx < map->count ? map->slots + idx * map->slotsize : NULL;
+}
+
+/**
+ * \brief Serialize a perfect hash map into a blob
+ *
+ * \memberof tl_perfectmap
+ *
+ * \param map  A pointer to a perfect hash map
+ * \param blob A pointer to an uninitialized blob to write the map to
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_perfectmap_serialize(const tl_perfectmap *map, tl_blob *blob);
+
+/**
+ * \brief Initialize a perfect hash map from a serialized representation
+ *
+ * \memberof tl_perfectmap
+ *
+ * \param map  A pointer to an uninitialized perfect hash map
+ * \param blob A pointer to a blob produced by \ref tl_perfectmap_serialize
+ *
+ * \return Non-zero on success, zero if out of memory or the blob does not
+ *         contain a valid perfect hash map
+ */
+TLAPI int tl_perfectmap_deserialize(tl_perfectmap *map, const tl_blob *blob);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_PERFECTMAP_H */
+
@@ -179,15 +179,29 @@ typedef enum {
 } TL_ERROR_CODE;
 
 typedef struct tl_array tl_array;
+typedef struct tl_deque tl_deque;
+typedef struct tl_segarray tl_segarray;
+typedef struct tl_searchindex tl_searchindex;
+typedef struct tl_colarray tl_colarray;
+typedef struct tl_colarray_field tl_colarray_field;
 typedef struct tl_list_node tl_list_node;
 typedef struct tl_list tl_list;
 typedef struct tl_queue tl_queue;
 typedef struct tl_rbtree_node tl_rbtree_node;
 typedef struct tl_rbtree tl_rbtree;
+typedef struct tl_irbtree tl_irbtree;
 typedef struct tl_stack tl_stack;
 typedef struct tl_string tl_string;
 typedef struct tl_hashmap tl_hashmap;
 typedef struct tl_hashmap_entry tl_hashmap_entry;
+typedef struct tl_hashmap_stats tl_hashmap_stats;
+typedef struct tl_hashmap_snapshot tl_hashmap_snapshot;
+typedef struct tl_ihashmap tl_ihashmap;
+typedef struct tl_ihashmap_node tl_ihashmap_node;
+typedef struct tl_flatmap tl_flatmap;
+typedef struct tl_lrucache tl_lrucache;
+typedef struct tl_perfectmap tl_perfectmap;
+typedef struct tl_bloom tl_bloom;
 typedef struct tl_allocator tl_allocator;
 typedef struct tl_iterator tl_iterator;
 typedef struct tl_blob tl_blob;
@@ -203,6 +217,11 @@ typedef struct tl_rwlock tl_rwlock;
 typedef struct tl_monitor tl_monitor;
 typedef struct tl_thread tl_thread;
 typedef struct tl_threadpool tl_threadpool;
+typedef struct tl_sharedmap tl_sharedmap;
+typedef struct tl_sharedcache tl_sharedcache;
+typedef struct tl_rcumap tl_rcumap;
+typedef struct tl_rcumap_reader tl_rcumap_reader;
+typedef struct tl_filearray tl_filearray;
 typedef struct tl_file_mapping tl_file_mapping;
 typedef struct tl_transform tl_transform;
 
@@ -0,0 +1,188 @@
+/*
+ * tl_searchindex.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_searchindex.h
+ *
+ * \brief Contains a cache friendly search index for sorted arrays
+ */
+#ifndef TL_SEARCHINDEX_H
+#define TL_SEARCHINDEX_H
+
+/**
+ * \page containers Containers
+ *
+ * \section tl_searchindex Search index for sorted arrays
+ *
+ * A binary search through a large, sorted \ref tl_array touches a different
+ * cache line on every step and the direction taken on every step is
+ * essentially random, so that the branch is mispredicted half of the time.
+ *
+ * The tl_searchindex is a read only copy of the elements of a sorted array,
+ * stored in Eytzinger (breadth first) order, i.e. the element at position
+ * k is followed by the elements at positions 2k and 2k+1 in the implicit
+ * binary search tree. The first levels of the tree are packed in a few cache
+ * lines that stay hot, the children of a node are next to each other and
+ * the descendants a few levels down occupy a contiguous range, which is
+ * prefetched while comparing. The search loop descends the tree by
+ * computing the next position from the comparison result, without any
+ * branch depending on it.
+ *
+ * If no comparison function is given, the elements are compared as unsigned
+ * integers of 32 or 64 bit (depending on the element size) right inside the
+ * search loop, which avoids a function pointer call on every level.
+ *
+ * Searching the index yields the position of an element in the original
+ * array. The elements are memcopied into the index, so the array must not
+ * be modified or cleaned up while the index is in use.
+ */
+
+#include "tl_predef.h"
+
+/**
+ * \struct tl_searchindex
+ *
+ * \brief A read only search index for a sorted array
+ *
+ * For a detailed description, see \ref tl_searchindex.
+ */
+struct tl_searchindex {
+	/** \brief The array the index was built from */
+	const tl_array *array;
+
+	/** \brief The memory block holding the elements */
+	void *mem;
+
+	/**
+	 * \brief The elements in Eytzinger order, the first one starting at
+	 *        index 1, aligned to a cache line within the memory block
+	 */
+	char *data;
+
+	/** \brief The number of elements in the index */
+	size_t count;
+
+	/** \brief The number of levels of the implicit tree */
+	unsigned int levels;
+
+	/** \brief The number of elements on the last, partially filled level */
+	size_t last_level;
+
+	/** \brief The size of an individual element in bytes */
+	size_t unitsize;
+
+	/**
+	 * \brief The function used to compare a key to an element, or NULL
+	 *        if the elements are unsigned integers
+	 */
+	tl_compare compare;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Build a search index for a sorted array
+ *
+ * \memberof tl_searchindex
+ *
+ * \note This function runs in linear time
+ *
+ * \param index A pointer to an uninitialized search index
+ * \param array A pointer to an array, sorted in ascending order with respect
+ *              to the given comparison function
+ * \param cmp   A function used to compare a key to an element. The key is
+ *              always passed as first argument. NULL if the elements are
+ *              unsigned integers of 32 or 64 bit.
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_searchindex_init(tl_searchindex *index, const tl_array *array,
+			      tl_compare cmp);
+
+/**
+ * \brief Free all memory used by a search index
+ *
+ * \memberof tl_searchindex
+ *
+ * \param index A pointer to a search index
+ */
+TLAPI void tl_searchindex_cleanup(tl_searchindex *index);
+
+/**
+ * \brief Find the first element in the array that is not less than a key
+ *
+ * \memberof tl_searchindex
+ *
+ * \note This function runs in logarithmic time
+ *
+ * \param index A pointer to a search index
+ * \param key   A pointer to the key to look for
+ *
+ * \return The index of the element in the original array, or the number of
+ *         elements if all of them are less than the key
+ */
+TLAPI size_t tl_searchindex_lower_bound(const tl_searchindex *index,
+					const void *key);
+
+/**
+ * \brief Find the first element in the array that is greater than a key
+ *
+ * \memberof tl_searchindex
+ *
+ * \note This function runs in logarithmic time
+ *
+ * \param index A pointer to a search index
+ * \param key   A pointer to the key to look for
+ *
+ * \return The index of the element in the original array, or the number of
+ *         elements if none of them is greater than the key
+ */
+TLAPI size_t tl_searchindex_upper_bound(const tl_searchindex *index,
+					const void *key);
+
+/**
+ * \brief Search an element in the array, equivalent to
+ *        \ref tl_array_search
+ *
+ * \memberof tl_searchindex
+ *
+ * \note This function runs in logarithmic time
+ *
+ * \param index A pointer to a search index
+ * \param key   A pointer to the key to look for
+ *
+ * \return A pointer to the first matching element in the original array or
+ *         NULL if not found
+ */
+TLAPI void *tl_searchindex_find(const tl_searchindex *index, const void *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_SEARCHINDEX_H */
+
@@ -0,0 +1,306 @@
+/*
+ * tl_segarray.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_segarray.h
+ *
+ * \brief Contains a segmented array with stable element addresses
+ */
+#ifndef TL_SEGARRAY_H
+#define TL_SEGARRAY_H
+
+/**
+ * \page containers Containers
+ *
+ * \section tl_segarray Segmented array
+ *
+ * The tl_segarray data structure implements a dynamic array that never moves
+ * its elements. Instead of one contiguous block that is reallocated when it
+ * runs full, the elements are stored in fixed size chunks. A table of chunk
+ * pointers is used to locate an element by its index in constant time and
+ * only this table is reallocated when the array grows.
+ *
+ * In contrast to a \ref tl_array, pointers to elements remain valid until the
+ * element is removed or the array is cleaned up. In contrast to a
+ * \ref tl_list, elements are stored densely, with no per element allocation
+ * or pointer overhead. The chunks can be accessed directly using
+ * \ref tl_segarray_get_segment for scanning through the elements at nearly
+ * the speed of a plain array.
+ *
+ * Elements can only be added or removed at the end of the array.
+ *
+ * To sumarize:
+ * \li Random access is done in constant time
+ * \li Appending is done in constant amortized time
+ * \li Removing from the end is done in constant time
+ * \li Element addresses never change
+ */
+
+#include "tl_predef.h"
+#include "tl_allocator.h"
+
+/**
+ * \struct tl_segarray
+ *
+ * \brief A dynamic array, made up of fixed size chunks
+ *
+ * For a detailed description, see \ref tl_segarray.
+ */
+struct tl_segarray {
+	/** \brief A table of pointers to the chunks */
+	char **chunks;
+
+	/** \brief The number of chunks allocated */
+	size_t chunkcount;
+
+	/** \brief The number of entries available in the chunk table */
+	size_t tablesize;
+
+	/** \brief Number of elements used */
+	size_t used;
+
+	/** \brief Size of an individual element in bytes */
+	size_t unitsize;
+
+	/** \brief Base 2 logarithm of the number of elements per chunk */
+	unsigned int shift;
+
+	/** \brief Pointer to an allocator or NULL if not used */
+	tl_allocator *alloc;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize a segmented array
+ *
+ * \memberof tl_segarray
+ *
+ * \param arr         A pointer to an uninitialized segmented array
+ * \param elementsize The size of a single element
+ * \param chunksize   The number of elements per chunk, rounded up to a
+ *                    power of two. If zero, a chunk size of roughly 4 KiB
+ *                    is used.
+ * \param alloc       A pointer to an allocator or NULL if not used
+ */
+TLAPI void tl_segarray_init(tl_segarray *arr, size_t elementsize,
+			    size_t chunksize, tl_allocator *alloc);
+
+/**
+ * \brief Free all the memory used by a segmented array
+ *
+ * \memberof tl_segarray
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr A pointer to a segmented array
+ */
+TLAPI void tl_segarray_cleanup(tl_segarray *arr);
+
+/**
+ * \brief Remove all elements from a segmented array
+ *
+ * \memberof tl_segarray
+ *
+ * The chunks are kept around for reuse.
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr A pointer to a segmented array
+ */
+TLAPI void tl_segarray_clear(tl_segarray *arr);
+
+/**
+ * \brief Make sure a segmented array can hold a number of elements without
+ *        allocating more chunks
+ *
+ * \memberof tl_segarray
+ *
+ * \param arr  A pointer to a segmented array
+ * \param size The number of elements to reserve space for
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_segarray_reserve(tl_segarray *arr, size_t size);
+
+/**
+ * \brief Append an element to a segmented array
+ *
+ * \memberof tl_segarray
+ *
+ * \note This function runs in constant amortized time
+ *
+ * \param arr     A pointer to a segmented array
+ * \param element A pointer to the element to copy
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_segarray_append(tl_segarray *arr, const void *element);
+
+/**
+ * \brief Append an array of elements to a segmented array
+ *
+ * \memberof tl_segarray
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr   A pointer to a segmented array
+ * \param data  A pointer to an array of elements
+ * \param count The number of elements to append
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLAPI int tl_segarray_append_array(tl_segarray *arr, const void *data,
+				   size_t count);
+
+/**
+ * \brief Remove elements from the end of a segmented array
+ *
+ * \memberof tl_segarray
+ *
+ * \note This function runs in linear time with respect to the number of
+ *       elements removed
+ *
+ * \param arr   A pointer to a segmented array
+ * \param count The number of elements to remove
+ */
+TLAPI void tl_segarray_remove_last(tl_segarray *arr, size_t count);
+
+/**
+ * \brief Get a pointer to an element in a segmented array by its index
+ *
+ * \memberof tl_segarray
+ *
+ * \note This function runs in constant time
+ *
+ * \param arr A pointer to a segmented array
+ * \param idx The index of the element
+ *
+ * \return A pointer to the element or NULL if the index is out of bounds
+ */
+static TL_INLINE void *tl_segarray_at(const tl_segarray *arr, size_t idx)
+{
+	assert(arr);
+
+	if (idx >= arr->used)
+		return NULL;
+
+	return arr->chunks[idx >> arr->shift] +
+	       (idx & (((size_t)1 << arr->shift) - 1)) * arr->unitsize;
+}
+
+/**
+ * \brief Get the contiguous run of elements starting at an index
+ *
+ * \memberof tl_segarray
+ *
+ * Starting with index 0 and advancing the index by the returned count
+ * visits every chunk in order.
+ *
+ * \note This function runs in constant time
+ *
+ * \param arr   A pointer to a segmented array
+ * \param idx   The index of the first element
+ * \param count Returns the number of elements stored contiguously in memory
+ *              starting at the returned pointer
+ *
+ * \return A pointer to the element or NULL if the index is out of bounds
+ */
+static TL_INLINE void *tl_segarray_get_segment(const tl_segarray *arr,
+					       size_t idx, size_t *count)
+{
+	size_t offset;
+
+	assert(arr && count);
+
+	if (idx >= arr->used) {
+		*count = 0;
+		return NULL;
+	}
+
+	offset = idx & (((size_t)1 << arr->shift) - 1);
+	*count = ((size_t)1 << arr->shift) - offset;
+
+	if (*count > arr->used - idx)
+		*count = arr->used - idx;
+
+	return arr->chunks[idx >> arr->shift] + offset * arr->unitsize;
+}
+
+/**
+ * \brief Returns non-zero if a given segmented array contains no elements
+ *
+ * \memberof tl_segarray
+ *
+ * \note This function runs in constant time
+ *
+ * \param arr A pointer to a segmented array
+ *
+ * \return Non-zero if the array is empty, zero if not
+ */
+static TL_INLINE int tl_segarray_is_empty(const tl_segarray *arr)
+{
+	assert(arr);
+	return arr->used == 0;
+}
+
+/**
+ * \brief Get the number of elements currently in a segmented array
+ *
+ * \memberof tl_segarray
+ *
+ * \param arr A pointer to a segmented array
+ *
+ * \return The number of elements in the array
+ */
+static TL_INLINE size_t tl_segarray_get_size(const tl_segarray *arr)
+{
+	assert(arr);
+	return arr->used;
+}
+
+/**
+ * \brief Get a pointer to the last element in a segmented array
+ *
+ * \memberof tl_segarray
+ *
+ * \param arr A pointer to a segmented array
+ *
+ * \return A pointer to the last element or NULL if empty
+ */
+static TL_INLINE void *tl_segarray_get_last(const tl_segarray *arr)
+{
+	assert(arr);
+	return arr->used ? tl_segarray_at(arr, arr->used - 1) : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TL_SEGARRAY_H */
+
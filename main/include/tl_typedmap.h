@@ -0,0 +1,319 @@
+/*
+ * tl_typedmap.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_typedmap.h
+ *
+ * \brief Contains a macro that generates type specialized hash maps
+ */
+#ifndef TL_TYPEDMAP_H
+#define TL_TYPEDMAP_H
+
+/**
+ * \page kvcontainers Key-Value-Containers
+ *
+ * \section tl_typedmap Type specialized hash map
+ *
+ * A \ref tl_hashmap works with keys and values of arbitrary size. Every
+ * operation calls the hash and compare functions through function pointers,
+ * copies objects through \ref tl_allocator_copy and locates the key and value
+ * of an entry using offsets computed at run time.
+ *
+ * For hot maps with fixed key and value types, the \ref TL_HASHMAP_DEFINE
+ * macro generates a type specialized separate chaining hash map instead.
+ * Keys and values are stored as members of the entry structure and copied by
+ * assignment, and the hash and equality functions are called directly, so
+ * the compiler can inline all of it.
+ *
+ * Apart from that, the generated map behaves like a \ref tl_hashmap:
+ * inserting an already existing key shadows the existing entry until the
+ * new one is removed, every entry caches the hash value of its key and the
+ * map optionally doubles its bin count once a maximum load is exceeded.
+ * Unlike a \ref tl_hashmap, growing is done all at once and allocators are
+ * not supported, i.e. keys and values should be plain data types.
+ *
+ * Example:
+ * \code{.c}
+ * static TL_INLINE unsigned long u64_hash(tl_u64 key)
+ * {
+ *     return (unsigned long)(key ^ (key >> 32));
+ * }
+ *
+ * #define U64_EQUAL(a, b) ((a) == (b))
+ *
+ * TL_HASHMAP_DEFINE(ptrmap, tl_u64, void *, u64_hash, U64_EQUAL)
+ *
+ * ...
+ *
+ * ptrmap map;
+ * void **ptr;
+ *
+ * ptrmap_init(&map, 64);
+ * ptrmap_set_max_load(&map, 100);
+ *
+ * ptrmap_insert(&map, 42, &map);
+ * ptr = ptrmap_at(&map, 42);
+ *
+ * ptrmap_cleanup(&map);
+ * \endcode
+ */
+
+#include "tl_predef.h"
+
+#include <stdlib.h>
+
+/**
+ * \brief Generate a type specialized hash map
+ *
+ * This defines a structure type called name, an entry structure type called
+ * name_entry and the following static inline functions operating on them:
+ * \li int name_init(name *map, size_t bincount) initializes a map with the
+ *     given, non-zero number of bins. Returns zero if out of memory.
+ * \li void name_cleanup(name *map) frees all memory used by a map.
+ * \li void name_clear(name *map) removes all entries from a map.
+ * \li void name_set_max_load(name *map, unsigned int max_load) makes the
+ *     map double its number of bins once it holds more than max_load
+ *     percent entries per bin. Zero (the default) disables growing.
+ * \li int name_insert(name *map, K key, V value) adds an entry, shadowing
+ *     an existing one with an equal key. Returns zero if out of memory.
+ * \li V *name_at(const name *map, K key) returns a pointer to the value of
+ *     the most recently inserted entry with an equal key, or NULL.
+ * \li int name_set(name *map, K key, V value) overwrites the value of an
+ *     existing entry. Returns zero if the key was not found.
+ * \li int name_remove(name *map, K key, V *value) removes the most recently
+ *     inserted entry with an equal key and, if value is not NULL, stores its
+ *     value there. Returns zero if the key was not found.
+ * \li int name_is_empty(const name *map) returns non-zero if the map is
+ *     empty.
+ *
+ * Removed entries are kept on a free list and reused by later insertions.
+ *
+ * \param name   The name of the generated map type, used as a prefix for
+ *               all generated functions
+ * \param K      The key type
+ * \param V      The value type
+ * \param hashfn A function or function like macro that takes a K and returns
+ *               an unsigned long hash value
+ * \param eqfn   A function or function like macro that takes two K and
+ *               returns non-zero if they are equal
+ */
+#define TL_HASHMAP_DEFINE(name, K, V, hashfn, eqfn) \
+typedef struct name##_entry { \
+	struct name##_entry *next; \
+	unsigned long hash; \
+	K key; \
+	V value; \
+} name##_entry; \
+\
+typedef struct name { \
+	name##_entry **bins; \
+	size_t bincount; \
+	size_t count; \
+	unsigned int max_load; \
+	name##_entry *free_list; \
+} name; \
+\
+static TL_INLINE int name##_init(name *map, size_t bincount) \
+{ \
+	assert(map && bincount); \
+\
+	map->bins = (name##_entry **)calloc(bincount, sizeof(map->bins[0])); \
+	if (!map->bins) \
+		return 0; \
+\
+	map->bincount = bincount; \
+	map->count = 0; \
+	map->max_load = 0; \
+	map->free_list = NULL; \
+	return 1; \
+} \
+\
+static TL_INLINE void name##_clear(name *map) \
+{ \
+	name##_entry *ent; \
+	size_t i; \
+\
+	assert(map); \
+\
+	for (i = 0; i < map->bincount; ++i) { \
+		while (map->bins[i]) { \
+			ent = map->bins[i]; \
+			map->bins[i] = ent->next; \
+			ent->next = map->free_list; \
+			map->free_list = ent; \
+		} \
+	} \
+\
+	map->count = 0; \
+} \
+\
+static TL_INLINE void name##_cleanup(name *map) \
+{ \
+	name##_entry *ent; \
+\
+	assert(map); \
+\
+	name##_clear(map); \
+\
+	while (map->free_list) { \
+		ent = map->free_list; \
+		map->free_list = ent->next; \
+		free(ent); \
+	} \
+\
+	free(map->bins); \
+	map->bins = NULL; \
+	map->bincount = 0; \
+} \
+\
+static TL_INLINE void name##_set_max_load(name *map, unsigned int max_load) \
+{ \
+	assert(map); \
+	map->max_load = max_load; \
+} \
+\
+static TL_INLINE int name##_grow(name *map) \
+{ \
+	name##_entry **bins, *ent, *next, *rev; \
+	size_t i, idx, bincount = map->bincount * 2; \
+\
+	bins = (name##_entry **)calloc(bincount, sizeof(bins[0])); \
+	if (!bins) \
+		return 0; \
+\
+	/* a new bin is only fed by a single old bin, reversing the old */ \
+	/* chain first keeps shadowed duplicates behind the newer ones */ \
+	for (i = 0; i < map->bincount; ++i) { \
+		for (rev = NULL, ent = map->bins[i]; ent; ent = next) { \
+			next = ent->next; \
+			ent->next = rev; \
+			rev = ent; \
+		} \
+\
+		for (ent = rev; ent; ent = next) { \
+			next = ent->next; \
+			idx = ent->hash % bincount; \
+			ent->next = bins[idx]; \
+			bins[idx] = ent; \
+		} \
+	} \
+\
+	free(map->bins); \
+	map->bins = bins; \
+	map->bincount = bincount; \
+	return 1; \
+} \
+\
+static TL_INLINE int name##_insert(name *map, K key, V value) \
+{ \
+	name##_entry *ent; \
+	size_t idx; \
+\
+	assert(map); \
+\
+	if (map->max_load && (tl_u64)(map->count + 1) * 100 > \
+	    (tl_u64)map->bincount * map->max_load) { \
+		name##_grow(map); \
+	} \
+\
+	if (map->free_list) { \
+		ent = map->free_list; \
+		map->free_list = ent->next; \
+	} else { \
+		ent = (name##_entry *)malloc(sizeof(*ent)); \
+		if (!ent) \
+			return 0; \
+	} \
+\
+	ent->hash = hashfn(key); \
+	ent->key = key; \
+	ent->value = value; \
+\
+	idx = ent->hash % map->bincount; \
+	ent->next = map->bins[idx]; \
+	map->bins[idx] = ent; \
+	++map->count; \
+	return 1; \
+} \
+\
+static TL_INLINE V *name##_at(const name *map, K key) \
+{ \
+	unsigned long hash = hashfn(key); \
+	name##_entry *ent; \
+\
+	assert(map); \
+\
+	for (ent = map->bins[hash % map->bincount]; ent; ent = ent->next) { \
+		if (ent->hash == hash && eqfn(ent->key, key)) \
+			return &ent->value; \
+	} \
+\
+	return NULL; \
+} \
+\
+static TL_INLINE int name##_set(name *map, K key, V value) \
+{ \
+	V *ptr = name##_at(map, key); \
+\
+	if (!ptr) \
+		return 0; \
+\
+	*ptr = value; \
+	return 1; \
+} \
+\
+static TL_INLINE int name##_remove(name *map, K key, V *value) \
+{ \
+	unsigned long hash = hashfn(key); \
+	name##_entry **it, *ent; \
+\
+	assert(map); \
+\
+	for (it = map->bins + hash % map->bincount; *it; it = &(*it)->next) { \
+		ent = *it; \
+		if (ent->hash != hash || !eqfn(ent->key, key)) \
+			continue; \
+\
+		if (value) \
+			*value = ent->value; \
+\
+		*it = ent->next; \
+		ent->next = map->free_list; \
+		map->free_list = ent; \
+		--map->count; \
+		return 1; \
+	} \
+\
+	return 0; \
+} \
+\
+static TL_INLINE int name##_is_empty(const name *map) \
+{ \
+	assert(map); \
+	return map->count == 0; \
+}
+
+#endif /* TL_TYPEDMAP_H */
+
@@ -9,6 +9,26 @@
 #include "tl_array.h"
 #include "tl_allocator.h"
 
+/*
+    Resize the data block to hold count elements. As long as the array still
+    lives in its inline buffer, the block cannot be passed to realloc, so a
+    new one is allocated and the used elements are copied over instead.
+ */
+static void *realloc_data(tl_array *this, size_t count)
+{
+	void *newdata;
+
+	if (!this->inline_data || this->data != this->inline_data)
+		return realloc(this->data, count * this->unitsize);
+
+	newdata = malloc(count * this->unitsize);
+
+	if (newdata && this->used)
+		memcpy(newdata, this->data, this->used * this->unitsize);
+
+	return newdata;
+}
+
 int tl_array_from_array(tl_array * this, const void *data, size_t count)
 {
 	assert(this && data);
@@ -43,7 +63,9 @@ int tl_array_copy_range(tl_array * this, const tl_array * src,
 		if (!newdata)
 			return 0;
 
-		free(this->data);
+		if (this->data != this->inline_data)
+			free(this->data);
+
 		this->data = newdata;
 		this->reserved = count;
 	}
@@ -95,7 +117,7 @@ int tl_array_resize(tl_array * this, size_t size, int flags)
 	if (size == this->used)
 		return 1;
 
-	if (size < this->reserved) {
+	if (size <= this->reserved) {
 		if (size < this->used) {
 			tl_allocator_cleanup(this->alloc,
 					     (char *)this->data +
@@ -112,11 +134,13 @@ int tl_array_resize(tl_array * this, size_t size, int flags)
 		tl_array_try_shrink(this);
 	} else {
 		/* try to enlarge */
-		newdata = realloc(this->data, size * this->unitsize);
+		newdata = realloc_data(this, size);
 
 		if (!newdata)
 			return 0;
 
+		this->data = newdata;
+
 		/* clear new entries */
 		if (flags & TL_ARRAY_INIT) {
 			tl_allocator_init(this->alloc,
@@ -128,7 +152,6 @@ int tl_array_resize(tl_array * this, size_t size, int flags)
 		/* update array contents */
 		this->reserved = size;
 		this->used = size;
-		this->data = newdata;
 	}
 	return 1;
 }
@@ -144,7 +167,7 @@ int tl_array_reserve(tl_array * this, size_t size)
 		return 1;
 
 	/* try to enlarge the data block */
-	newdata = realloc(this->data, size * this->unitsize);
+	newdata = realloc_data(this, size);
 
 	if (!newdata)
 		return 0;
@@ -300,6 +323,10 @@ void tl_array_try_shrink(tl_array * this)
 
 	assert(this);
 
+	/* the inline buffer is not ours to shrink */
+	if (this->inline_data && this->data == this->inline_data)
+		return;
+
 	if (this->used < this->reserved / 4) {
 		newdata =
 		    realloc(this->data, (this->reserved / 2) * this->unitsize);
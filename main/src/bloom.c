@@ -0,0 +1,233 @@
+/* bloom.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_bloom.h"
+#include "tl_hash.h"
+#include "tl_blob.h"
+#include "util/util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_BITS (TL_BLOOM_BLOCK_WORDS * 64)
+#define BLOCK_BYTES (TL_BLOOM_BLOCK_WORDS * sizeof(tl_u64))
+
+#define MAX_K 16
+
+/* second seed, derived from the filter seed */
+#define SEED2(seed) ((seed) ^ 0x9E3779B9UL)
+
+#define BLOOM_MAGIC "TLBF"
+#define BLOOM_VERSION 1
+#define HEADER_SIZE 32
+
+static int alloc_blocks(tl_bloom *this, size_t blockcount)
+{
+	size_t addr;
+
+	if (blockcount > ((size_t)-1 - BLOCK_BYTES) / BLOCK_BYTES)
+		return 0;
+
+	this->mem = calloc(1, blockcount * BLOCK_BYTES + BLOCK_BYTES);
+	if (!this->mem)
+		return 0;
+
+	addr = (size_t)this->mem;
+	if (addr % BLOCK_BYTES)
+		addr += BLOCK_BYTES - addr % BLOCK_BYTES;
+
+	this->blocks = (tl_u64 *)addr;
+	this->blockcount = blockcount;
+	return 1;
+}
+
+/*
+    The first hash selects the block, using a multiply-shift instead of a
+    modulo. The second one yields a start bit and an odd stride, so the
+    k bits of a key are always distinct within the block.
+ */
+static tl_u64 *get_block(const tl_bloom *this, const void *data, size_t size,
+			 tl_u32 *h2)
+{
+	tl_u64 h1 = tl_hash_murmur3_32(data, size, this->seed);
+
+	*h2 = tl_hash_murmur3_32(data, size, SEED2(this->seed));
+	return this->blocks + ((h1 * this->blockcount) >> 32) *
+			      TL_BLOOM_BLOCK_WORDS;
+}
+
+/****************************************************************************/
+
+int tl_bloom_init(tl_bloom *this, size_t capacity, double fp_rate,
+		  tl_u32 seed)
+{
+	double rate = 1.0, bits;
+	unsigned int k = 0;
+
+	assert(this);
+
+	if (fp_rate <= 0.0 || fp_rate >= 1.0)
+		return 0;
+
+	/* optimal k = log2(1 / fp_rate), m / n = k / ln(2) */
+	while (rate > fp_rate && k < MAX_K) {
+		rate *= 0.5;
+		++k;
+	}
+
+	bits = (double)(capacity ? capacity : 1) * k * 1.4427;
+	bits += bits / 8.0;
+
+	if (bits / BLOCK_BITS >= (double)((size_t)-1 / BLOCK_BYTES))
+		return 0;
+
+	memset(this, 0, sizeof(*this));
+	this->k = k;
+	this->seed = seed;
+
+	return alloc_blocks(this, (size_t)(bits / BLOCK_BITS) + 1);
+}
+
+void tl_bloom_cleanup(tl_bloom *this)
+{
+	assert(this);
+
+	free(this->mem);
+	memset(this, 0, sizeof(*this));
+}
+
+void tl_bloom_clear(tl_bloom *this)
+{
+	assert(this);
+
+	memset(this->blocks, 0, this->blockcount * BLOCK_BYTES);
+	this->count = 0;
+}
+
+void tl_bloom_add(tl_bloom *this, const void *data, size_t size)
+{
+	tl_u32 h2, stride, bit;
+	unsigned int i;
+	tl_u64 *block;
+
+	assert(this && data);
+
+	block = get_block(this, data, size, &h2);
+	stride = (h2 >> 16) | 1;
+
+	for (i = 0, bit = h2; i < this->k; ++i, bit += stride)
+		block[(bit % BLOCK_BITS) / 64] |= (tl_u64)1 << (bit % 64);
+
+	++this->count;
+}
+
+int tl_bloom_contains(const tl_bloom *this, const void *data, size_t size)
+{
+	tl_u32 h2, stride, bit;
+	const tl_u64 *block;
+	unsigned int i;
+	tl_u64 mask;
+
+	assert(this && data);
+
+	block = get_block(this, data, size, &h2);
+	stride = (h2 >> 16) | 1;
+
+	for (i = 0, bit = h2; i < this->k; ++i, bit += stride) {
+		mask = (tl_u64)1 << (bit % 64);
+
+		if (!(block[(bit % BLOCK_BITS) / 64] & mask))
+			return 0;
+	}
+
+	return 1;
+}
+
+int tl_bloom_merge(tl_bloom *this, const tl_bloom *src)
+{
+	size_t i;
+
+	assert(this && src);
+
+	if (this->blockcount != src->blockcount || this->k != src->k ||
+	    this->seed != src->seed) {
+		return 0;
+	}
+
+	for (i = 0; i < this->blockcount * TL_BLOOM_BLOCK_WORDS; ++i)
+		this->blocks[i] |= src->blocks[i];
+
+	this->count += src->count;
+	return 1;
+}
+
+int tl_bloom_serialize(const tl_bloom *this, tl_blob *blob)
+{
+	size_t i, words = this->blockcount * TL_BLOOM_BLOCK_WORDS;
+	unsigned char *ptr;
+
+	assert(this && blob);
+
+	if (!tl_blob_init(blob, HEADER_SIZE + words * 8, NULL))
+		return 0;
+
+	ptr = blob->data;
+	memcpy(ptr, BLOOM_MAGIC, 4);
+	write_le(ptr + 4, BLOOM_VERSION, 4);
+	write_le(ptr + 8, this->k, 4);
+	write_le(ptr + 12, this->seed, 4);
+	write_le(ptr + 16, this->blockcount, 8);
+	write_le(ptr + 24, this->count, 8);
+
+	for (i = 0, ptr += HEADER_SIZE; i < words; ++i, ptr += 8)
+		write_le(ptr, this->blocks[i], 8);
+
+	return 1;
+}
+
+int tl_bloom_deserialize(tl_bloom *this, const tl_blob *blob)
+{
+	const unsigned char *ptr;
+	tl_u64 blockcount, k;
+	size_t i, words;
+
+	assert(this && blob);
+
+	if (blob->size < HEADER_SIZE)
+		return 0;
+
+	ptr = blob->data;
+	if (memcmp(ptr, BLOOM_MAGIC, 4) || read_le(ptr + 4, 4) != BLOOM_VERSION)
+		return 0;
+
+	k = read_le(ptr + 8, 4);
+	blockcount = read_le(ptr + 16, 8);
+
+	if (!k || k > MAX_K || !blockcount)
+		return 0;
+	if (blockcount > (blob->size - HEADER_SIZE) / BLOCK_BYTES)
+		return 0;
+	if (blob->size != HEADER_SIZE + blockcount * BLOCK_BYTES)
+		return 0;
+
+	memset(this, 0, sizeof(*this));
+
+	if (!alloc_blocks(this, blockcount))
+		return 0;
+
+	this->k = k;
+	this->seed = read_le(ptr + 12, 4);
+	this->count = read_le(ptr + 24, 8);
+
+	words = this->blockcount * TL_BLOOM_BLOCK_WORDS;
+
+	for (i = 0, ptr += HEADER_SIZE; i < words; ++i, ptr += 8)
+		this->blocks[i] = read_le(ptr, 8);
+
+	return 1;
+}
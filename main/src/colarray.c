@@ -0,0 +1,416 @@
+/* colarray.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_colarray.h"
+#include "tl_array.h"
+#include "util/util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_RESERVED 16
+
+/* number of rows compared at once, one bit each in a tl_u32 mask */
+#define BLOCK_ROWS 32
+
+#define SCAN_LOOP(expr) \
+	for (i = 0; i < n; ++i) \
+		mask |= (tl_u32)(expr) << i
+
+#define SCAN_BLOCK(T) \
+	do { \
+		const T *p = (const T *)col; \
+		T x = *((const T *)value); \
+		\
+		switch (op) { \
+		case TL_SCAN_LESS: SCAN_LOOP(p[i] < x); break; \
+		case TL_SCAN_LESS_EQUAL: SCAN_LOOP(p[i] <= x); break; \
+		case TL_SCAN_GREATER: SCAN_LOOP(p[i] > x); break; \
+		case TL_SCAN_GREATER_EQUAL: SCAN_LOOP(p[i] >= x); break; \
+		case TL_SCAN_EQUAL: SCAN_LOOP(p[i] == x); break; \
+		default: SCAN_LOOP(p[i] != x); break; \
+		} \
+	} while (0)
+
+static size_t type_size(TL_COLUMN_TYPE type)
+{
+	switch (type) {
+	case TL_COLUMN_U32:
+	case TL_COLUMN_S32:
+	case TL_COLUMN_FLOAT:
+		return 4;
+	default:
+		return 8;
+	}
+}
+
+#ifdef HAVE_SSE2
+static tl_u32 block_mask_32(const char *col, TL_COLUMN_TYPE type,
+			    TL_SCAN_OP op, const void *value)
+{
+	__m128i vi, xi, bias = _mm_set1_epi32((int)0x80000000UL);
+	__m128 vf, xf = _mm_set1_ps(*((const float *)value)), r;
+	tl_u32 mask = 0, m, invert;
+	size_t i;
+
+	/* unsigned compares are signed compares with the top bit flipped */
+	xi = _mm_set1_epi32(*((const int *)value));
+	if (type == TL_COLUMN_U32)
+		xi = _mm_xor_si128(xi, bias);
+
+	invert = (op == TL_SCAN_LESS_EQUAL || op == TL_SCAN_GREATER_EQUAL ||
+		  op == TL_SCAN_NOT_EQUAL) ? 0x0F : 0x00;
+
+	for (i = 0; i < BLOCK_ROWS; i += 4, col += 16) {
+		if (type == TL_COLUMN_FLOAT) {
+			vf = _mm_loadu_ps((const float *)col);
+
+			switch (op) {
+			case TL_SCAN_LESS: r = _mm_cmplt_ps(vf, xf); break;
+			case TL_SCAN_LESS_EQUAL:
+				r = _mm_cmple_ps(vf, xf);
+				break;
+			case TL_SCAN_GREATER: r = _mm_cmpgt_ps(vf, xf); break;
+			case TL_SCAN_GREATER_EQUAL:
+				r = _mm_cmpge_ps(vf, xf);
+				break;
+			case TL_SCAN_EQUAL: r = _mm_cmpeq_ps(vf, xf); break;
+			default: r = _mm_cmpneq_ps(vf, xf); break;
+			}
+
+			m = _mm_movemask_ps(r);
+		} else {
+			vi = _mm_loadu_si128((const __m128i *)col);
+			if (type == TL_COLUMN_U32)
+				vi = _mm_xor_si128(vi, bias);
+
+			switch (op) {
+			case TL_SCAN_LESS:
+			case TL_SCAN_GREATER_EQUAL:
+				vi = _mm_cmplt_epi32(vi, xi);
+				break;
+			case TL_SCAN_GREATER:
+			case TL_SCAN_LESS_EQUAL:
+				vi = _mm_cmpgt_epi32(vi, xi);
+				break;
+			default:
+				vi = _mm_cmpeq_epi32(vi, xi);
+				break;
+			}
+
+			m = _mm_movemask_ps(_mm_castsi128_ps(vi)) ^ invert;
+		}
+
+		mask |= m << i;
+	}
+
+	return mask;
+}
+
+static tl_u32 block_mask_double(const char *col, TL_SCAN_OP op,
+				const void *value)
+{
+	__m128d v, x = _mm_set1_pd(*((const double *)value)), r;
+	tl_u32 mask = 0;
+	size_t i;
+
+	for (i = 0; i < BLOCK_ROWS; i += 2, col += 16) {
+		v = _mm_loadu_pd((const double *)col);
+
+		switch (op) {
+		case TL_SCAN_LESS: r = _mm_cmplt_pd(v, x); break;
+		case TL_SCAN_LESS_EQUAL: r = _mm_cmple_pd(v, x); break;
+		case TL_SCAN_GREATER: r = _mm_cmpgt_pd(v, x); break;
+		case TL_SCAN_GREATER_EQUAL: r = _mm_cmpge_pd(v, x); break;
+		case TL_SCAN_EQUAL: r = _mm_cmpeq_pd(v, x); break;
+		default: r = _mm_cmpneq_pd(v, x); break;
+		}
+
+		mask |= (tl_u32)_mm_movemask_pd(r) << i;
+	}
+
+	return mask;
+}
+#endif
+
+/* compare up to BLOCK_ROWS entries, returning a bit mask of the matches */
+static tl_u32 block_mask(const char *col, size_t n, TL_COLUMN_TYPE type,
+			 TL_SCAN_OP op, const void *value)
+{
+	tl_u32 mask = 0;
+	size_t i;
+
+#ifdef HAVE_SSE2
+	if (n == BLOCK_ROWS) {
+		if (type == TL_COLUMN_U32 || type == TL_COLUMN_S32 ||
+		    type == TL_COLUMN_FLOAT) {
+			return block_mask_32(col, type, op, value);
+		}
+
+		if (type == TL_COLUMN_DOUBLE)
+			return block_mask_double(col, op, value);
+	}
+#endif
+
+	switch (type) {
+	case TL_COLUMN_U32: SCAN_BLOCK(tl_u32); break;
+	case TL_COLUMN_S32: SCAN_BLOCK(tl_s32); break;
+	case TL_COLUMN_U64: SCAN_BLOCK(tl_u64); break;
+	case TL_COLUMN_S64: SCAN_BLOCK(tl_s64); break;
+	case TL_COLUMN_FLOAT: SCAN_BLOCK(float); break;
+	default: SCAN_BLOCK(double); break;
+	}
+
+	return mask;
+}
+
+static int grow(tl_colarray *this, size_t size)
+{
+	size_t newsize, i;
+	char *new;
+
+	newsize = this->reserved ? this->reserved : MIN_RESERVED;
+
+	while (newsize < size) {
+		if ((newsize * 2) < newsize)
+			return 0;
+		newsize *= 2;
+	}
+
+	for (i = 0; i < this->colcount; ++i) {
+		if (((newsize * this->fields[i].size) /
+		     this->fields[i].size) != newsize) {
+			return 0;
+		}
+	}
+
+	/* columns that were already enlarged simply stay larger on failure */
+	for (i = 0; i < this->colcount; ++i) {
+		new = realloc(this->columns[i],
+			      newsize * this->fields[i].size);
+		if (!new)
+			return 0;
+
+		this->columns[i] = new;
+	}
+
+	this->reserved = newsize;
+	return 1;
+}
+
+static void scatter(tl_colarray *this, size_t idx, const char *record)
+{
+	const tl_colarray_field *f;
+	size_t i;
+
+	for (i = 0; i < this->colcount; ++i) {
+		f = this->fields + i;
+
+		memcpy(this->columns[i] + idx * f->size, record + f->offset,
+		       f->size);
+	}
+}
+
+/****************************************************************************/
+
+int tl_colarray_init(tl_colarray *this, const tl_colarray_field *fields,
+		     size_t count)
+{
+	assert(this && fields && count);
+
+	memset(this, 0, sizeof(*this));
+
+	this->fields = malloc(count * sizeof(fields[0]));
+	this->columns = calloc(count, sizeof(this->columns[0]));
+
+	if (!this->fields || !this->columns) {
+		free(this->fields);
+		free(this->columns);
+		return 0;
+	}
+
+	memcpy(this->fields, fields, count * sizeof(fields[0]));
+	this->colcount = count;
+	return 1;
+}
+
+void tl_colarray_cleanup(tl_colarray *this)
+{
+	size_t i;
+
+	assert(this);
+
+	for (i = 0; i < this->colcount; ++i)
+		free(this->columns[i]);
+
+	free(this->columns);
+	free(this->fields);
+
+	memset(this, 0, sizeof(*this));
+}
+
+int tl_colarray_reserve(tl_colarray *this, size_t size)
+{
+	assert(this);
+
+	return size <= this->reserved ? 1 : grow(this, size);
+}
+
+int tl_colarray_append(tl_colarray *this, const void *record)
+{
+	assert(this && record);
+
+	if (this->used == this->reserved && !grow(this, this->used + 1))
+		return 0;
+
+	scatter(this, this->used++, record);
+	return 1;
+}
+
+int tl_colarray_append_array(tl_colarray *this, const void *records,
+			     size_t recordsize, size_t count)
+{
+	const char *ptr = records;
+	size_t i;
+
+	assert(this && records);
+
+	if ((this->used + count) < this->used)
+		return 0;
+
+	if (!tl_colarray_reserve(this, this->used + count))
+		return 0;
+
+	for (i = 0; i < count; ++i, ptr += recordsize)
+		scatter(this, this->used++, ptr);
+
+	return 1;
+}
+
+int tl_colarray_get(const tl_colarray *this, size_t idx, void *record)
+{
+	const tl_colarray_field *f;
+	size_t i;
+
+	assert(this && record);
+
+	if (idx >= this->used)
+		return 0;
+
+	for (i = 0; i < this->colcount; ++i) {
+		f = this->fields + i;
+
+		memcpy((char *)record + f->offset,
+		       this->columns[i] + idx * f->size, f->size);
+	}
+
+	return 1;
+}
+
+int tl_colarray_set(tl_colarray *this, size_t idx, const void *record)
+{
+	assert(this && record);
+
+	if (idx >= this->used)
+		return 0;
+
+	scatter(this, idx, record);
+	return 1;
+}
+
+void tl_colarray_remove(tl_colarray *this, size_t idx, size_t count)
+{
+	size_t i, size;
+
+	assert(this);
+
+	if (idx >= this->used)
+		return;
+
+	if ((idx + count) > this->used || (idx + count) < idx)
+		count = this->used - idx;
+
+	for (i = 0; i < this->colcount; ++i) {
+		size = this->fields[i].size;
+
+		memmove(this->columns[i] + idx * size,
+			this->columns[i] + (idx + count) * size,
+			(this->used - idx - count) * size);
+	}
+
+	this->used -= count;
+}
+
+int tl_colarray_scan(const tl_colarray *this, size_t col,
+		     TL_COLUMN_TYPE type, TL_SCAN_OP op, const void *value,
+		     tl_array *out)
+{
+	size_t base, n, *dst;
+	const char *ptr;
+	tl_u32 mask;
+
+	assert(this && value && out && col < this->colcount);
+	assert(this->fields[col].size == type_size(type));
+	assert(out->unitsize == sizeof(size_t));
+
+	ptr = this->columns[col];
+
+	for (base = 0; base < this->used; base += n) {
+		n = this->used - base;
+		if (n > BLOCK_ROWS)
+			n = BLOCK_ROWS;
+
+		mask = block_mask(ptr + base * this->fields[col].size, n,
+				  type, op, value);
+
+		if ((out->reserved - out->used) < BLOCK_ROWS &&
+		    !tl_array_reserve(out, 2 * out->reserved + BLOCK_ROWS)) {
+			return 0;
+		}
+
+		dst = (size_t *)out->data + out->used;
+
+		while (mask) {
+			*(dst++) = base + lowest_bit(mask);
+			mask &= mask - 1;
+		}
+
+		out->used = dst - (size_t *)out->data;
+	}
+
+	return 1;
+}
+
+void tl_colarray_filter(const tl_colarray *this, size_t col,
+			TL_COLUMN_TYPE type, TL_SCAN_OP op,
+			const void *value, tl_array *indices)
+{
+	size_t i, count = 0, idx, *list;
+	const char *ptr;
+
+	assert(this && value && indices && col < this->colcount);
+	assert(this->fields[col].size == type_size(type));
+	assert(indices->unitsize == sizeof(size_t));
+
+	list = indices->data;
+
+	for (i = 0; i < indices->used; ++i) {
+		idx = list[i];
+
+		if (idx >= this->used)
+			continue;
+
+		ptr = this->columns[col] + idx * this->fields[col].size;
+
+		if (block_mask(ptr, 1, type, op, value))
+			list[count++] = idx;
+	}
+
+	indices->used = count;
+	tl_array_try_shrink(indices);
+}
@@ -0,0 +1,291 @@
+/* deque.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_allocator.h"
+#include "tl_deque.h"
+
+#include <stdlib.h>
+
+#define MIN_RESERVED 8
+
+static char *get_slot(const tl_deque *this, size_t idx)
+{
+	idx = (this->head + idx) & (this->reserved - 1);
+	return (char *)this->data + idx * this->unitsize;
+}
+
+/*
+    Grow the buffer to a power of two that can hold at least count elements.
+    If the elements wrap around, the smaller of the two segments is moved so
+    that they form one ring in the new buffer again.
+ */
+static int grow(tl_deque *this, size_t count)
+{
+	size_t newsize, front, back;
+	char *newdata;
+
+	newsize = this->reserved ? this->reserved : MIN_RESERVED;
+
+	while (newsize < count) {
+		if ((newsize * 2) < newsize)
+			return 0;
+		newsize *= 2;
+	}
+
+	if (newsize == this->reserved)
+		return 1;
+
+	if (((newsize * this->unitsize) / this->unitsize) != newsize)
+		return 0;
+
+	newdata = realloc(this->data, newsize * this->unitsize);
+	if (!newdata)
+		return 0;
+
+	if (this->head + this->used > this->reserved) {
+		front = this->reserved - this->head;
+		back = this->used - front;
+
+		if (back <= front) {
+			memcpy(newdata + this->reserved * this->unitsize,
+			       newdata, back * this->unitsize);
+		} else {
+			memcpy(newdata + (newsize - front) * this->unitsize,
+			       newdata + this->head * this->unitsize,
+			       front * this->unitsize);
+			this->head = newsize - front;
+		}
+	}
+
+	this->data = newdata;
+	this->reserved = newsize;
+	return 1;
+}
+
+static void cleanup_range(tl_deque *this, size_t idx, size_t count)
+{
+	size_t run;
+	void *ptr;
+
+	while (count) {
+		ptr = tl_deque_get_segment(this, idx, &run);
+		if (run > count)
+			run = count;
+
+		tl_allocator_cleanup(this->alloc, ptr, this->unitsize, run);
+		idx += run;
+		count -= run;
+	}
+}
+
+static void copy_out(const tl_deque *this, size_t idx, char *dst,
+		     size_t count)
+{
+	size_t run;
+	void *ptr;
+
+	while (count) {
+		ptr = tl_deque_get_segment(this, idx, &run);
+		if (run > count)
+			run = count;
+
+		memcpy(dst, ptr, run * this->unitsize);
+		dst += run * this->unitsize;
+		idx += run;
+		count -= run;
+	}
+}
+
+/****************************************************************************/
+
+void tl_deque_cleanup(tl_deque *this)
+{
+	assert(this);
+
+	cleanup_range(this, 0, this->used);
+	free(this->data);
+
+	memset(this, 0, sizeof(*this));
+}
+
+void tl_deque_clear(tl_deque *this)
+{
+	assert(this);
+
+	cleanup_range(this, 0, this->used);
+	this->used = 0;
+	this->head = 0;
+}
+
+int tl_deque_reserve(tl_deque *this, size_t size)
+{
+	assert(this);
+
+	return size <= this->reserved ? 1 : grow(this, size);
+}
+
+int tl_deque_append(tl_deque *this, const void *element)
+{
+	assert(this && element);
+
+	if (this->used == this->reserved && !grow(this, this->used + 1))
+		return 0;
+
+	this->used += 1;
+	tl_allocator_copy(this->alloc, get_slot(this, this->used - 1),
+			  element, this->unitsize, 1);
+	return 1;
+}
+
+int tl_deque_prepend(tl_deque *this, const void *element)
+{
+	assert(this && element);
+
+	if (this->used == this->reserved && !grow(this, this->used + 1))
+		return 0;
+
+	this->head = (this->head - 1) & (this->reserved - 1);
+	this->used += 1;
+
+	tl_allocator_copy(this->alloc, get_slot(this, 0), element,
+			  this->unitsize, 1);
+	return 1;
+}
+
+int tl_deque_append_array(tl_deque *this, const void *data, size_t count)
+{
+	const char *src = data;
+	size_t idx, run;
+	void *ptr;
+
+	assert(this && data);
+
+	if ((this->used + count) < this->used)
+		return 0;
+
+	if (!tl_deque_reserve(this, this->used + count))
+		return 0;
+
+	idx = this->used;
+	this->used += count;
+
+	while (count) {
+		ptr = tl_deque_get_segment(this, idx, &run);
+		if (run > count)
+			run = count;
+
+		tl_allocator_copy(this->alloc, ptr, src, this->unitsize, run);
+		src += run * this->unitsize;
+		idx += run;
+		count -= run;
+	}
+	return 1;
+}
+
+void tl_deque_remove_first(tl_deque *this)
+{
+	assert(this);
+
+	if (this->used) {
+		tl_allocator_cleanup(this->alloc, get_slot(this, 0),
+				     this->unitsize, 1);
+
+		this->head = (this->head + 1) & (this->reserved - 1);
+		this->used -= 1;
+	}
+}
+
+void tl_deque_remove_last(tl_deque *this)
+{
+	assert(this);
+
+	if (this->used) {
+		tl_allocator_cleanup(this->alloc,
+				     get_slot(this, this->used - 1),
+				     this->unitsize, 1);
+		this->used -= 1;
+	}
+}
+
+void tl_deque_remove(tl_deque *this, size_t idx, size_t count)
+{
+	size_t i;
+
+	assert(this);
+
+	if (idx >= this->used)
+		return;
+
+	if ((idx + count) > this->used || (idx + count) < idx)
+		count = this->used - idx;
+
+	cleanup_range(this, idx, count);
+
+	if (idx < (this->used - idx - count)) {
+		/* move the elements in front of the range back */
+		for (i = idx; i > 0; --i) {
+			memcpy(get_slot(this, i - 1 + count),
+			       get_slot(this, i - 1), this->unitsize);
+		}
+
+		this->head = (this->head + count) & (this->reserved - 1);
+	} else {
+		/* move the elements after the range forward */
+		for (i = idx + count; i < this->used; ++i) {
+			memcpy(get_slot(this, i - count), get_slot(this, i),
+			       this->unitsize);
+		}
+	}
+
+	this->used -= count;
+}
+
+size_t tl_deque_drop_first(tl_deque *this, void *data, size_t count)
+{
+	assert(this && data);
+
+	if (count > this->used)
+		count = this->used;
+
+	if (count) {
+		copy_out(this, 0, data, count);
+
+		this->head = (this->head + count) & (this->reserved - 1);
+		this->used -= count;
+	}
+
+	return count;
+}
+
+size_t tl_deque_drop_last(tl_deque *this, void *data, size_t count)
+{
+	assert(this && data);
+
+	if (count > this->used)
+		count = this->used;
+
+	copy_out(this, this->used - count, data, count);
+	this->used -= count;
+	return count;
+}
+
+void tl_deque_to_array(const tl_deque *this, void *data)
+{
+	char *dst = data;
+	size_t idx, run;
+	void *ptr;
+
+	assert(this && data);
+
+	for (idx = 0; idx < this->used; idx += run) {
+		ptr = tl_deque_get_segment(this, idx, &run);
+
+		tl_allocator_copy(this->alloc, dst, ptr, this->unitsize, run);
+		dst += run * this->unitsize;
+	}
+}
@@ -0,0 +1,415 @@
+/* flatmap.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_allocator.h"
+#include "tl_flatmap.h"
+#include "util/util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GROUP_WIDTH 16
+
+/* control byte values, used slots store 7 bits of the hash (0x00-0x7F) */
+#define CTRL_EMPTY 0x80
+#define CTRL_DELETED 0xFE
+
+#define IS_FULL(c) (((c) & 0x80) == 0)
+
+/****************************************************************************/
+
+static unsigned int group_match(const tl_u8 *grp, tl_u8 value)
+{
+#ifdef HAVE_SSE2
+	__m128i g = _mm_loadu_si128((const __m128i *)grp);
+	__m128i v = _mm_set1_epi8((char)value);
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(g, v));
+#else
+	unsigned int i, mask = 0;
+
+	for (i = 0; i < GROUP_WIDTH; ++i) {
+		if (grp[i] == value)
+			mask |= 1U << i;
+	}
+	return mask;
+#endif
+}
+
+static unsigned int group_match_free(const tl_u8 *grp)
+{
+#ifdef HAVE_SSE2
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)grp));
+#else
+	unsigned int i, mask = 0;
+
+	for (i = 0; i < GROUP_WIDTH; ++i) {
+		if (!IS_FULL(grp[i]))
+			mask |= 1U << i;
+	}
+	return mask;
+#endif
+}
+
+/*
+    The user supplied hash function might be weak (e.g. identity on integers),
+    so the bits are mixed up with the MurmurHash3 finalizer before splitting
+    them into the probe position and the 7 bits stored in the control byte.
+ */
+static tl_u64 get_hash(const tl_flatmap *this, const void *key)
+{
+	return mix64(this->hash(key));
+}
+
+static size_t max_fill(size_t bincount)
+{
+	return bincount - bincount / 8;
+}
+
+static char *get_slot(const tl_flatmap *this, size_t idx)
+{
+	return this->slots + idx * this->slotsize;
+}
+
+static int alloc_table(tl_flatmap *this, size_t bincount)
+{
+	this->ctrl = malloc(bincount);
+	if (!this->ctrl)
+		return 0;
+
+	this->slots = malloc(bincount * this->slotsize);
+	if (!this->slots) {
+		free(this->ctrl);
+		return 0;
+	}
+
+	memset(this->ctrl, CTRL_EMPTY, bincount);
+	this->bincount = bincount;
+	this->growth_left = max_fill(bincount);
+	return 1;
+}
+
+/* returns the slot index of a key, or bincount if not found */
+static size_t find_slot(const tl_flatmap *this, const void *key, tl_u64 h)
+{
+	size_t mask = this->bincount - 1, pos, step = 0;
+	tl_u8 tag = h & 0x7F;
+	unsigned int match;
+	const tl_u8 *grp;
+
+	pos = (size_t)(h >> 7) & mask & ~(size_t)(GROUP_WIDTH - 1);
+
+	for (;;) {
+		grp = this->ctrl + pos;
+		match = group_match(grp, tag);
+
+		while (match) {
+			if (!this->compare(get_slot(this, pos +
+						    lowest_bit(match)), key)) {
+				return pos + lowest_bit(match);
+			}
+			match &= match - 1;
+		}
+
+		if (group_match(grp, CTRL_EMPTY))
+			return this->bincount;
+
+		/* triangular probing visits every group exactly once */
+		step += GROUP_WIDTH;
+		pos = (pos + step) & mask;
+
+		if (step >= this->bincount)
+			return this->bincount;
+	}
+}
+
+/* returns the first empty or deleted slot in the probe sequence of a hash */
+static size_t find_free(const tl_flatmap *this, tl_u64 h)
+{
+	size_t mask = this->bincount - 1, pos, step = 0;
+	unsigned int match;
+
+	pos = (size_t)(h >> 7) & mask & ~(size_t)(GROUP_WIDTH - 1);
+
+	for (;;) {
+		match = group_match_free(this->ctrl + pos);
+
+		if (match)
+			return pos + lowest_bit(match);
+
+		step += GROUP_WIDTH;
+		pos = (pos + step) & mask;
+	}
+}
+
+static int rehash(tl_flatmap *this)
+{
+	size_t i, idx, bincount;
+	tl_flatmap old;
+	tl_u64 h;
+
+	bincount = this->bincount;
+
+	/* only grow if the map is actually filled, not just full of tombs */
+	if (this->count >= max_fill(bincount) / 2)
+		bincount *= 2;
+
+	memcpy(&old, this, sizeof(old));
+
+	if (!alloc_table(this, bincount)) {
+		memcpy(this, &old, sizeof(old));
+		return 0;
+	}
+
+	for (i = 0; i < old.bincount; ++i) {
+		if (!IS_FULL(old.ctrl[i]))
+			continue;
+
+		h = get_hash(this, get_slot(&old, i));
+		idx = find_free(this, h);
+
+		this->ctrl[idx] = h & 0x7F;
+		memcpy(get_slot(this, idx), get_slot(&old, i),
+		       this->slotsize);
+	}
+
+	this->growth_left -= this->count;
+
+	free(old.ctrl);
+	free(old.slots);
+	return 1;
+}
+
+static void free_entries(tl_flatmap *this)
+{
+	char *ptr;
+	size_t i;
+
+	if (!this->keyalloc && !this->objalloc)
+		return;
+
+	for (i = 0; i < this->bincount; ++i) {
+		if (!IS_FULL(this->ctrl[i]))
+			continue;
+
+		ptr = get_slot(this, i);
+		tl_allocator_cleanup(this->keyalloc, ptr, this->keysize, 1);
+
+		ptr += this->keysize_padded;
+		tl_allocator_cleanup(this->objalloc, ptr, this->objsize, 1);
+	}
+}
+
+/****************************************************************************/
+
+int tl_flatmap_init(tl_flatmap *this, size_t keysize, size_t objsize,
+		    size_t bincount, tl_hash keyhash, tl_compare keycompare,
+		    tl_allocator *keyalloc, tl_allocator *valalloc)
+{
+	size_t slotsize, keysize_padded, count;
+
+	assert(this && keysize && objsize);
+	assert(keyhash && keycompare);
+
+	keysize_padded = keysize;
+	if (keysize % sizeof(void*))
+		keysize_padded += sizeof(void*) - keysize % sizeof(void*);
+
+	slotsize = keysize_padded + objsize;
+	if (slotsize % sizeof(void*))
+		slotsize += sizeof(void*) - slotsize % sizeof(void*);
+
+	for (count = GROUP_WIDTH; count < bincount; count *= 2) {
+		if ((count * 2) < count)
+			return 0;
+	}
+
+	memset(this, 0, sizeof(*this));
+	this->keysize = keysize;
+	this->keysize_padded = keysize_padded;
+	this->objsize = objsize;
+	this->slotsize = slotsize;
+	this->hash = keyhash;
+	this->compare = keycompare;
+	this->keyalloc = keyalloc;
+	this->objalloc = valalloc;
+
+	return alloc_table(this, count);
+}
+
+void tl_flatmap_cleanup(tl_flatmap *this)
+{
+	assert(this);
+
+	free_entries(this);
+	free(this->ctrl);
+	free(this->slots);
+
+	memset(this, 0, sizeof(*this));
+}
+
+int tl_flatmap_copy(tl_flatmap *this, const tl_flatmap *src)
+{
+	tl_flatmap cpy;
+	const char *sptr;
+	char *dptr;
+	size_t i;
+
+	assert(this && src);
+
+	memcpy(&cpy, src, sizeof(cpy));
+
+	if (!alloc_table(&cpy, src->bincount))
+		return 0;
+
+	memcpy(cpy.ctrl, src->ctrl, src->bincount);
+	cpy.growth_left = src->growth_left;
+
+	for (i = 0; i < src->bincount; ++i) {
+		if (!IS_FULL(src->ctrl[i]))
+			continue;
+
+		sptr = get_slot(src, i);
+		dptr = get_slot(&cpy, i);
+
+		tl_allocator_copy(cpy.keyalloc, dptr, sptr, cpy.keysize, 1);
+
+		sptr += cpy.keysize_padded;
+		dptr += cpy.keysize_padded;
+		tl_allocator_copy(cpy.objalloc, dptr, sptr, cpy.objsize, 1);
+	}
+
+	tl_flatmap_cleanup(this);
+	memcpy(this, &cpy, sizeof(cpy));
+	return 1;
+}
+
+void tl_flatmap_clear(tl_flatmap *this)
+{
+	assert(this);
+
+	free_entries(this);
+	memset(this->ctrl, CTRL_EMPTY, this->bincount);
+
+	this->count = 0;
+	this->growth_left = max_fill(this->bincount);
+}
+
+int tl_flatmap_insert(tl_flatmap *this, const void *key, const void *object)
+{
+	size_t idx;
+	char *ptr;
+	tl_u64 h;
+
+	assert(this && key && object);
+
+	h = get_hash(this, key);
+	idx = find_slot(this, key, h);
+
+	if (idx < this->bincount) {
+		ptr = get_slot(this, idx) + this->keysize_padded;
+		tl_allocator_cleanup(this->objalloc, ptr, this->objsize, 1);
+		tl_allocator_copy(this->objalloc, ptr, object,
+				  this->objsize, 1);
+		return 1;
+	}
+
+	idx = find_free(this, h);
+
+	if (this->ctrl[idx] == CTRL_EMPTY && !this->growth_left) {
+		if (!rehash(this))
+			return 0;
+		idx = find_free(this, h);
+	}
+
+	if (this->ctrl[idx] == CTRL_EMPTY)
+		--this->growth_left;
+
+	this->ctrl[idx] = h & 0x7F;
+	++this->count;
+
+	ptr = get_slot(this, idx);
+	tl_allocator_copy(this->keyalloc, ptr, key, this->keysize, 1);
+
+	ptr += this->keysize_padded;
+	tl_allocator_copy(this->objalloc, ptr, object, this->objsize, 1);
+	return 1;
+}
+
+int tl_flatmap_set(tl_flatmap *this, const void *key, const void *object)
+{
+	void *ptr;
+
+	assert(this && key && object);
+
+	ptr = tl_flatmap_at(this, key);
+
+	if (ptr) {
+		tl_allocator_cleanup(this->objalloc, ptr, this->objsize, 1);
+		tl_allocator_copy(this->objalloc, ptr, object, this->objsize,
+				  1);
+		return 1;
+	}
+
+	return 0;
+}
+
+void *tl_flatmap_at(const tl_flatmap *this, const void *key)
+{
+	size_t idx;
+
+	assert(this && key);
+
+	idx = find_slot(this, key, get_hash(this, key));
+
+	if (idx >= this->bincount)
+		return NULL;
+
+	return get_slot(this, idx) + this->keysize_padded;
+}
+
+int tl_flatmap_remove(tl_flatmap *this, const void *key, void *object)
+{
+	size_t idx, grp;
+	char *ptr;
+
+	assert(this && key);
+
+	idx = find_slot(this, key, get_hash(this, key));
+
+	if (idx >= this->bincount)
+		return 0;
+
+	ptr = get_slot(this, idx);
+	tl_allocator_cleanup(this->keyalloc, ptr, this->keysize, 1);
+
+	ptr += this->keysize_padded;
+
+	if (object) {
+		memcpy(object, ptr, this->objsize);
+	} else {
+		tl_allocator_cleanup(this->objalloc, ptr, this->objsize, 1);
+	}
+
+	/*
+	    If the group still has empty slots, no probe sequence ever continued
+	    past it and the slot can be marked empty again. Otherwise, lookups
+	    must not stop here, so a tombstone is left behind.
+	 */
+	grp = idx & ~(size_t)(GROUP_WIDTH - 1);
+
+	if (group_match(this->ctrl + grp, CTRL_EMPTY)) {
+		this->ctrl[idx] = CTRL_EMPTY;
+		++this->growth_left;
+	} else {
+		this->ctrl[idx] = CTRL_DELETED;
+	}
+
+	--this->count;
+	return 1;
+}
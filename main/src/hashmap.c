@@ -7,11 +7,33 @@
  */
 #define TL_EXPORT
 #include "tl_allocator.h"
-#include "tl_hashmap.h"
+#include "hashmap/hashmap.h"
+#include "util/util.h"
 
 #include <stdlib.h>
 #include <string.h>
-#include <limits.h>
+
+/* number of non-empty bins moved to the new table per growing step */
+#define GROW_STEP_BINS 4
+
+/*
+    maximum number of empty bins skipped in a single growing step, empty bins
+    are skipped an entire bitmap word at a time
+ */
+#define GROW_STEP_EMPTY (64 * GROW_STEP_BINS)
+
+/* number of overflow entries in the first and largest pool block */
+#define POOL_MIN_ENTRIES 16
+#define POOL_MAX_ENTRIES 4096
+
+/* number of keys hashed and prefetched ahead in the batch functions */
+#define BATCH_SIZE 16
+
+#ifdef __GNUC__
+	#define PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+	#define PREFETCH(ptr)
+#endif
 
 typedef struct {
 	size_t idx;
@@ -19,54 +41,537 @@ typedef struct {
 	tl_hashmap_entry *ent;
 } entrydata;
 
+/* the overflow entries and number of entries added to a bulk fill range */
+typedef struct {
+	pool_block *block;
+	size_t count;
+} bulk_range;
+
+/* state of a bulk fill, keeping the previous table around until commit */
+typedef struct {
+	char *bins;
+	int *bitmap;
+	size_t bincount;
+
+	size_t width;
+	size_t count;
+	bulk_range range[1];
+} bulk_state;
+
+static void stats_add_bins(const tl_hashmap *this, tl_hashmap_stats *stats,
+			   const char *bins, const int *bitmap,
+			   size_t bincount)
+{
+	const tl_hashmap_entry *it;
+	size_t i, len;
+
+	stats->bincount += bincount;
+
+	for (i = hashmap_find_used(bitmap, 0, bincount); i < bincount;
+	     i = hashmap_find_used(bitmap, i + 1, bincount)) {
+		it = (const tl_hashmap_entry *)(bins + i * this->binsize);
+
+		for (len = 0; it != NULL; it = it->next)
+			++len;
+
+		if (len > stats->longest_chain)
+			stats->longest_chain = len;
+
+		if (len >= TL_HASHMAP_HISTOGRAM_SIZE)
+			len = TL_HASHMAP_HISTOGRAM_SIZE - 1;
+
+		stats->chain_histogram[len] += 1;
+		stats->used_bins += 1;
+	}
+}
+
 static void get_entry_data(const tl_hashmap *this, entrydata *ent,
-			   const void *key)
+			   char *bins, const int *bitmap, size_t bincount,
+			   unsigned long hash)
 {
-	size_t offset;
+	ent->idx = hash % bincount;
+	ent->ent = (tl_hashmap_entry *)(bins + ent->idx * this->binsize);
+	ent->used = IS_USED(bitmap, ent->idx);
+}
+
+/* the overflow entries are released in bulk with the pool afterwards */
+static void free_bins(tl_hashmap *this, char *bins, const int *bitmap,
+		      size_t bincount)
+{
+	tl_hashmap_entry *it;
+	char *ptr, *entry;
+	size_t i;
+
+	if (!this->keyalloc && !this->objalloc)
+		return;
+
+	for (i = hashmap_find_used(bitmap, 0, bincount); i < bincount;
+	     i = hashmap_find_used(bitmap, i + 1, bincount)) {
+		ptr = bins + i * this->binsize;
 
-	ent->idx = this->hash(key) % this->bincount;
+		for (it = (tl_hashmap_entry *)ptr; it != NULL; it = it->next) {
+			entry = (char *)it + sizeof(tl_hashmap_entry);
+			tl_allocator_cleanup(this->keyalloc, entry,
+					     this->keysize, 1);
 
-	offset = ent->idx * this->binsize;
+			entry += this->keysize_padded;
+			tl_allocator_cleanup(this->objalloc, entry,
+					     this->objsize, 1);
+		}
+	}
+}
 
-	ent->ent = (tl_hashmap_entry *)((char *)this->bins + offset);
-	ent->used = this->bitmap[ent->idx / (sizeof(int) * CHAR_BIT)];
-	ent->used &= 1 << (ent->idx % (sizeof(int) * CHAR_BIT));
+static void finish_grow(tl_hashmap *this)
+{
+	free(this->old_bitmap);
+	free(this->old_bins);
+	this->old_bins = NULL;
+	this->old_bitmap = NULL;
+	this->old_bincount = 0;
+	this->rehash_idx = 0;
 }
 
 static void free_hashmap(tl_hashmap *this)
 {
-	tl_hashmap_entry *it, *old;
-	char *ptr, *entry;
+	free_bins(this, this->bins, this->bitmap, this->bincount);
+
+	if (this->old_bins) {
+		free_bins(this, this->old_bins, this->old_bitmap,
+			  this->old_bincount);
+		finish_grow(this);
+	}
+
+	hashmap_pool_cleanup(this);
+}
+
+static int copy_bins(tl_hashmap *this, char *dbins, int *dbitmap,
+		     const char *sbins, const int *sbitmap, size_t bincount)
+{
+	tl_hashmap_entry *sit, *dit;
+	char *sptr, *dptr;
 	size_t i;
-	int used;
 
-	ptr = (char *)this->bins;
+	for (i = hashmap_find_used(sbitmap, 0, bincount); i < bincount;
+	     i = hashmap_find_used(sbitmap, i + 1, bincount)) {
+		dit = (tl_hashmap_entry *)(dbins + i * this->binsize);
+		sit = (tl_hashmap_entry *)(sbins + i * this->binsize);
+
+		SET_USED(dbitmap, i);
+
+		for (; sit != NULL; sit = sit->next, dit = dit->next) {
+			dptr = (char *)dit + sizeof(tl_hashmap_entry);
+			sptr = (char *)sit + sizeof(tl_hashmap_entry);
+
+			dit->hash = sit->hash;
+
+			tl_allocator_copy(this->keyalloc, dptr, sptr,
+					  this->keysize, 1);
+			sptr += this->keysize_padded;
+			dptr += this->keysize_padded;
+
+			tl_allocator_copy(this->objalloc, dptr, sptr,
+					  this->objsize, 1);
+
+			if (sit->next) {
+				dit->next = hashmap_entry_alloc(this);
+				if (!dit->next)
+					return 0;
+				dit->next->next = NULL;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/* append an entry to the end of a chain, so older duplicates stay behind */
+static void chain_append(tl_hashmap_entry *head, tl_hashmap_entry *ent)
+{
+	while (head->next != NULL)
+		head = head->next;
+
+	ent->next = NULL;
+	head->next = ent;
+}
+
+/* move all entries of a bin in the old table over to the new table */
+static int move_bin(tl_hashmap *this, size_t idx)
+{
+	tl_hashmap_entry *head, *it, *next, *dst, *node = NULL;
+	size_t newidx;
+
+	head = (tl_hashmap_entry *)(this->old_bins + idx * this->binsize);
+
+	/* the bin head is stored inline, it might need a separate node */
+	newidx = head->hash % this->bincount;
+
+	if (IS_USED(this->bitmap, newidx)) {
+		node = hashmap_entry_alloc(this);
+		if (!node)
+			return 0;
+	}
+
+	next = head->next;
+	dst = (tl_hashmap_entry *)(this->bins + newidx * this->binsize);
+
+	if (node) {
+		memcpy(node, head, this->binsize);
+		chain_append(dst, node);
+	} else {
+		memcpy(dst, head, this->binsize);
+		dst->next = NULL;
+		SET_USED(this->bitmap, newidx);
+	}
+
+	/* chain nodes can simply be relinked or copied into an empty bin */
+	for (it = next; it != NULL; it = next) {
+		next = it->next;
+
+		newidx = it->hash % this->bincount;
+		dst = (tl_hashmap_entry *)(this->bins +
+					   newidx * this->binsize);
+
+		if (IS_USED(this->bitmap, newidx)) {
+			chain_append(dst, it);
+		} else {
+			memcpy(dst, it, this->binsize);
+			dst->next = NULL;
+			SET_USED(this->bitmap, newidx);
+			hashmap_entry_free(this, it);
+		}
+	}
+
+	CLEAR_USED(this->old_bitmap, idx);
+	return 1;
+}
+
+/* move a few bins of the old table over, returns zero if out of memory */
+static int grow_step(tl_hashmap *this, size_t bins, size_t empty)
+{
+	size_t idx, end;
+
+	while (this->rehash_idx < this->old_bincount && bins && empty) {
+		end = this->old_bincount;
+		if (end - this->rehash_idx > empty)
+			end = this->rehash_idx + empty;
+
+		idx = hashmap_find_used(this->old_bitmap,
+					this->rehash_idx, end);
+		empty -= idx - this->rehash_idx;
+		this->rehash_idx = idx;
+
+		if (idx == end)
+			continue;
+
+		if (!move_bin(this, idx))
+			return 0;
+
+		--bins;
+		++this->rehash_idx;
+	}
+
+	if (this->rehash_idx >= this->old_bincount)
+		finish_grow(this);
+
+	return 1;
+}
+
+static void start_grow(tl_hashmap *this)
+{
+	size_t mapcount, bincount;
+	int *bitmap;
+	char *bins;
+
+	/* previous growing still not done? finish it first */
+	if (this->old_bins) {
+		if (!grow_step(this, this->old_bincount, this->old_bincount))
+			return;
+	}
+
+	bincount = this->bincount * 2;
+	if (bincount < this->bincount)
+		return;
+
+	bins = calloc(bincount, this->binsize);
+	if (!bins)
+		return;
+
+	mapcount = 1 + (bincount / BITS);
+	bitmap = calloc(mapcount, sizeof(int));
+
+	if (!bitmap) {
+		free(bins);
+		return;
+	}
+
+	this->old_bins = this->bins;
+	this->old_bitmap = this->bitmap;
+	this->old_bincount = this->bincount;
+	this->rehash_idx = 0;
+
+	this->bins = bins;
+	this->bitmap = bitmap;
+	this->bincount = bincount;
+}
+
+static void *find_in(const tl_hashmap *this, char *bins, const int *bitmap,
+		     size_t bincount, const void *key, unsigned long hash)
+{
+	tl_hashmap_entry *it;
+	entrydata data;
+	char *ptr;
 
-	for (i = 0; i < this->bincount; ++i, ptr += this->binsize) {
-		used = this->bitmap[i / (sizeof(int) * CHAR_BIT)];
-		used = (used >> (i % (sizeof(int) * CHAR_BIT))) & 0x01;
+	get_entry_data(this, &data, bins, bitmap, bincount, hash);
 
-		if (!used)
+	if (!data.used)
+		return NULL;
+
+	for (it = data.ent; it != NULL; it = it->next) {
+		if (it->hash != hash)
 			continue;
 
-		it = (tl_hashmap_entry *)ptr;
+		ptr = (char *)it + sizeof(tl_hashmap_entry);
+
+		if (this->compare(ptr, key) == 0)
+			return ptr + this->keysize_padded;
+	}
+
+	return NULL;
+}
+
+static int remove_from(tl_hashmap *this, char *bins, int *bitmap,
+		       size_t bincount, const void *key, unsigned long hash,
+		       void *object)
+{
+	tl_hashmap_entry *it, *prev;
+	entrydata data;
+	char *ptr;
+
+	get_entry_data(this, &data, bins, bitmap, bincount, hash);
+
+	if (!data.used)
+		return 0;
+
+	prev = NULL;
+	it = data.ent;
+
+	while (it != NULL) {
+		ptr = (char *)it + sizeof(tl_hashmap_entry);
 
-		while (it != NULL) {
-			old = it;
+		if (it->hash != hash || this->compare(ptr, key) != 0) {
+			prev = it;
 			it = it->next;
+			continue;
+		}
 
-			entry = (char *)it + sizeof(tl_hashmap_entry);
-			tl_allocator_cleanup(this->keyalloc, entry,
-					     this->keysize, 1);
+		tl_allocator_cleanup(this->keyalloc, ptr, this->keysize, 1);
+		ptr += this->keysize_padded;
 
-			entry += this->keysize_padded;
-			tl_allocator_cleanup(this->objalloc, entry,
+		if (object) {
+			memcpy(object, ptr, this->objsize);
+		} else {
+			tl_allocator_cleanup(this->objalloc, ptr,
 					     this->objsize, 1);
+		}
 
-			if (old != (tl_hashmap_entry *)ptr)
-				free(old);
+		if (prev) {
+			prev->next = it->next;
+			hashmap_entry_free(this, it);
+		} else if (it->next) {
+			prev = it->next;
+			memcpy(it, it->next, this->binsize);
+			hashmap_entry_free(this, prev);
+		} else {
+			CLEAR_USED(bitmap, data.idx);
 		}
+		return 1;
 	}
+
+	return 0;
+}
+
+/* add an entry with a copy of the key, returns a pointer to the value */
+static char *add_entry(tl_hashmap *this, const void *key, unsigned long hash)
+{
+	tl_hashmap_entry *new;
+	entrydata data;
+	char *ptr;
+
+	if (this->max_load && (tl_u64)(this->count + 1) * 100 >
+	    (tl_u64)this->bincount * this->max_load) {
+		start_grow(this);
+	}
+
+	if (this->old_bins)
+		grow_step(this, GROW_STEP_BINS, GROW_STEP_EMPTY);
+
+	get_entry_data(this, &data, this->bins, this->bitmap,
+		       this->bincount, hash);
+
+	if (data.used) {
+		new = hashmap_entry_alloc(this);
+		if (!new)
+			return NULL;
+
+		memcpy(new, data.ent, this->binsize);
+		data.ent->next = new;
+	} else {
+		SET_USED(this->bitmap, data.idx);
+	}
+
+	data.ent->hash = hash;
+
+	ptr = (char *)data.ent + sizeof(tl_hashmap_entry);
+	tl_allocator_copy(this->keyalloc, ptr, key, this->keysize, 1);
+
+	++this->count;
+	return ptr + this->keysize_padded;
+}
+
+static int insert_hashed(tl_hashmap *this, const void *key,
+			 const void *object, unsigned long hash)
+{
+	char *ptr = add_entry(this, key, hash);
+
+	if (!ptr)
+		return 0;
+
+	tl_allocator_copy(this->objalloc, ptr, object, this->objsize, 1);
+	return 1;
+}
+
+static void *at_hashed(const tl_hashmap *this, const void *key,
+			unsigned long hash)
+{
+	void *ptr;
+
+	ptr = find_in(this, this->bins, this->bitmap, this->bincount,
+		      key, hash);
+
+	if (!ptr && this->old_bins) {
+		ptr = find_in(this, this->old_bins, this->old_bitmap,
+			      this->old_bincount, key, hash);
+	}
+
+	return ptr;
+}
+
+static void prefetch_bins(const tl_hashmap *this, const unsigned long *hash,
+			  size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; ++i) {
+		PREFETCH(this->bins + (hash[i] % this->bincount) *
+			 this->binsize);
+
+		if (this->old_bins) {
+			PREFETCH(this->old_bins + (hash[i] %
+						   this->old_bincount) *
+				 this->binsize);
+		}
+	}
+}
+
+/* returns the number of overflow entries needed to add the pairs to bins */
+static size_t bulk_count_overflow(tl_hashmap *this, size_t first, size_t last,
+				  const unsigned long *hashes,
+				  const size_t *indices, size_t count)
+{
+	size_t i, bin, used = 0;
+
+	for (i = 0; i < count; ++i) {
+		bin = hashes[indices[i]] % this->bincount;
+		assert(bin >= first && bin < last);
+
+		if (!IS_USED(this->bitmap, bin)) {
+			SET_USED(this->bitmap, bin);
+			++used;
+		}
+	}
+
+	first /= BITS;
+	last = (last + BITS - 1) / BITS;
+
+	memset(this->bitmap + first, 0, (last - first) * sizeof(int));
+	return count - used;
+}
+
+/****************************************************************************/
+
+size_t hashmap_find_used(const int *bitmap, size_t idx, size_t end)
+{
+	unsigned int word;
+
+	while (idx < end) {
+		word = (unsigned int)bitmap[idx / BITS] >> (idx % BITS);
+
+		if (word) {
+			idx += lowest_bit(word);
+			return idx < end ? idx : end;
+		}
+
+		idx += BITS - idx % BITS;
+	}
+
+	return end;
+}
+
+tl_hashmap_entry *hashmap_entry_alloc(tl_hashmap *this)
+{
+	pool_block *blk = this->pool;
+	tl_hashmap_entry *ent;
+	size_t count;
+
+	if (this->free_list) {
+		ent = this->free_list;
+		this->free_list = ent->next;
+		return ent;
+	}
+
+	if (!this->pool_avail) {
+		count = blk ? blk->count * 2 : POOL_MIN_ENTRIES;
+		if (count > POOL_MAX_ENTRIES)
+			count = POOL_MAX_ENTRIES;
+
+		blk = malloc(sizeof(*blk) + count * this->binsize);
+		if (!blk)
+			return NULL;
+
+		blk->next = this->pool;
+		blk->count = count;
+
+		this->pool = blk;
+		this->pool_avail = count;
+	}
+
+	ent = (tl_hashmap_entry *)((char *)blk + sizeof(*blk) +
+				   (blk->count - this->pool_avail) *
+				   this->binsize);
+
+	--this->pool_avail;
+	return ent;
+}
+
+void hashmap_entry_free(tl_hashmap *this, tl_hashmap_entry *ent)
+{
+	ent->next = this->free_list;
+	this->free_list = ent;
+}
+
+void hashmap_pool_cleanup(tl_hashmap *this)
+{
+	pool_block *blk, *old;
+
+	for (blk = this->pool; blk != NULL; ) {
+		old = blk;
+		blk = blk->next;
+		free(old);
+	}
+
+	this->pool = NULL;
+	this->free_list = NULL;
+	this->pool_avail = 0;
 }
 
 /****************************************************************************/
@@ -96,7 +601,7 @@ int tl_hashmap_init(tl_hashmap *this, size_t keysize, size_t objsize,
 		return 0;
 
 	/* allocate usage bitmap */
-	mapcount = 1 + (bincount / (sizeof(int) * CHAR_BIT));
+	mapcount = 1 + (bincount / BITS);
 	this->bitmap = calloc(mapcount, sizeof(int));
 
 	if (!this->bitmap) {
@@ -114,9 +619,25 @@ int tl_hashmap_init(tl_hashmap *this, size_t keysize, size_t objsize,
 	this->compare = keycompare;
 	this->keyalloc = keyalloc;
 	this->objalloc = valalloc;
+	this->count = 0;
+	this->max_load = 0;
+	this->old_bins = NULL;
+	this->old_bitmap = NULL;
+	this->old_bincount = 0;
+	this->rehash_idx = 0;
+	this->free_list = NULL;
+	this->pool = NULL;
+	this->pool_avail = 0;
+	this->bulk = NULL;
 	return 1;
 }
 
+void tl_hashmap_set_max_load(tl_hashmap *this, unsigned int max_load)
+{
+	assert(this);
+	this->max_load = max_load;
+}
+
 void tl_hashmap_cleanup(tl_hashmap *this)
 {
 	assert(this);
@@ -130,21 +651,24 @@ void tl_hashmap_cleanup(tl_hashmap *this)
 
 int tl_hashmap_copy(tl_hashmap *this, const tl_hashmap *src)
 {
-	tl_hashmap_entry *sit, *dit;
-	size_t i, mapcount;
-	char *sptr, *dptr;
+	size_t mapcount;
 	tl_hashmap cpy;
-	int used;
 
 	assert(this && src);
 
 	memcpy(&cpy, src, sizeof(cpy));
+	cpy.old_bins = NULL;
+	cpy.old_bitmap = NULL;
+	cpy.free_list = NULL;
+	cpy.pool = NULL;
+	cpy.pool_avail = 0;
+	cpy.bulk = NULL;
 
 	cpy.bins = calloc(cpy.binsize, cpy.bincount);
 	if (!cpy.bins)
 		return 0;
 
-	mapcount = 1 + (cpy.bincount / (sizeof(int) * CHAR_BIT));
+	mapcount = 1 + (cpy.bincount / BITS);
 
 	cpy.bitmap = calloc(mapcount, sizeof(int));
 	if (!cpy.bitmap) {
@@ -152,43 +676,39 @@ int tl_hashmap_copy(tl_hashmap *this, const tl_hashmap *src)
 		return 0;
 	}
 
-	/* copy bins */
-	for (i = 0; i < cpy.bincount; ++i) {
-		dit = (tl_hashmap_entry *)(cpy.bins + i * cpy.binsize);
-		sit = (tl_hashmap_entry *)((char *)src->bins + i*cpy.binsize);
-		used = src->bitmap[i / (sizeof(int) * CHAR_BIT)];
-		used &= 1 << (i % (sizeof(int) * CHAR_BIT));
-
-		if (!used)
-			continue;
-
-		cpy.bitmap[i / (sizeof(int) * CHAR_BIT)] |= used;
-
-		for (; sit != NULL; sit = sit->next, dit = dit->next) {
-			dptr = (char *)dit + sizeof(tl_hashmap_entry);
-			sptr = (char *)sit + sizeof(tl_hashmap_entry);
-
-			tl_allocator_copy(cpy.keyalloc, dptr, sptr,
-					  cpy.keysize, 1);
-			sptr += this->keysize_padded;
-			dptr += this->keysize_padded;
+	/* copy the previous table of a growing map as well */
+	if (src->old_bins) {
+		cpy.old_bins = calloc(cpy.binsize, cpy.old_bincount);
+		mapcount = 1 + (cpy.old_bincount / BITS);
+		cpy.old_bitmap = calloc(mapcount, sizeof(int));
 
-			tl_allocator_copy(cpy.objalloc, dptr, sptr,
-					  cpy.objsize, 1);
+		if (!cpy.old_bins || !cpy.old_bitmap)
+			goto fail;
 
-			if (sit->next) {
-				dit->next = calloc(1, cpy.binsize);
-				if (!dit->next)
-					goto fail;
-			}
+		if (!copy_bins(&cpy, cpy.old_bins, cpy.old_bitmap,
+			       src->old_bins, src->old_bitmap,
+			       cpy.old_bincount)) {
+			goto fail;
 		}
 	}
 
+	/* copy bins */
+	if (!copy_bins(&cpy, cpy.bins, cpy.bitmap,
+		       src->bins, src->bitmap, cpy.bincount)) {
+		goto fail;
+	}
+
 	/* set */
 	tl_hashmap_cleanup(this);
 	memcpy(this, &cpy, sizeof(cpy));
 	return 1;
 fail:
+	if (!cpy.old_bins || !cpy.old_bitmap) {
+		free(cpy.old_bins);
+		free(cpy.old_bitmap);
+		cpy.old_bins = NULL;
+		cpy.old_bitmap = NULL;
+	}
 	tl_hashmap_cleanup(&cpy);
 	return 0;
 }
@@ -199,62 +719,65 @@ void tl_hashmap_clear(tl_hashmap *this)
 
 	assert(this);
 
-	mapcount = 1 + (this->bincount / (sizeof(int) * CHAR_BIT));
+	mapcount = 1 + (this->bincount / BITS);
 
 	free_hashmap(this);
 	memset(this->bins, 0, this->bincount * this->binsize);
 	memset(this->bitmap, 0, mapcount * sizeof(int));
+	this->count = 0;
 }
 
 tl_hashmap_entry *tl_hashmap_get_bin(const tl_hashmap *this, size_t idx)
 {
-	int used;
-
 	assert(this);
 
 	if (idx >= this->bincount)
 		return NULL;
 
-	used = this->bitmap[idx / (sizeof(int) * CHAR_BIT)];
-	used = (used >> (idx % (sizeof(int) * CHAR_BIT))) & 0x01;
-
-	if (!used)
+	if (!IS_USED(this->bitmap, idx))
 		return NULL;
 
 	return (tl_hashmap_entry *)(this->bins + idx * this->binsize);
 }
 
-int tl_hashmap_insert(tl_hashmap *this, const void *key, const void *object)
+void tl_hashmap_get_stats(const tl_hashmap *this, tl_hashmap_stats *stats)
 {
-	tl_hashmap_entry *new;
-	entrydata data;
-	char *ptr;
-	int mask;
+	const tl_hashmap_entry *ent;
+	const pool_block *blk;
 
-	assert(this && key && object);
+	assert(this && stats);
 
-	get_entry_data(this, &data, key);
+	memset(stats, 0, sizeof(*stats));
+	stats->count = this->count;
 
-	if (data.used) {
-		new = malloc(this->binsize);
-		if (!new)
-			return 0;
+	stats_add_bins(this, stats, this->bins, this->bitmap, this->bincount);
 
-		memcpy(new, data.ent, this->binsize);
-		data.ent->next = new;
-	} else {
-		mask = 1 << (data.idx % (sizeof(int) * CHAR_BIT));
-		this->bitmap[data.idx / (sizeof(int) * CHAR_BIT)] |= mask;
+	if (this->old_bins) {
+		stats_add_bins(this, stats, this->old_bins, this->old_bitmap,
+			       this->old_bincount);
 	}
 
-	/* copy key */
-	ptr = (char *)data.ent + sizeof(tl_hashmap_entry);
-	tl_allocator_copy(this->keyalloc, ptr, key, this->keysize, 1);
+	stats->chain_histogram[0] = stats->bincount - stats->used_bins;
 
-	/* copy value */
-	ptr += this->keysize_padded;
-	tl_allocator_copy(this->objalloc, ptr, object, this->objsize, 1);
-	return 1;
+	if (stats->bincount)
+		stats->load_factor = (double)stats->count / stats->bincount;
+
+	for (blk = this->pool; blk != NULL; blk = blk->next) {
+		stats->overflow_bytes += sizeof(*blk) +
+					 blk->count * this->binsize;
+	}
+
+	for (ent = this->free_list; ent != NULL; ent = ent->next)
+		stats->overflow_free += 1;
+
+	stats->overflow_free += this->pool_avail;
+}
+
+int tl_hashmap_insert(tl_hashmap *this, const void *key, const void *object)
+{
+	assert(this && key && object);
+
+	return insert_hashed(this, key, object, this->hash(key));
 }
 
 int tl_hashmap_set(tl_hashmap *this, const void *key, const void *object)
@@ -277,94 +800,279 @@ int tl_hashmap_set(tl_hashmap *this, const void *key, const void *object)
 
 void *tl_hashmap_at(const tl_hashmap *this, const void *key)
 {
-	tl_hashmap_entry *it;
-	entrydata data;
+	assert(this && key);
+
+	return at_hashed(this, key, this->hash(key));
+}
+
+void *tl_hashmap_emplace(tl_hashmap *this, const void *key, int *created)
+{
+	unsigned long hash;
 	char *ptr;
 
 	assert(this && key);
 
-	get_entry_data(this, &data, key);
+	hash = this->hash(key);
+	ptr = at_hashed(this, key, hash);
 
-	if (!data.used)
-		return NULL;
+	if (created)
+		*created = (ptr == NULL);
 
-	for (it = data.ent; it != NULL; it = it->next) {
-		ptr = (char *)it + sizeof(tl_hashmap_entry);
+	if (!ptr) {
+		ptr = add_entry(this, key, hash);
 
-		if (this->compare(ptr, key) == 0)
-			return ptr + this->keysize_padded;
+		if (ptr)
+			tl_allocator_init(this->objalloc, ptr,
+					  this->objsize, 1);
 	}
 
-	return NULL;
+	return ptr;
 }
 
-int tl_hashmap_remove(tl_hashmap *this, const void *key, void *object)
+size_t tl_hashmap_insert_batch(tl_hashmap *this, const void *keys,
+			       const void *objects, size_t count)
 {
-	tl_hashmap_entry *it, *prev;
-	entrydata data;
-	size_t off;
-	char *ptr;
-	int mask;
+	const char *key = keys, *obj = objects;
+	unsigned long hash[BATCH_SIZE];
+	size_t i, j, n;
 
-	assert(this && key);
+	assert(this && (keys || !count) && (objects || !count));
 
-	get_entry_data(this, &data, key);
+	for (i = 0; i < count; i += n) {
+		n = count - i < BATCH_SIZE ? count - i : BATCH_SIZE;
 
-	if (!data.used)
-		return 0;
+		for (j = 0; j < n; ++j)
+			hash[j] = this->hash(key + j * this->keysize);
 
-	prev = NULL;
-	it = data.ent;
+		prefetch_bins(this, hash, n);
 
-	while (it != NULL) {
-		ptr = (char *)it + sizeof(tl_hashmap_entry);
+		for (j = 0; j < n; ++j) {
+			if (!insert_hashed(this, key, obj, hash[j]))
+				return i + j;
 
-		if (this->compare(ptr, key) != 0) {
-			prev = it;
-			it = it->next;
-			continue;
+			key += this->keysize;
+			obj += this->objsize;
 		}
+	}
 
-		tl_allocator_cleanup(this->keyalloc, ptr, this->keysize, 1);
-		ptr += this->keysize_padded;
+	return count;
+}
 
-		if (object) {
-			memcpy(object, ptr, this->objsize);
-		} else {
-			tl_allocator_cleanup(this->objalloc, ptr,
-					     this->objsize, 1);
-		}
+size_t tl_hashmap_at_batch(const tl_hashmap *this, const void *keys,
+			   size_t count, void **out)
+{
+	const char *key = keys;
+	unsigned long hash[BATCH_SIZE];
+	size_t i, j, n, found = 0;
 
-		if (prev) {
-			prev->next = it->next;
-			free(it);
-		} else if (it->next) {
-			prev = it->next;
-			memcpy(it, it->next, this->binsize);
-			free(prev);
-		} else {
-			mask = 1 << (data.idx % (sizeof(int) * CHAR_BIT));
-			off = data.idx / (sizeof(int) * CHAR_BIT);
-			this->bitmap[off] &= ~mask;
+	assert(this && out && (keys || !count));
+
+	for (i = 0; i < count; i += n) {
+		n = count - i < BATCH_SIZE ? count - i : BATCH_SIZE;
+
+		for (j = 0; j < n; ++j)
+			hash[j] = this->hash(key + j * this->keysize);
+
+		prefetch_bins(this, hash, n);
+
+		for (j = 0; j < n; ++j) {
+			out[i + j] = at_hashed(this, key, hash[j]);
+			found += (out[i + j] != NULL);
+			key += this->keysize;
 		}
+	}
+
+	return found;
+}
+
+int tl_hashmap_remove(tl_hashmap *this, const void *key, void *object)
+{
+	unsigned long hash;
+
+	assert(this && key);
+
+	if (this->old_bins)
+		grow_step(this, GROW_STEP_BINS, GROW_STEP_EMPTY);
+
+	hash = this->hash(key);
+
+	if (remove_from(this, this->bins, this->bitmap,
+			this->bincount, key, hash, object)) {
+		--this->count;
+		return 1;
+	}
+
+	if (this->old_bins && remove_from(this, this->old_bins,
+					  this->old_bitmap,
+					  this->old_bincount, key, hash,
+					  object)) {
+		--this->count;
 		return 1;
 	}
 
 	return 0;
 }
 
-int tl_hashmap_is_empty(const tl_hashmap *this)
+size_t tl_hashmap_bulk_begin(tl_hashmap *this, size_t bincount,
+			     size_t *ranges)
 {
-	size_t i, mapcount;
+	size_t width, count;
+	bulk_state *bulk;
+	int *bitmap;
+	char *bins;
 
-	assert(this);
+	assert(this && bincount && ranges && *ranges);
+
+	if (this->count || this->bulk)
+		return 0;
+
+	/* ranges of whole bitmap words, so they never share a word */
+	width = (bincount + *ranges - 1) / *ranges;
+	width = ((width + BITS - 1) / BITS) * BITS;
+	count = (bincount + width - 1) / width;
 
-	mapcount = 1 + (this->bincount / (sizeof(int) * CHAR_BIT));
+	bulk = calloc(1, sizeof(*bulk) + (count - 1) * sizeof(bulk_range));
+	bins = calloc(bincount, this->binsize);
+	bitmap = calloc(1 + bincount / BITS, sizeof(int));
 
-	for (i = 0; i < mapcount; ++i) {
-		if (this->bitmap[i])
+	if (!bulk || !bins || !bitmap) {
+		free(bitmap);
+		free(bins);
+		free(bulk);
+		return 0;
+	}
+
+	bulk->bins = this->bins;
+	bulk->bitmap = this->bitmap;
+	bulk->bincount = this->bincount;
+	bulk->width = width;
+	bulk->count = count;
+
+	this->bins = bins;
+	this->bitmap = bitmap;
+	this->bincount = bincount;
+	this->bulk = bulk;
+
+	*ranges = count;
+	return width;
+}
+
+int tl_hashmap_bulk_fill(tl_hashmap *this, size_t range, const void *keys,
+			 const void *objects, const unsigned long *hashes,
+			 const size_t *indices, size_t count)
+{
+	bulk_state *bulk = this->bulk;
+	size_t i, idx, bin, first, last;
+	tl_hashmap_entry *head, *ent;
+	pool_block *blk = NULL;
+	char *next = NULL, *ptr;
+
+	assert(this && bulk && range < bulk->count);
+	assert((keys && objects && hashes && indices) || !count);
+	assert(!bulk->range[range].count);
+
+	first = range * bulk->width;
+	last = first + bulk->width;
+	if (last > this->bincount)
+		last = this->bincount;
+
+	/* allocate exactly as many overflow entries as the range needs */
+	i = bulk_count_overflow(this, first, last, hashes, indices, count);
+
+	if (i) {
+		blk = malloc(sizeof(*blk) + i * this->binsize);
+		if (!blk)
 			return 0;
+
+		blk->next = NULL;
+		blk->count = i;
+		next = (char *)blk + sizeof(*blk);
 	}
 
+	/* like tl_hashmap_insert, the newest entry goes in front */
+	for (i = 0; i < count; ++i) {
+		idx = indices[i];
+		bin = hashes[idx] % this->bincount;
+		head = (tl_hashmap_entry *)(this->bins + bin * this->binsize);
+
+		if (IS_USED(this->bitmap, bin)) {
+			ent = (tl_hashmap_entry *)next;
+			next += this->binsize;
+
+			memcpy(ent, head, this->binsize);
+			head->next = ent;
+		} else {
+			SET_USED(this->bitmap, bin);
+			head->next = NULL;
+		}
+
+		head->hash = hashes[idx];
+
+		ptr = (char *)head + sizeof(tl_hashmap_entry);
+		tl_allocator_copy(this->keyalloc, ptr,
+				  (const char *)keys + idx * this->keysize,
+				  this->keysize, 1);
+
+		ptr += this->keysize_padded;
+		tl_allocator_copy(this->objalloc, ptr,
+				  (const char *)objects + idx * this->objsize,
+				  this->objsize, 1);
+	}
+
+	bulk->range[range].block = blk;
+	bulk->range[range].count = count;
 	return 1;
 }
+
+void tl_hashmap_bulk_end(tl_hashmap *this, int commit)
+{
+	bulk_state *bulk = this->bulk;
+	pool_block *blk;
+	size_t i;
+
+	assert(this && bulk);
+
+	if (!commit) {
+		free_bins(this, this->bins, this->bitmap, this->bincount);
+
+		for (i = 0; i < bulk->count; ++i)
+			free(bulk->range[i].block);
+
+		free(this->bins);
+		free(this->bitmap);
+
+		this->bins = bulk->bins;
+		this->bitmap = bulk->bitmap;
+		this->bincount = bulk->bincount;
+		goto out;
+	}
+
+	/* the map was empty, so the previous tables hold no entries */
+	free(bulk->bins);
+	free(bulk->bitmap);
+
+	if (this->old_bins)
+		finish_grow(this);
+
+	hashmap_pool_cleanup(this);
+
+	for (i = 0; i < bulk->count; ++i) {
+		blk = bulk->range[i].block;
+
+		if (blk) {
+			blk->next = this->pool;
+			this->pool = blk;
+		}
+
+		this->count += bulk->range[i].count;
+	}
+out:
+	free(bulk);
+	this->bulk = NULL;
+}
+
+int tl_hashmap_is_empty(const tl_hashmap *this)
+{
+	assert(this);
+	return this->count == 0;
+}
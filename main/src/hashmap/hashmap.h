@@ -0,0 +1,50 @@
+/* hashmap.h -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include "tl_hashmap.h"
+
+#include <limits.h>
+
+#define BITS (sizeof(int) * CHAR_BIT)
+
+#define IS_USED(bitmap, idx) \
+	(((bitmap)[(idx) / BITS] >> ((idx) % BITS)) & 0x01)
+
+#define SET_USED(bitmap, idx) \
+	((bitmap)[(idx) / BITS] |= 1U << ((idx) % BITS))
+
+#define CLEAR_USED(bitmap, idx) \
+	((bitmap)[(idx) / BITS] &= ~(1U << ((idx) % BITS)))
+
+/*
+    Header of a pool block, followed by the overflow entries. The blocks are
+    linked through tl_hashmap::pool, the newest one first.
+ */
+typedef struct pool_block {
+	struct pool_block *next;
+	size_t count;
+} pool_block;
+
+/*
+    returns the index of the first used bin in [idx, end) or end if there is
+    none, skipping entire words of the bitmap at once
+ */
+size_t hashmap_find_used(const int *bitmap, size_t idx, size_t end);
+
+/* get an overflow entry from the pool of a hash map */
+tl_hashmap_entry *hashmap_entry_alloc(tl_hashmap *map);
+
+/* return an overflow entry to the pool of a hash map */
+void hashmap_entry_free(tl_hashmap *map, tl_hashmap_entry *ent);
+
+/* release all overflow entries of a hash map at once */
+void hashmap_pool_cleanup(tl_hashmap *map);
+
+#endif /* HASHMAP_H */
@@ -0,0 +1,177 @@
+/* ihashmap.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_ihashmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE(map, obj) ((tl_ihashmap_node *)((char *)(obj) + (map)->offset))
+#define OBJ(map, node) ((void *)((char *)(node) - (map)->offset))
+
+/* returns a pointer to the link pointing to the node of a key */
+static tl_ihashmap_node **find_link(const tl_ihashmap *this, const void *key,
+				    unsigned long hash)
+{
+	tl_ihashmap_node **link = this->bins + hash % this->bincount;
+
+	for (; *link != NULL; link = &(*link)->next) {
+		if ((*link)->hash == hash &&
+		    !this->compare(OBJ(this, *link), key)) {
+			break;
+		}
+	}
+
+	return link;
+}
+
+/* the hash values are cached, so rehashing never calls back into the user */
+static void grow(tl_ihashmap *this)
+{
+	tl_ihashmap_node **bins, *node, *next;
+	size_t i, idx, bincount = this->bincount * 2;
+
+	if (bincount < this->bincount)
+		return;
+
+	bins = calloc(bincount, sizeof(bins[0]));
+	if (!bins)
+		return;
+
+	for (i = 0; i < this->bincount; ++i) {
+		for (node = this->bins[i]; node != NULL; node = next) {
+			next = node->next;
+			idx = node->hash % bincount;
+
+			node->next = bins[idx];
+			bins[idx] = node;
+		}
+	}
+
+	free(this->bins);
+	this->bins = bins;
+	this->bincount = bincount;
+}
+
+/****************************************************************************/
+
+int tl_ihashmap_init(tl_ihashmap *this, size_t bincount, size_t offset,
+		     tl_hash hash, tl_compare compare)
+{
+	assert(this && hash && compare);
+
+	if (!bincount)
+		bincount = 1;
+
+	memset(this, 0, sizeof(*this));
+
+	this->bins = calloc(bincount, sizeof(this->bins[0]));
+	if (!this->bins)
+		return 0;
+
+	this->bincount = bincount;
+	this->offset = offset;
+	this->hash = hash;
+	this->compare = compare;
+	return 1;
+}
+
+void tl_ihashmap_cleanup(tl_ihashmap *this)
+{
+	assert(this);
+
+	free(this->bins);
+	memset(this, 0, sizeof(*this));
+}
+
+void tl_ihashmap_clear(tl_ihashmap *this)
+{
+	assert(this);
+
+	memset(this->bins, 0, this->bincount * sizeof(this->bins[0]));
+	this->count = 0;
+}
+
+void *tl_ihashmap_insert(tl_ihashmap *this, void *obj)
+{
+	tl_ihashmap_node *node, **link;
+	unsigned long hash;
+
+	assert(this && obj);
+
+	hash = this->hash(obj);
+	link = find_link(this, obj, hash);
+
+	if (*link)
+		return OBJ(this, *link);
+
+	if (this->count >= this->bincount) {
+		grow(this);
+		link = this->bins + hash % this->bincount;
+	}
+
+	node = NODE(this, obj);
+	node->hash = hash;
+	node->next = *link;
+	*link = node;
+
+	++this->count;
+	return NULL;
+}
+
+void *tl_ihashmap_find(const tl_ihashmap *this, const void *key)
+{
+	tl_ihashmap_node **link;
+
+	assert(this && key);
+
+	link = find_link(this, key, this->hash(key));
+
+	return *link ? OBJ(this, *link) : NULL;
+}
+
+void *tl_ihashmap_remove(tl_ihashmap *this, const void *key)
+{
+	tl_ihashmap_node *node, **link;
+
+	assert(this && key);
+
+	link = find_link(this, key, this->hash(key));
+	node = *link;
+
+	if (!node)
+		return NULL;
+
+	*link = node->next;
+	--this->count;
+	return OBJ(this, node);
+}
+
+void *tl_ihashmap_get_next(const tl_ihashmap *this, const void *obj)
+{
+	const tl_ihashmap_node *node;
+	size_t i = 0;
+
+	assert(this);
+
+	if (obj) {
+		node = NODE(this, obj);
+
+		if (node->next)
+			return OBJ(this, node->next);
+
+		i = node->hash % this->bincount + 1;
+	}
+
+	for (; i < this->bincount; ++i) {
+		if (this->bins[i])
+			return OBJ(this, this->bins[i]);
+	}
+
+	return NULL;
+}
@@ -0,0 +1,221 @@
+/* irbtree.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_irbtree.h"
+#include "rbtree/rbtree.h"
+
+#define NODE(tree, obj) ((tl_rbtree_node *)((char *)(obj) + (tree)->offset))
+#define OBJ(tree, node) ((void *)((char *)(node) - (tree)->offset))
+
+static tl_rbtree_node *subtree_insert(tl_irbtree *this, tl_rbtree_node *root,
+				      tl_rbtree_node *newnode)
+{
+	if (!root)
+		return newnode;
+
+	if (this->compare(OBJ(this, newnode), OBJ(this, root)) < 0) {
+		root->left = subtree_insert(this, root->left, newnode);
+	} else {
+		root->right = subtree_insert(this, root->right, newnode);
+	}
+
+	return rbtree_balance(root);
+}
+
+/* unlink the minimum of a subtree and return it through min */
+static tl_rbtree_node *detach_min(tl_rbtree_node *this, tl_rbtree_node **min)
+{
+	if (!this->left) {
+		*min = this;
+		return NULL;
+	}
+
+	if (!IS_RED(this->left) && !IS_RED(this->left->left))
+		this = rbtree_move_red_left(this);
+
+	this->left = detach_min(this->left, min);
+	return rbtree_balance(this);
+}
+
+/*
+    Same as for the tl_rbtree, except that the node cannot be removed by
+    swapping the contents with the minimum of its right subtree. Instead,
+    the minimum is unlinked and takes the place of the node.
+ */
+static tl_rbtree_node *remove_from_subtree(tl_irbtree *this,
+					   tl_rbtree_node *root,
+					   tl_rbtree_node *node)
+{
+	tl_rbtree_node *min, *right;
+
+	if (this->compare(OBJ(this, node), OBJ(this, root)) < 0) {
+		if (!IS_RED(root->left) && !IS_RED(root->left->left))
+			root = rbtree_move_red_left(root);
+
+		root->left = remove_from_subtree(this, root->left, node);
+	} else {
+		if (IS_RED(root->left))
+			root = rbtree_rotate_right(root);
+
+		if (root == node && !root->right)
+			return NULL;
+
+		if (!IS_RED(root->right) && !IS_RED(root->right->left))
+			root = rbtree_move_red_right(root);
+
+		if (root == node) {
+			right = detach_min(root->right, &min);
+
+			min->left = root->left;
+			min->right = right;
+			min->is_red = root->is_red;
+			root = min;
+		} else {
+			root->right = remove_from_subtree(this, root->right,
+							  node);
+		}
+	}
+
+	return rbtree_balance(root);
+}
+
+/****************************************************************************/
+
+void tl_irbtree_init(tl_irbtree *this, size_t offset, tl_compare compare)
+{
+	assert(this && compare);
+
+	this->root = NULL;
+	this->compare = compare;
+	this->offset = offset;
+	this->size = 0;
+}
+
+void tl_irbtree_clear(tl_irbtree *this)
+{
+	assert(this);
+
+	this->root = NULL;
+	this->size = 0;
+}
+
+void *tl_irbtree_insert(tl_irbtree *this, void *obj)
+{
+	tl_rbtree_node *node;
+	void *old;
+
+	assert(this && obj);
+
+	old = tl_irbtree_find(this, obj);
+	if (old)
+		return old;
+
+	node = NODE(this, obj);
+	node->left = NULL;
+	node->right = NULL;
+	node->is_red = 1;
+
+	this->root = subtree_insert(this, this->root, node);
+	this->root->is_red = 0;
+
+	++(this->size);
+	return NULL;
+}
+
+void *tl_irbtree_find(const tl_irbtree *this, const void *key)
+{
+	tl_rbtree_node *node;
+	int ret;
+
+	assert(this && key);
+
+	for (node = this->root; node != NULL; ) {
+		ret = this->compare(key, OBJ(this, node));
+
+		if (ret == 0)
+			return OBJ(this, node);
+
+		node = ret < 0 ? node->left : node->right;
+	}
+
+	return NULL;
+}
+
+void *tl_irbtree_remove(tl_irbtree *this, const void *key)
+{
+	void *obj;
+
+	assert(this && key);
+
+	obj = tl_irbtree_find(this, key);
+	if (!obj)
+		return NULL;
+
+	/* hack for tree balancing algorithm */
+	if (!IS_RED(this->root->left) && !IS_RED(this->root->right))
+		this->root->is_red = 1;
+
+	this->root = remove_from_subtree(this, this->root, NODE(this, obj));
+
+	if (this->root)
+		this->root->is_red = 0;
+
+	--(this->size);
+	return obj;
+}
+
+void *tl_irbtree_get_min(const tl_irbtree *this)
+{
+	tl_rbtree_node *n;
+
+	assert(this);
+
+	if (!this->root)
+		return NULL;
+
+	for (n = this->root; n->left; n = n->left)
+		;
+
+	return OBJ(this, n);
+}
+
+void *tl_irbtree_get_max(const tl_irbtree *this)
+{
+	tl_rbtree_node *n;
+
+	assert(this);
+
+	if (!this->root)
+		return NULL;
+
+	for (n = this->root; n->right; n = n->right)
+		;
+
+	return OBJ(this, n);
+}
+
+void *tl_irbtree_get_next(const tl_irbtree *this, const void *key)
+{
+	tl_rbtree_node *node, *next = NULL;
+
+	assert(this);
+
+	if (!key)
+		return tl_irbtree_get_min(this);
+
+	for (node = this->root; node != NULL; ) {
+		if (this->compare(key, OBJ(this, node)) < 0) {
+			next = node;
+			node = node->left;
+		} else {
+			node = node->right;
+		}
+	}
+
+	return next ? OBJ(this, next) : NULL;
+}
@@ -0,0 +1,113 @@
+/* deque.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_iterator.h"
+#include "tl_deque.h"
+
+#include <stdlib.h>
+
+
+typedef struct {
+	tl_iterator super;
+	tl_deque *deque;
+	size_t idx;
+	int forward;
+} tl_deque_iterator;
+
+
+static void tl_deque_iterator_destroy(tl_iterator *this)
+{
+	free(this);
+}
+
+static void tl_deque_iterator_reset(tl_iterator *super)
+{
+	tl_deque_iterator *this = (tl_deque_iterator *)super;
+
+	if (!this->forward && this->deque->used) {
+		this->idx = this->deque->used - 1;
+	} else {
+		this->idx = 0;
+	}
+}
+
+static int tl_deque_iterator_has_data(tl_iterator *super)
+{
+	tl_deque_iterator *this = (tl_deque_iterator *)super;
+	return this->idx < this->deque->used;
+}
+
+static void tl_deque_iterator_next(tl_iterator *super)
+{
+	tl_deque_iterator *this = (tl_deque_iterator *)super;
+
+	if (this->idx < this->deque->used) {
+		if (this->forward) {
+			++this->idx;
+		} else {
+			--this->idx; /* eventually underflows out of range */
+		}
+	}
+}
+
+static void *tl_deque_iterator_get_key(tl_iterator *this)
+{
+	(void)this;
+	return NULL;
+}
+
+static void *tl_deque_iterator_get_value(tl_iterator *super)
+{
+	tl_deque_iterator *this = (tl_deque_iterator *)super;
+
+	return tl_deque_at(this->deque, this->idx);
+}
+
+static void tl_deque_iterator_remove(tl_iterator *super)
+{
+	tl_deque_iterator *this = (tl_deque_iterator *)super;
+
+	tl_deque_remove(this->deque, this->idx, 1);
+
+	if (!this->forward)
+		--this->idx;
+}
+
+static tl_iterator *tl_deque_iterator_create(tl_deque *deque, int first)
+{
+	tl_deque_iterator *this = malloc(sizeof(*this));
+	tl_iterator *super = (tl_iterator *)this;
+
+	if (!this)
+		return NULL;
+
+	this->deque = deque;
+	this->idx = first ? 0 : deque->used - 1;
+	this->forward = first;
+
+	super->destroy = tl_deque_iterator_destroy;
+	super->reset = tl_deque_iterator_reset;
+	super->has_data = tl_deque_iterator_has_data;
+	super->next = tl_deque_iterator_next;
+	super->get_key = tl_deque_iterator_get_key;
+	super->get_value = tl_deque_iterator_get_value;
+	super->remove = tl_deque_iterator_remove;
+	return super;
+}
+
+tl_iterator *tl_deque_first(tl_deque *this)
+{
+	assert(this);
+	return tl_deque_iterator_create(this, 1);
+}
+
+tl_iterator *tl_deque_last(tl_deque *this)
+{
+	assert(this);
+	return tl_deque_iterator_create(this, 0);
+}
@@ -0,0 +1,129 @@
+/* flatmap.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_allocator.h"
+#include "tl_iterator.h"
+#include "tl_flatmap.h"
+
+#include <stdlib.h>
+
+#define CTRL_DELETED 0xFE
+#define IS_FULL(c) (((c) & 0x80) == 0)
+
+typedef struct {
+	tl_iterator super;
+	tl_flatmap *map;
+	size_t idx;
+} tl_flatmap_iterator;
+
+
+static void find_next_slot(tl_flatmap_iterator *this)
+{
+	while (this->idx < this->map->bincount &&
+	       !IS_FULL(this->map->ctrl[this->idx])) {
+		++this->idx;
+	}
+}
+
+static void tl_flatmap_iterator_destroy(tl_iterator *this)
+{
+	free(this);
+}
+
+static void tl_flatmap_iterator_reset(tl_iterator *super)
+{
+	tl_flatmap_iterator *this = (tl_flatmap_iterator *)super;
+
+	this->idx = 0;
+	find_next_slot(this);
+}
+
+static int tl_flatmap_iterator_has_data(tl_iterator *super)
+{
+	tl_flatmap_iterator *this = (tl_flatmap_iterator *)super;
+
+	return this->idx < this->map->bincount;
+}
+
+static void tl_flatmap_iterator_next(tl_iterator *super)
+{
+	tl_flatmap_iterator *this = (tl_flatmap_iterator *)super;
+
+	if (this->idx < this->map->bincount) {
+		++this->idx;
+		find_next_slot(this);
+	}
+}
+
+static void *tl_flatmap_iterator_get_key(tl_iterator *super)
+{
+	tl_flatmap_iterator *this = (tl_flatmap_iterator *)super;
+
+	if (this->idx >= this->map->bincount)
+		return NULL;
+
+	return this->map->slots + this->idx * this->map->slotsize;
+}
+
+static void *tl_flatmap_iterator_get_value(tl_iterator *super)
+{
+	tl_flatmap_iterator *this = (tl_flatmap_iterator *)super;
+	char *ptr;
+
+	if (this->idx >= this->map->bincount)
+		return NULL;
+
+	ptr = this->map->slots + this->idx * this->map->slotsize;
+	return ptr + this->map->keysize_padded;
+}
+
+static void tl_flatmap_iterator_remove(tl_iterator *super)
+{
+	tl_flatmap_iterator *this = (tl_flatmap_iterator *)super;
+	tl_flatmap *map = this->map;
+	char *ptr;
+
+	if (this->idx >= map->bincount)
+		return;
+
+	ptr = map->slots + this->idx * map->slotsize;
+	tl_allocator_cleanup(map->keyalloc, ptr, map->keysize, 1);
+
+	ptr += map->keysize_padded;
+	tl_allocator_cleanup(map->objalloc, ptr, map->objsize, 1);
+
+	/* a tombstone is always safe, the next rehash gets rid of it */
+	map->ctrl[this->idx] = CTRL_DELETED;
+	map->count -= 1;
+
+	++this->idx;
+	find_next_slot(this);
+}
+
+tl_iterator *tl_flatmap_get_iterator(tl_flatmap *this)
+{
+	tl_flatmap_iterator *it;
+
+	assert(this);
+
+	it = calloc(1, sizeof(*it));
+	if (!it)
+		return NULL;
+
+	it->map = this;
+	it->super.destroy = tl_flatmap_iterator_destroy;
+	it->super.reset = tl_flatmap_iterator_reset;
+	it->super.has_data = tl_flatmap_iterator_has_data;
+	it->super.next = tl_flatmap_iterator_next;
+	it->super.get_key = tl_flatmap_iterator_get_key;
+	it->super.get_value = tl_flatmap_iterator_get_value;
+	it->super.remove = tl_flatmap_iterator_remove;
+
+	tl_flatmap_iterator_reset((tl_iterator *)it);
+	return (tl_iterator *)it;
+}
@@ -8,11 +8,10 @@
 #define TL_EXPORT
 #include "tl_allocator.h"
 #include "tl_iterator.h"
-#include "tl_hashmap.h"
+#include "../hashmap/hashmap.h"
 
 #include <stdlib.h>
 #include <string.h>
-#include <limits.h>
 
 typedef struct {
 	tl_iterator super;
@@ -23,17 +22,49 @@ typedef struct {
 } tl_hashmap_iterator;
 
 
+/*
+    While a map is growing, the iterator index first runs across the bins of
+    the new table and then across the bins of the old table.
+ */
+static int *get_bitmap(tl_hashmap_iterator *this, size_t *idx)
+{
+	*idx = this->idx;
+
+	if (*idx < this->map->bincount)
+		return this->map->bitmap;
+
+	*idx -= this->map->bincount;
+	return this->map->old_bitmap;
+}
+
 static void find_next_bin(tl_hashmap_iterator *this)
 {
+	tl_hashmap *map = this->map;
+	size_t idx;
+
 	this->prev = this->ent = NULL;
 
-	while (!this->ent && (this->idx < this->map->bincount)) {
-		this->ent = tl_hashmap_get_bin(this->map, this->idx);
+	if (this->idx < map->bincount) {
+		this->idx = hashmap_find_used(map->bitmap, this->idx,
+					      map->bincount);
 
-		if (this->ent)
-			break;
+		if (this->idx < map->bincount) {
+			this->ent = (tl_hashmap_entry *)(map->bins + this->idx *
+							 map->binsize);
+			return;
+		}
+	}
 
-		++this->idx;
+	if (!map->old_bins)
+		return;
+
+	idx = hashmap_find_used(map->old_bitmap, this->idx - map->bincount,
+				map->old_bincount);
+	this->idx = map->bincount + idx;
+
+	if (idx < map->old_bincount) {
+		this->ent = (tl_hashmap_entry *)(map->old_bins +
+						 idx * map->binsize);
 	}
 }
 
@@ -96,7 +127,8 @@ static void tl_hashmap_iterator_remove(tl_iterator *super)
 	tl_hashmap_iterator *this = (tl_hashmap_iterator *)super;
 	tl_hashmap_entry *old;
 	void *key, *val;
-	int used;
+	size_t idx;
+	int *bitmap;
 
 	if (!this->ent)
 		return;
@@ -106,10 +138,11 @@ static void tl_hashmap_iterator_remove(tl_iterator *super)
 
 	tl_allocator_cleanup(this->map->keyalloc, key, this->map->keysize, 1);
 	tl_allocator_cleanup(this->map->objalloc, val, this->map->objsize, 1);
+	this->map->count -= 1;
 
 	if (this->prev) {
 		this->prev->next = this->ent->next;
-		free(this->ent);
+		hashmap_entry_free(this->map, this->ent);
 
 		this->ent = this->prev->next;
 
@@ -119,12 +152,12 @@ static void tl_hashmap_iterator_remove(tl_iterator *super)
 		if (this->ent->next) {
 			old = this->ent->next;
 			memcpy(this->ent, this->ent->next, this->map->binsize);
-			free(old);
+			hashmap_entry_free(this->map, old);
 			return;
 		}
 
-		used = ~(1 << (this->idx % (sizeof(int) * CHAR_BIT)));
-		this->map->bitmap[this->idx / (sizeof(int) * CHAR_BIT)]&=used;
+		bitmap = get_bitmap(this, &idx);
+		CLEAR_USED(bitmap, idx);
 	}
 
 	this->idx += 1;
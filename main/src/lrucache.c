@@ -0,0 +1,229 @@
+/* lrucache.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_allocator.h"
+#include "tl_lrucache.h"
+#include "tl_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BINS 16
+
+/*
+    Header of a cache node, followed by a shallow copy of the key that is
+    used to remove the map entry on eviction, followed by the value. The
+    map entry owns the key, the node owns the value.
+ */
+typedef struct {
+	tl_list_node link;
+	size_t cost;
+} lru_node;
+
+static void *get_key(lru_node *node)
+{
+	return (char *)node + sizeof(lru_node);
+}
+
+static void *get_value(const tl_lrucache *this, lru_node *node)
+{
+	return (char *)node + this->objoffset;
+}
+
+static void unlink_node(tl_lrucache *this, lru_node *node)
+{
+	if (node->link.prev) {
+		node->link.prev->next = node->link.next;
+	} else {
+		this->first = node->link.next;
+	}
+
+	if (node->link.next) {
+		node->link.next->prev = node->link.prev;
+	} else {
+		this->last = node->link.prev;
+	}
+}
+
+static void push_front(tl_lrucache *this, lru_node *node)
+{
+	node->link.prev = NULL;
+	node->link.next = this->first;
+
+	if (this->first) {
+		this->first->prev = (tl_list_node *)node;
+	} else {
+		this->last = (tl_list_node *)node;
+	}
+
+	this->first = (tl_list_node *)node;
+}
+
+static void free_nodes(tl_lrucache *this)
+{
+	tl_list_node *node, *next;
+
+	for (node = this->first; node != NULL; node = next) {
+		next = node->next;
+		tl_allocator_cleanup(this->objalloc,
+				     get_value(this, (lru_node *)node),
+				     this->objsize, 1);
+		free(node);
+	}
+
+	this->first = this->last = NULL;
+	this->used = 0;
+}
+
+/****************************************************************************/
+
+int tl_lrucache_init(tl_lrucache *this, size_t keysize, size_t objsize,
+		     size_t capacity, tl_hash keyhash, tl_compare keycompare,
+		     tl_allocator *keyalloc, tl_allocator *valalloc)
+{
+	assert(this && keysize && objsize && keyhash && keycompare);
+
+	memset(this, 0, sizeof(*this));
+
+	if (!tl_hashmap_init(&this->map, keysize, sizeof(lru_node *),
+			     INITIAL_BINS, keyhash, keycompare,
+			     keyalloc, NULL)) {
+		return 0;
+	}
+
+	tl_hashmap_set_max_load(&this->map, 100);
+
+	this->objsize = objsize;
+	this->objoffset = sizeof(lru_node) + this->map.keysize_padded;
+	this->capacity = capacity;
+	this->objalloc = valalloc;
+	return 1;
+}
+
+void tl_lrucache_cleanup(tl_lrucache *this)
+{
+	assert(this);
+
+	free_nodes(this);
+	tl_hashmap_cleanup(&this->map);
+	memset(this, 0, sizeof(*this));
+}
+
+void tl_lrucache_clear(tl_lrucache *this)
+{
+	assert(this);
+
+	free_nodes(this);
+	tl_hashmap_clear(&this->map);
+}
+
+void *tl_lrucache_get(tl_lrucache *this, const void *key)
+{
+	lru_node **ptr;
+
+	assert(this && key);
+
+	ptr = tl_hashmap_at(&this->map, key);
+	if (!ptr)
+		return NULL;
+
+	if ((tl_list_node *)*ptr != this->first) {
+		unlink_node(this, *ptr);
+		push_front(this, *ptr);
+	}
+
+	return get_value(this, *ptr);
+}
+
+int tl_lrucache_put(tl_lrucache *this, const void *key, const void *object,
+		    size_t cost)
+{
+	lru_node **ptr, *node;
+	int created;
+
+	assert(this && key && object);
+
+	ptr = tl_hashmap_emplace(&this->map, key, &created);
+	if (!ptr)
+		return 0;
+
+	if (created) {
+		node = malloc(this->objoffset + this->objsize);
+
+		if (!node) {
+			tl_hashmap_remove(&this->map, key, NULL);
+			return 0;
+		}
+
+		/* the map entry holds the deep copy of the key */
+		memcpy(get_key(node), (char *)ptr - this->map.keysize_padded,
+		       this->map.keysize);
+		*ptr = node;
+	} else {
+		node = *ptr;
+		unlink_node(this, node);
+		tl_allocator_cleanup(this->objalloc, get_value(this, node),
+				     this->objsize, 1);
+		this->used -= node->cost;
+	}
+
+	tl_allocator_copy(this->objalloc, get_value(this, node), object,
+			  this->objsize, 1);
+
+	node->cost = cost;
+	this->used += cost;
+	push_front(this, node);
+
+	while (this->used > this->capacity && this->last != this->first)
+		tl_lrucache_evict(this);
+
+	return 1;
+}
+
+int tl_lrucache_remove(tl_lrucache *this, const void *key, void *object)
+{
+	lru_node *node;
+
+	assert(this && key);
+
+	if (!tl_hashmap_remove(&this->map, key, &node))
+		return 0;
+
+	unlink_node(this, node);
+	this->used -= node->cost;
+
+	if (object) {
+		memcpy(object, get_value(this, node), this->objsize);
+	} else {
+		tl_allocator_cleanup(this->objalloc, get_value(this, node),
+				     this->objsize, 1);
+	}
+
+	free(node);
+	return 1;
+}
+
+int tl_lrucache_evict(tl_lrucache *this)
+{
+	lru_node *node;
+
+	assert(this);
+
+	node = (lru_node *)this->last;
+	if (!node)
+		return 0;
+
+	unlink_node(this, node);
+	this->used -= node->cost;
+
+	tl_allocator_cleanup(this->objalloc, get_value(this, node),
+			     this->objsize, 1);
+	tl_hashmap_remove(&this->map, get_key(node), NULL);
+	free(node);
+	return 1;
+}
@@ -0,0 +1,380 @@
+/* perfectmap.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_perfectmap.h"
+#include "tl_array.h"
+#include "tl_hash.h"
+#include "tl_blob.h"
+#include "util/util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* average number of keys per bucket */
+#define BUCKET_SIZE 4
+
+#define MAX_SEEDS 8
+
+#define PMAP_MAGIC "TLPH"
+#define PMAP_VERSION 1
+#define HEADER_SIZE 48
+
+#define PAD8(x) (((x) + 7) & ~(size_t)7)
+
+typedef struct {
+	tl_u64 *hashes;		/* key hashes, in key order */
+	size_t *start;		/* per bucket start index into keyidx */
+	size_t *keyidx;		/* key indices, grouped by bucket */
+	size_t *order;		/* bucket indices, largest bucket first */
+	size_t *pos;		/* slot positions of the current bucket */
+	size_t *slotkey;	/* key index per slot, or count if free */
+} build_ctx;
+
+static tl_u64 get_hash(const void *key, size_t size, tl_u32 seed)
+{
+	tl_u64 hi = tl_hash_murmur3_32(key, size, seed);
+	tl_u64 lo = tl_hash_murmur3_32(key, size, seed ^ 0x9E3779B9UL);
+
+	return (hi << 32) | lo;
+}
+
+static size_t get_bucket(const tl_perfectmap *this, tl_u64 h)
+{
+	return (size_t)((h >> 32) % this->bucketcount);
+}
+
+static size_t get_slot(const tl_perfectmap *this, tl_u64 h, tl_u32 pilot)
+{
+	return (size_t)(mix64(h ^ mix64(pilot)) % this->count);
+}
+
+static size_t get_layout(size_t bucketcount, size_t count, size_t slotsize)
+{
+	return PAD8(bucketcount * sizeof(tl_u32)) + count * slotsize;
+}
+
+static int alloc_data(tl_perfectmap *this)
+{
+	this->data = calloc(1, get_layout(this->bucketcount, this->count,
+					  this->slotsize));
+	if (!this->data)
+		return 0;
+
+	this->pilots = this->data;
+	this->slots = (char *)this->data +
+		      PAD8(this->bucketcount * sizeof(tl_u32));
+	return 1;
+}
+
+/* group the keys by bucket and sort the buckets by size, descending */
+static int group_keys(tl_perfectmap *this, build_ctx *ctx,
+		      const tl_array *keys)
+{
+	size_t i, j, b, maxsize = 0, *bysize;
+
+	memset(ctx->start, 0, (this->bucketcount + 1) * sizeof(size_t));
+
+	for (i = 0; i < this->count; ++i) {
+		ctx->hashes[i] = get_hash(tl_array_at(keys, i), this->keysize,
+					  this->seed);
+		ctx->start[get_bucket(this, ctx->hashes[i]) + 1] += 1;
+	}
+
+	for (b = 0; b < this->bucketcount; ++b) {
+		if (ctx->start[b + 1] > maxsize)
+			maxsize = ctx->start[b + 1];
+		ctx->start[b + 1] += ctx->start[b];
+	}
+
+	for (i = 0; i < this->count; ++i) {
+		b = get_bucket(this, ctx->hashes[i]);
+		ctx->keyidx[ctx->start[b]++] = i;
+	}
+
+	for (b = this->bucketcount; b > 0; --b)
+		ctx->start[b] = ctx->start[b - 1];
+	ctx->start[0] = 0;
+
+	/* counting sort of the buckets by size */
+	bysize = calloc(maxsize + 2, sizeof(size_t));
+	if (!bysize)
+		return 0;
+
+	for (b = 0; b < this->bucketcount; ++b)
+		bysize[maxsize - (ctx->start[b + 1] - ctx->start[b]) + 1] += 1;
+
+	for (i = 0; i <= maxsize; ++i)
+		bysize[i + 1] += bysize[i];
+
+	for (b = 0; b < this->bucketcount; ++b) {
+		j = maxsize - (ctx->start[b + 1] - ctx->start[b]);
+		ctx->order[bysize[j]++] = b;
+	}
+
+	free(bysize);
+	return 1;
+}
+
+/* try to find a pilot for a bucket that maps its keys to free slots */
+static int place_bucket(tl_perfectmap *this, build_ctx *ctx, size_t b)
+{
+	size_t i, j, first = ctx->start[b], size = ctx->start[b + 1] - first;
+	tl_u32 pilot;
+	tl_u64 h;
+
+	/* keys with the same hash can never be placed in distinct slots */
+	for (i = 1; i < size; ++i) {
+		h = ctx->hashes[ctx->keyidx[first + i]];
+
+		for (j = 0; j < i; ++j) {
+			if (ctx->hashes[ctx->keyidx[first + j]] == h)
+				return 0;
+		}
+	}
+
+	for (pilot = 0; pilot < 0xFFFFFFFFUL; ++pilot) {
+		for (i = 0; i < size; ++i) {
+			h = ctx->hashes[ctx->keyidx[first + i]];
+			ctx->pos[i] = get_slot(this, h, pilot);
+
+			if (ctx->slotkey[ctx->pos[i]] != this->count)
+				break;
+
+			for (j = 0; j < i; ++j) {
+				if (ctx->pos[j] == ctx->pos[i])
+					break;
+			}
+
+			if (j < i)
+				break;
+		}
+
+		if (i == size)
+			break;
+	}
+
+	if (pilot == 0xFFFFFFFFUL)
+		return 0;
+
+	for (i = 0; i < size; ++i)
+		ctx->slotkey[ctx->pos[i]] = ctx->keyidx[first + i];
+
+	this->pilots[b] = pilot;
+	return 1;
+}
+
+static int build(tl_perfectmap *this, build_ctx *ctx, const tl_array *keys)
+{
+	size_t i;
+
+	if (!group_keys(this, ctx, keys))
+		return -1;
+
+	for (i = 0; i < this->count; ++i)
+		ctx->slotkey[i] = this->count;
+
+	for (i = 0; i < this->bucketcount; ++i) {
+		if (!place_bucket(this, ctx, ctx->order[i]))
+			return 0;
+	}
+
+	return 1;
+}
+
+/****************************************************************************/
+
+int tl_perfectmap_init(tl_perfectmap *this, const tl_array *keys,
+		       const tl_array *values)
+{
+	size_t i, count;
+	build_ctx ctx;
+	char *ptr;
+	int ret;
+
+	assert(this && keys && values);
+	assert(keys->used == values->used);
+
+	count = keys->used;
+
+	memset(this, 0, sizeof(*this));
+	this->count = count;
+	this->bucketcount = count / BUCKET_SIZE + 1;
+	this->keysize = keys->unitsize;
+	this->keysize_padded = PAD8(keys->unitsize);
+	this->objsize = values->unitsize;
+	this->slotsize = PAD8(this->keysize_padded + values->unitsize);
+
+	if (!alloc_data(this))
+		return 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.hashes = malloc(count * sizeof(tl_u64) + 1);
+	ctx.start = malloc((this->bucketcount + 1) * sizeof(size_t));
+	ctx.keyidx = malloc(count * sizeof(size_t) + 1);
+	ctx.order = malloc(this->bucketcount * sizeof(size_t));
+	ctx.pos = malloc(count * sizeof(size_t) + 1);
+	ctx.slotkey = malloc(count * sizeof(size_t) + 1);
+
+	ret = -1;
+
+	if (ctx.hashes && ctx.start && ctx.keyidx && ctx.order &&
+	    ctx.pos && ctx.slotkey) {
+		/*
+		    A seed fails if two keys have the same hash, retry a
+		    few times before assuming the keys are not distinct.
+		 */
+		for (i = 0; i < MAX_SEEDS; ++i) {
+			this->seed = 0x5BD1E995UL * (tl_u32)i;
+			memset(this->pilots, 0,
+			       this->bucketcount * sizeof(tl_u32));
+
+			ret = build(this, &ctx, keys);
+			if (ret != 0)
+				break;
+		}
+	}
+
+	if (ret > 0) {
+		for (i = 0; i < count; ++i) {
+			ptr = this->slots + i * this->slotsize;
+			memcpy(ptr, tl_array_at(keys, ctx.slotkey[i]),
+			       this->keysize);
+			memcpy(ptr + this->keysize_padded,
+			       tl_array_at(values, ctx.slotkey[i]),
+			       this->objsize);
+		}
+	}
+
+	free(ctx.hashes);
+	free(ctx.start);
+	free(ctx.keyidx);
+	free(ctx.order);
+	free(ctx.pos);
+	free(ctx.slotkey);
+
+	if (ret <= 0) {
+		tl_perfectmap_cleanup(this);
+		return 0;
+	}
+	return 1;
+}
+
+void tl_perfectmap_cleanup(tl_perfectmap *this)
+{
+	assert(this);
+
+	free(this->data);
+	memset(this, 0, sizeof(*this));
+}
+
+void *tl_perfectmap_at(const tl_perfectmap *this, const void *key)
+{
+	size_t idx;
+	char *ptr;
+	tl_u64 h;
+
+	assert(this && key);
+
+	if (!this->count)
+		return NULL;
+
+	h = get_hash(key, this->keysize, this->seed);
+	idx = get_slot(this, h, this->pilots[get_bucket(this, h)]);
+	ptr = this->slots + idx * this->slotsize;
+
+	if (memcmp(ptr, key, this->keysize))
+		return NULL;
+
+	return ptr + this->keysize_padded;
+}
+
+int tl_perfectmap_serialize(const tl_perfectmap *this, tl_blob *blob)
+{
+	size_t i, size;
+	unsigned char *ptr;
+
+	assert(this && blob);
+
+	size = get_layout(this->bucketcount, this->count, this->slotsize);
+
+	if (!tl_blob_init(blob, HEADER_SIZE + size, NULL))
+		return 0;
+
+	ptr = blob->data;
+	memcpy(ptr, PMAP_MAGIC, 4);
+	write_le(ptr + 4, PMAP_VERSION, 4);
+	write_le(ptr + 8, this->seed, 4);
+	write_le(ptr + 12, 0, 4);
+	write_le(ptr + 16, this->bucketcount, 8);
+	write_le(ptr + 24, this->count, 8);
+	write_le(ptr + 32, this->keysize, 8);
+	write_le(ptr + 40, this->objsize, 8);
+
+	ptr += HEADER_SIZE;
+	memcpy(ptr, this->data, size);
+
+	for (i = 0; i < this->bucketcount; ++i)
+		write_le(ptr + i * sizeof(tl_u32), this->pilots[i], 4);
+
+	return 1;
+}
+
+int tl_perfectmap_deserialize(tl_perfectmap *this, const tl_blob *blob)
+{
+	tl_u64 bucketcount, count, keysize, objsize, slotsize;
+	const unsigned char *ptr;
+	size_t i;
+
+	assert(this && blob);
+
+	if (blob->size < HEADER_SIZE)
+		return 0;
+
+	ptr = blob->data;
+	if (memcmp(ptr, PMAP_MAGIC, 4) || read_le(ptr + 4, 4) != PMAP_VERSION)
+		return 0;
+
+	bucketcount = read_le(ptr + 16, 8);
+	count = read_le(ptr + 24, 8);
+	keysize = read_le(ptr + 32, 8);
+	objsize = read_le(ptr + 40, 8);
+
+	if (bucketcount != count / BUCKET_SIZE + 1)
+		return 0;
+	if (keysize > blob->size || objsize > blob->size)
+		return 0;
+
+	slotsize = PAD8(PAD8(keysize) + objsize);
+
+	if (count && slotsize > blob->size / count)
+		return 0;
+	if (blob->size - HEADER_SIZE != get_layout(bucketcount, count,
+						   slotsize)) {
+		return 0;
+	}
+
+	memset(this, 0, sizeof(*this));
+	this->seed = read_le(ptr + 8, 4);
+	this->bucketcount = bucketcount;
+	this->count = count;
+	this->keysize = keysize;
+	this->keysize_padded = PAD8(keysize);
+	this->objsize = objsize;
+	this->slotsize = slotsize;
+
+	if (!alloc_data(this))
+		return 0;
+
+	ptr += HEADER_SIZE;
+	memcpy(this->data, ptr, blob->size - HEADER_SIZE);
+
+	for (i = 0; i < this->bucketcount; ++i)
+		this->pilots[i] = read_le(ptr + i * sizeof(tl_u32), 4);
+
+	return 1;
+}
@@ -7,13 +7,11 @@
  */
 #define TL_EXPORT
 #include "tl_allocator.h"
-#include "tl_rbtree.h"
+#include "rbtree/rbtree.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-#define IS_RED(n) ((n) && (n)->is_red)
-
 static void destroy_node(tl_rbtree_node *this, const tl_rbtree *tree)
 {
 	unsigned char *ptr;
@@ -49,7 +47,7 @@ static void flip_colors(tl_rbtree_node *this)
 	this->right->is_red = !this->right->is_red;
 }
 
-static tl_rbtree_node *rotate_right(tl_rbtree_node * this)
+tl_rbtree_node *rbtree_rotate_right(tl_rbtree_node *this)
 {
 	tl_rbtree_node *x;
 
@@ -75,13 +73,13 @@ static tl_rbtree_node *rotate_left(tl_rbtree_node *this)
 	return x;
 }
 
-static tl_rbtree_node *subtree_balance(tl_rbtree_node *this)
+tl_rbtree_node *rbtree_balance(tl_rbtree_node *this)
 {
 	if (IS_RED(this->right) && !IS_RED(this->left))
 		this = rotate_left(this);
 
 	if (IS_RED(this->left) && IS_RED(this->left->left))
-		this = rotate_right(this);
+		this = rbtree_rotate_right(this);
 
 	if (IS_RED(this->left) && IS_RED(this->right))
 		flip_colors(this);
@@ -89,12 +87,12 @@ static tl_rbtree_node *subtree_balance(tl_rbtree_node *this)
 	return this;
 }
 
-static tl_rbtree_node *move_red_left(tl_rbtree_node *this)
+tl_rbtree_node *rbtree_move_red_left(tl_rbtree_node *this)
 {
 	flip_colors(this);
 
 	if (IS_RED(this->right->left)) {
-		this->right = rotate_right(this->right);
+		this->right = rbtree_rotate_right(this->right);
 		this = rotate_left(this);
 		flip_colors(this);
 	}
@@ -102,11 +100,11 @@ static tl_rbtree_node *move_red_left(tl_rbtree_node *this)
 	return this;
 }
 
-static tl_rbtree_node *move_red_right(tl_rbtree_node *this)
+tl_rbtree_node *rbtree_move_red_right(tl_rbtree_node *this)
 {
 	flip_colors(this);
 
-	return IS_RED(this->left->left) ? rotate_right(this) : this;
+	return IS_RED(this->left->left) ? rbtree_rotate_right(this) : this;
 }
 
 static tl_rbtree_node *subtree_insert(tl_rbtree *this, tl_rbtree_node *root,
@@ -126,7 +124,7 @@ static tl_rbtree_node *subtree_insert(tl_rbtree *this, tl_rbtree_node *root,
 		root->right = subtree_insert(this, root->right, newnode);
 	}
 
-	return subtree_balance(root);
+	return rbtree_balance(root);
 }
 
 static tl_rbtree_node *remove_min_from_subtree(tl_rbtree_node *this,
@@ -138,17 +136,17 @@ static tl_rbtree_node *remove_min_from_subtree(tl_rbtree_node *this,
 	}
 
 	if (!IS_RED(this->left) && !IS_RED(this->left->left))
-		this = move_red_left(this);
+		this = rbtree_move_red_left(this);
 
 	this->left = remove_min_from_subtree(this->left, tree);
-	return subtree_balance(this);
+	return rbtree_balance(this);
 }
 
 static tl_rbtree_node *remove_max_from_subtree(tl_rbtree_node *this,
 					       tl_rbtree *tree)
 {
 	if (IS_RED(this->left))
-		this = rotate_right(this);
+		this = rbtree_rotate_right(this);
 
 	if (!this->right) {
 		destroy_node(this, tree);
@@ -156,10 +154,10 @@ static tl_rbtree_node *remove_max_from_subtree(tl_rbtree_node *this,
 	}
 
 	if (!IS_RED(this->right) && !IS_RED(this->right->left))
-		this = move_red_right(this);
+		this = rbtree_move_red_right(this);
 
 	this->right = remove_max_from_subtree(this->right, tree);
-	return subtree_balance(this);
+	return rbtree_balance(this);
 }
 
 static tl_rbtree_node *remove_from_subtree(tl_rbtree *this,
@@ -170,12 +168,12 @@ static tl_rbtree_node *remove_from_subtree(tl_rbtree *this,
 
 	if (this->compare(key, tl_rbtree_node_get_key(this, root)) < 0) {
 		if (!IS_RED(root->left) && !IS_RED(root->left->left))
-			root = move_red_left(root);
+			root = rbtree_move_red_left(root);
 
 		root->left = remove_from_subtree(this, root->left, key);
 	} else {
 		if (IS_RED(root->left))
-			root = rotate_right(root);
+			root = rbtree_rotate_right(root);
 
 		if (!this->compare(key, tl_rbtree_node_get_key(this, root))
 		    && !(root->right)) {
@@ -184,7 +182,7 @@ static tl_rbtree_node *remove_from_subtree(tl_rbtree *this,
 		}
 
 		if (!IS_RED(root->right) && !IS_RED(root->right->left))
-			root = move_red_right(root);
+			root = rbtree_move_red_right(root);
 
 		if (!this->compare(key, tl_rbtree_node_get_key(this, root))) {
 			/* find minimum of right subtree */
@@ -205,7 +203,7 @@ static tl_rbtree_node *remove_from_subtree(tl_rbtree *this,
 		}
 	}
 
-	return subtree_balance(root);
+	return rbtree_balance(root);
 }
 
 /****************************************************************************/
@@ -0,0 +1,27 @@
+/* rbtree.h -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "tl_rbtree.h"
+
+#define IS_RED(n) ((n) && (n)->is_red)
+
+/*
+    Left leaning red-black tree primitives, shared by the tl_rbtree and the
+    intrusive tl_irbtree. They only touch the links and colors of the nodes.
+ */
+tl_rbtree_node *rbtree_rotate_right(tl_rbtree_node *node);
+
+tl_rbtree_node *rbtree_balance(tl_rbtree_node *node);
+
+tl_rbtree_node *rbtree_move_red_left(tl_rbtree_node *node);
+
+tl_rbtree_node *rbtree_move_red_right(tl_rbtree_node *node);
+
+#endif /* RBTREE_H */
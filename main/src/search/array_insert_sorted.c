@@ -35,3 +35,62 @@ int tl_array_insert_sorted(tl_array *this, tl_compare cmp, const void *element)
 
 	return tl_array_append(this, element);
 }
+
+int tl_array_insert_sorted_batch(tl_array *this, tl_compare cmp,
+				 const void *data, size_t count)
+{
+	char *batch, *dst, *a, *b;
+	size_t i, j;
+
+	assert(this && cmp && data);
+
+	if (!count)
+		return 1;
+
+	if ((this->used + count) < this->used)
+		return 0;
+
+	batch = malloc(count * this->unitsize);
+	if (!batch)
+		return 0;
+
+	if (!tl_array_reserve(this, this->used + count)) {
+		free(batch);
+		return 0;
+	}
+
+	tl_allocator_copy(this->alloc, batch, data, this->unitsize, count);
+
+	if (!tl_mergesort(batch, count, this->unitsize, cmp))
+		tl_mergesort_inplace(batch, count, this->unitsize, cmp);
+
+	/*
+	    Merge from the back into the free space behind the used elements.
+	    On ties, the new element goes last, like tl_array_insert_sorted.
+	 */
+	i = this->used;
+	j = count;
+	dst = (char *)this->data + (i + j) * this->unitsize;
+
+	while (j > 0) {
+		dst -= this->unitsize;
+		b = batch + (j - 1) * this->unitsize;
+
+		if (i > 0) {
+			a = (char *)this->data + (i - 1) * this->unitsize;
+
+			if (cmp(a, b) > 0) {
+				memcpy(dst, a, this->unitsize);
+				--i;
+				continue;
+			}
+		}
+
+		memcpy(dst, b, this->unitsize);
+		--j;
+	}
+
+	this->used += count;
+	free(batch);
+	return 1;
+}
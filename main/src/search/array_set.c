@@ -0,0 +1,361 @@
+/* array_set.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_array.h"
+#include "tl_allocator.h"
+#include "../util/util.h"
+
+/* use exponential search if one array is this many times larger */
+#define GALLOP_RATIO 32
+
+typedef enum {
+	SET_UNION,
+	SET_INTERSECTION,
+	SET_DIFFERENCE
+} SET_OP;
+
+static int compare_u32(const void *a, const void *b)
+{
+	tl_u32 x = *((const tl_u32 *)a), y = *((const tl_u32 *)b);
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+	tl_u64 x = *((const tl_u64 *)a), y = *((const tl_u64 *)b);
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static tl_compare get_compare(const tl_array *arr, tl_compare cmp)
+{
+	if (cmp)
+		return cmp;
+
+	assert(arr->unitsize == sizeof(tl_u32) ||
+	       arr->unitsize == sizeof(tl_u64));
+
+	return arr->unitsize == sizeof(tl_u32) ? compare_u32 : compare_u64;
+}
+
+static void emit(tl_array *dst, const void *src, size_t count)
+{
+	tl_allocator_copy(dst->alloc,
+			  (char *)dst->data + dst->used * dst->unitsize,
+			  src, dst->unitsize, count);
+	dst->used += count;
+}
+
+/* index of the first element in [start, used) that is not less than key */
+static size_t gallop(const tl_array *arr, size_t start, const void *key,
+		     tl_compare cmp)
+{
+	size_t lo = start, hi = start, step = 1, mid;
+
+	while (hi < arr->used && cmp(tl_array_at(arr, hi), key) < 0) {
+		lo = hi + 1;
+		hi += step;
+		step *= 2;
+	}
+
+	if (hi > arr->used)
+		hi = arr->used;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+
+		if (cmp(tl_array_at(arr, mid), key) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/*
+    Walk the smaller array and locate each of its elements in the larger one
+    with an exponential search. The elements of the larger one in between
+    are either copied in bulk or skipped entirely.
+ */
+static void set_op_gallop(tl_array *dst, const tl_array *a, const tl_array *b,
+			  tl_compare cmp, SET_OP op)
+{
+	const tl_array *shorter = a->used <= b->used ? a : b;
+	const tl_array *longer = shorter == a ? b : a;
+	int keep_longer, match;
+	size_t i, p = 0, q;
+	const void *s;
+
+	keep_longer = (op == SET_UNION) ||
+		      (op == SET_DIFFERENCE && longer == a);
+
+	for (i = 0; i < shorter->used; ++i) {
+		s = tl_array_at(shorter, i);
+		q = gallop(longer, p, s, cmp);
+
+		if (keep_longer && q > p)
+			emit(dst, tl_array_at(longer, p), q - p);
+
+		p = q;
+		match = p < longer->used &&
+			cmp(tl_array_at(longer, p), s) == 0;
+
+		if (op == SET_UNION ||
+		    (op == SET_INTERSECTION && match) ||
+		    (op == SET_DIFFERENCE && shorter == a && !match)) {
+			emit(dst, s, 1);
+		}
+
+		if (match)
+			++p;
+	}
+
+	if (keep_longer && p < longer->used)
+		emit(dst, tl_array_at(longer, p), longer->used - p);
+}
+
+static void set_op_merge(tl_array *dst, const tl_array *a, const tl_array *b,
+			 tl_compare cmp, SET_OP op)
+{
+	size_t i = 0, j = 0;
+	const void *x, *y;
+	int c;
+
+	while (i < a->used && j < b->used) {
+		x = tl_array_at(a, i);
+		y = tl_array_at(b, j);
+		c = cmp(x, y);
+
+		if (c < 0) {
+			if (op != SET_INTERSECTION)
+				emit(dst, x, 1);
+			++i;
+		} else if (c > 0) {
+			if (op == SET_UNION)
+				emit(dst, y, 1);
+			++j;
+		} else {
+			if (op != SET_DIFFERENCE)
+				emit(dst, x, 1);
+			++i;
+			++j;
+		}
+	}
+
+	if (op != SET_INTERSECTION && i < a->used)
+		emit(dst, tl_array_at(a, i), a->used - i);
+
+	if (op == SET_UNION && j < b->used)
+		emit(dst, tl_array_at(b, j), b->used - j);
+}
+
+#ifdef HAVE_SSE2
+/* bit mask of the 4 elements in a that are also among the 4 elements in b */
+static unsigned int match_u32(const void *a, const void *b)
+{
+	__m128i va = _mm_loadu_si128((const __m128i *)a);
+	__m128i vb = _mm_loadu_si128((const __m128i *)b);
+	__m128i m;
+
+	m = _mm_cmpeq_epi32(va, vb);
+	m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39)));
+	m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4E)));
+	m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93)));
+
+	return _mm_movemask_ps(_mm_castsi128_ps(m));
+}
+
+/* bit mask of the 2 elements in a that are also among the 2 elements in b */
+static unsigned int match_u64(const void *a, const void *b)
+{
+	__m128i va = _mm_loadu_si128((const __m128i *)a);
+	__m128i vb = _mm_loadu_si128((const __m128i *)b);
+	__m128i e0, e1;
+
+	/* SSE2 has no 64 bit compare, both 32 bit halves have to match */
+	e0 = _mm_cmpeq_epi32(va, vb);
+	e0 = _mm_and_si128(e0, _mm_shuffle_epi32(e0, 0xB1));
+
+	e1 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4E));
+	e1 = _mm_and_si128(e1, _mm_shuffle_epi32(e1, 0xB1));
+
+	return _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(e0, e1)));
+}
+
+static tl_u64 get_int(const tl_array *arr, size_t idx)
+{
+	if (arr->unitsize == sizeof(tl_u32))
+		return ((const tl_u32 *)arr->data)[idx];
+
+	return ((const tl_u64 *)arr->data)[idx];
+}
+
+/*
+    Intersection or difference of integer sets: a block of elements from a
+    is compared against a block of elements from b at once, collecting a
+    mask of the elements of a that were found in b. Whichever block has the
+    smaller last element is done, since everything that could match it has
+    been seen. Once a block of a is done, its elements are emitted depending
+    on the mask.
+ */
+static void set_op_simd(tl_array *dst, const tl_array *a, const tl_array *b,
+			SET_OP op)
+{
+	size_t lanes = 16 / a->unitsize, i = 0, j = 0, k, start;
+	unsigned int found = 0;
+	tl_u64 amax, bmax, x;
+	int match;
+
+	while ((i + lanes) <= a->used && (j + lanes) <= b->used) {
+		if (lanes == 4) {
+			found |= match_u32(tl_array_at(a, i),
+					   tl_array_at(b, j));
+		} else {
+			found |= match_u64(tl_array_at(a, i),
+					   tl_array_at(b, j));
+		}
+
+		amax = get_int(a, i + lanes - 1);
+		bmax = get_int(b, j + lanes - 1);
+
+		if (amax <= bmax) {
+			for (k = 0; k < lanes; ++k) {
+				match = (found >> k) & 1;
+
+				if (match == (op == SET_INTERSECTION))
+					emit(dst, tl_array_at(a, i + k), 1);
+			}
+
+			i += lanes;
+			found = 0;
+		}
+
+		if (bmax <= amax)
+			j += lanes;
+	}
+
+	/*
+	    Elements of the current block of a that were already found are
+	    less than the remaining ones in b, the others may still match.
+	 */
+	for (start = i; i < a->used; ++i) {
+		if (i < start + lanes && ((found >> (i - start)) & 1)) {
+			match = 1;
+		} else {
+			x = get_int(a, i);
+
+			while (j < b->used && get_int(b, j) < x)
+				++j;
+
+			match = j < b->used && get_int(b, j) == x;
+		}
+
+		if (match == (op == SET_INTERSECTION))
+			emit(dst, tl_array_at(a, i), 1);
+	}
+}
+#endif
+
+static int set_op(tl_array *dst, const tl_array *a, const tl_array *b,
+		  tl_compare cmp, SET_OP op)
+{
+	size_t shorter, longer, count;
+
+	assert(dst && a && b && dst != a && dst != b);
+	assert(a->unitsize == b->unitsize && dst->unitsize == a->unitsize);
+
+	shorter = a->used <= b->used ? a->used : b->used;
+	longer = a->used <= b->used ? b->used : a->used;
+
+	switch (op) {
+	case SET_UNION:
+		count = a->used + b->used;
+		break;
+	case SET_INTERSECTION:
+		count = shorter;
+		break;
+	default:
+		count = a->used;
+		break;
+	}
+
+	tl_array_clear(dst);
+
+	if (!tl_array_reserve(dst, count))
+		return 0;
+
+	if (shorter && (longer / GALLOP_RATIO) > shorter) {
+		set_op_gallop(dst, a, b, get_compare(a, cmp), op);
+#ifdef HAVE_SSE2
+	} else if (!cmp && op != SET_UNION) {
+		assert(a->unitsize == sizeof(tl_u32) ||
+		       a->unitsize == sizeof(tl_u64));
+		set_op_simd(dst, a, b, op);
+#endif
+	} else {
+		set_op_merge(dst, a, b, get_compare(a, cmp), op);
+	}
+
+	tl_array_try_shrink(dst);
+	return 1;
+}
+
+/****************************************************************************/
+
+void tl_array_unique(tl_array *this, tl_compare cmp)
+{
+	size_t i, count = 1;
+	char *last, *ptr;
+
+	assert(this);
+
+	if (this->used < 2)
+		return;
+
+	cmp = get_compare(this, cmp);
+	last = this->data;
+
+	for (i = 1; i < this->used; ++i) {
+		ptr = (char *)this->data + i * this->unitsize;
+
+		if (!cmp(last, ptr)) {
+			tl_allocator_cleanup(this->alloc, ptr,
+					     this->unitsize, 1);
+			continue;
+		}
+
+		last += this->unitsize;
+		if (last != ptr)
+			memcpy(last, ptr, this->unitsize);
+		++count;
+	}
+
+	this->used = count;
+	tl_array_try_shrink(this);
+}
+
+int tl_array_union(tl_array *dst, const tl_array *a, const tl_array *b,
+		   tl_compare cmp)
+{
+	return set_op(dst, a, b, cmp, SET_UNION);
+}
+
+int tl_array_intersection(tl_array *dst, const tl_array *a,
+			  const tl_array *b, tl_compare cmp)
+{
+	return set_op(dst, a, b, cmp, SET_INTERSECTION);
+}
+
+int tl_array_difference(tl_array *dst, const tl_array *a, const tl_array *b,
+			tl_compare cmp)
+{
+	return set_op(dst, a, b, cmp, SET_DIFFERENCE);
+}
@@ -0,0 +1,234 @@
+/* searchindex.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_searchindex.h"
+#include "tl_array.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GNUC__
+	#define PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+	#define PREFETCH(ptr)
+#endif
+
+/*
+    The 16 descendants of a node four levels down are stored next to each
+    other, starting at position 16k. Prefetching the first and the last of
+    them while working on the levels in between hides most of the memory
+    latency, since for small elements they span at most two cache lines.
+ */
+#define PREFETCH_DISTANCE 16
+
+/*
+    The elements are stored cache line aligned, so that for power of two
+    element sizes up to 4 bytes the descendants fill exactly one line and
+    for 8 byte elements two lines, instead of straddling up to three.
+ */
+#define CACHE_LINE 64
+
+/*
+    Prefetch the descendants of position k, if there are any. The first one
+    exists if k <= count / PREFETCH_DISTANCE, the index is padded with
+    enough elements that the last one can then be addressed as well.
+ */
+#define PREFETCH_DESCENDANTS(k) \
+	do { \
+		if ((k) <= limit) { \
+			PREFETCH(data + PREFETCH_DISTANCE * (k) * unitsize); \
+			PREFETCH(data + (PREFETCH_DISTANCE * (k) + \
+					 PREFETCH_DISTANCE - 1) * unitsize); \
+		} \
+	} while (0)
+
+/* descend the tree comparing integer elements inline, without callbacks */
+#define DESCEND_INT(T, op) \
+	do { \
+		const T *base = (const T *)data; \
+		T x = *((const T *)key); \
+		\
+		for (; k <= count; ++level) { \
+			if (k <= limit) { \
+				PREFETCH(base + PREFETCH_DISTANCE * k); \
+				PREFETCH(base + PREFETCH_DISTANCE * k + \
+					 PREFETCH_DISTANCE - 1); \
+			} \
+			k = 2 * k + (base[k] op x); \
+		} \
+	} while (0)
+
+/* fill the subtree at position k with an in order walk of the array */
+static size_t build(tl_searchindex *this, size_t i, size_t k)
+{
+	if (k <= this->count) {
+		i = build(this, i, 2 * k);
+
+		memcpy(this->data + k * this->unitsize,
+		       tl_array_at(this->array, i++), this->unitsize);
+
+		i = build(this, i, 2 * k + 1);
+	}
+	return i;
+}
+
+/*
+    Compute the index in the original array of the element at position k,
+    which is on a given level of the tree. If the last level were completely
+    filled, the elements in order would alternate between the last level and
+    the ones above. Hence, the position is computed for a full tree and the
+    number of missing elements on the last level in front of it is subtracted.
+ */
+static size_t get_rank(const tl_searchindex *this, size_t k,
+		       unsigned int level)
+{
+	size_t r, missing;
+
+	k -= (size_t)1 << level;
+	r = ((2 * k + 1) << (this->levels - 1 - level)) - 1;
+
+	missing = (r + 1) / 2;
+	missing = missing > this->last_level ? missing - this->last_level : 0;
+
+	return r - missing;
+}
+
+static int is_equal(const tl_searchindex *this, const void *key,
+		    const void *element)
+{
+	if (this->compare)
+		return this->compare(key, element) == 0;
+
+	return memcmp(key, element, this->unitsize) == 0;
+}
+
+/*
+    Every step goes to the left child if the element is not less than the
+    key (or, for the upper bound, greater than the key), i.e. if comparing
+    the key to it yields less than the threshold. Going left sets a 0 bit,
+    going right a 1 bit. After falling off the tree, the last node where the
+    search went left is the answer, found by stripping the trailing 1 bits
+    and the 0 bit in front of them. If the search never went left, this
+    yields position 0.
+ */
+static size_t search(const tl_searchindex *this, const void *key,
+		     int threshold)
+{
+	size_t k = 1, count = this->count, unitsize = this->unitsize;
+	size_t limit = count / PREFETCH_DISTANCE;
+	const char *data = this->data;
+	unsigned int level = 0;
+
+	if (this->compare) {
+		for (; k <= count; ++level) {
+			PREFETCH_DESCENDANTS(k);
+			k = 2 * k + (this->compare(key, data + k * unitsize) >=
+				     threshold);
+		}
+	} else if (unitsize == sizeof(tl_u32)) {
+		if (threshold)
+			DESCEND_INT(tl_u32, <);
+		else
+			DESCEND_INT(tl_u32, <=);
+	} else {
+		if (threshold)
+			DESCEND_INT(tl_u64, <);
+		else
+			DESCEND_INT(tl_u64, <=);
+	}
+
+	while (k & 1) {
+		k >>= 1;
+		--level;
+	}
+
+	if (k < 2)
+		return this->count;
+
+	return get_rank(this, k >> 1, level - 1);
+}
+
+/****************************************************************************/
+
+int tl_searchindex_init(tl_searchindex *this, const tl_array *array,
+			tl_compare cmp)
+{
+	size_t size, addr;
+
+	assert(this && array);
+	assert(cmp || array->unitsize == sizeof(tl_u32) ||
+	       array->unitsize == sizeof(tl_u64));
+
+	memset(this, 0, sizeof(*this));
+
+	size = array->used + PREFETCH_DISTANCE;
+	if ((size * array->unitsize) / array->unitsize != size)
+		return 0;
+
+	this->mem = malloc(size * array->unitsize + CACHE_LINE);
+	if (!this->mem)
+		return 0;
+
+	addr = (size_t)this->mem;
+	if (addr % CACHE_LINE)
+		addr += CACHE_LINE - addr % CACHE_LINE;
+
+	this->data = (char *)addr;
+
+	this->array = array;
+	this->count = array->used;
+	this->unitsize = array->unitsize;
+	this->compare = cmp;
+
+	while ((this->count >> this->levels) != 0)
+		++this->levels;
+
+	if (this->levels)
+		this->last_level = this->count -
+				   (((size_t)1 << (this->levels - 1)) - 1);
+
+	build(this, 0, 1);
+	return 1;
+}
+
+void tl_searchindex_cleanup(tl_searchindex *this)
+{
+	assert(this);
+
+	free(this->mem);
+	memset(this, 0, sizeof(*this));
+}
+
+size_t tl_searchindex_lower_bound(const tl_searchindex *this, const void *key)
+{
+	assert(this && key);
+	return search(this, key, 1);
+}
+
+size_t tl_searchindex_upper_bound(const tl_searchindex *this, const void *key)
+{
+	assert(this && key);
+	return search(this, key, 0);
+}
+
+void *tl_searchindex_find(const tl_searchindex *this, const void *key)
+{
+	size_t i;
+
+	assert(this && key);
+
+	i = search(this, key, 1);
+
+	if (i >= this->count)
+		return NULL;
+
+	if (!is_equal(this, key, tl_array_at(this->array, i)))
+		return NULL;
+
+	return tl_array_at(this->array, i);
+}
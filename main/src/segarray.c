@@ -0,0 +1,184 @@
+/* segarray.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_EXPORT
+#include "tl_allocator.h"
+#include "tl_segarray.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_CHUNK_BYTES 4096
+#define MIN_TABLE_SIZE 8
+
+static int add_chunk(tl_segarray *this)
+{
+	size_t size;
+	char **new;
+
+	if (this->chunkcount == this->tablesize) {
+		size = this->tablesize ? this->tablesize * 2 : MIN_TABLE_SIZE;
+
+		if (size < this->tablesize)
+			return 0;
+
+		new = realloc(this->chunks, size * sizeof(this->chunks[0]));
+		if (!new)
+			return 0;
+
+		this->chunks = new;
+		this->tablesize = size;
+	}
+
+	this->chunks[this->chunkcount] = malloc(this->unitsize <<
+						this->shift);
+
+	if (!this->chunks[this->chunkcount])
+		return 0;
+
+	this->chunkcount += 1;
+	return 1;
+}
+
+static void cleanup_range(tl_segarray *this, size_t idx, size_t count)
+{
+	size_t run;
+	void *ptr;
+
+	if (!this->alloc)
+		return;
+
+	while (count) {
+		ptr = tl_segarray_get_segment(this, idx, &run);
+		if (run > count)
+			run = count;
+
+		tl_allocator_cleanup(this->alloc, ptr, this->unitsize, run);
+		idx += run;
+		count -= run;
+	}
+}
+
+/****************************************************************************/
+
+void tl_segarray_init(tl_segarray *this, size_t elementsize,
+		      size_t chunksize, tl_allocator *alloc)
+{
+	unsigned int shift = 0;
+
+	assert(this && elementsize);
+
+	if (!chunksize) {
+		chunksize = DEFAULT_CHUNK_BYTES / elementsize;
+		if (!chunksize)
+			chunksize = 1;
+	}
+
+	while (((size_t)1 << shift) < chunksize)
+		++shift;
+
+	memset(this, 0, sizeof(*this));
+	this->unitsize = elementsize;
+	this->shift = shift;
+	this->alloc = alloc;
+}
+
+void tl_segarray_cleanup(tl_segarray *this)
+{
+	size_t i;
+
+	assert(this);
+
+	cleanup_range(this, 0, this->used);
+
+	for (i = 0; i < this->chunkcount; ++i)
+		free(this->chunks[i]);
+
+	free(this->chunks);
+
+	this->chunks = NULL;
+	this->chunkcount = 0;
+	this->tablesize = 0;
+	this->used = 0;
+}
+
+void tl_segarray_clear(tl_segarray *this)
+{
+	assert(this);
+
+	cleanup_range(this, 0, this->used);
+	this->used = 0;
+}
+
+int tl_segarray_reserve(tl_segarray *this, size_t size)
+{
+	assert(this);
+
+	while ((this->chunkcount << this->shift) < size) {
+		if (!add_chunk(this))
+			return 0;
+	}
+
+	return 1;
+}
+
+int tl_segarray_append(tl_segarray *this, const void *element)
+{
+	assert(this && element);
+
+	if (this->used == (this->chunkcount << this->shift) &&
+	    !add_chunk(this)) {
+		return 0;
+	}
+
+	this->used += 1;
+	tl_allocator_copy(this->alloc, tl_segarray_at(this, this->used - 1),
+			  element, this->unitsize, 1);
+	return 1;
+}
+
+int tl_segarray_append_array(tl_segarray *this, const void *data,
+			     size_t count)
+{
+	const char *src = data;
+	size_t idx, run;
+	void *ptr;
+
+	assert(this && data);
+
+	if ((this->used + count) < this->used)
+		return 0;
+
+	if (!tl_segarray_reserve(this, this->used + count))
+		return 0;
+
+	idx = this->used;
+	this->used += count;
+
+	while (count) {
+		ptr = tl_segarray_get_segment(this, idx, &run);
+		if (run > count)
+			run = count;
+
+		tl_allocator_copy(this->alloc, ptr, src, this->unitsize, run);
+		src += run * this->unitsize;
+		idx += run;
+		count -= run;
+	}
+	return 1;
+}
+
+void tl_segarray_remove_last(tl_segarray *this, size_t count)
+{
+	assert(this);
+
+	if (count > this->used)
+		count = this->used;
+
+	cleanup_range(this, this->used - count, count);
+	this->used -= count;
+}
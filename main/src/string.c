@@ -61,6 +61,7 @@ void tl_string_init_local(tl_string * this, const char *data)
 	this->data.unitsize = 1;
 	this->data.data = (void *)data;
 	this->data.alloc = NULL;
+	this->data.inline_data = NULL;
 	this->mbseq = mbseq;
 	this->charcount = u8count;
 }
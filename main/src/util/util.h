@@ -0,0 +1,70 @@
+/* util.h -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#ifndef UTIL_H
+#define UTIL_H
+
+#include "tl_predef.h"
+
+/* SSE2 is always available on x86_64 and can be enabled on 32 bit x86 */
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define HAVE_SSE2
+#endif
+
+/* mix up the bits of a 64 bit value with the MurmurHash3 finalizer */
+static TL_INLINE tl_u64 mix64(tl_u64 h)
+{
+	h ^= h >> 33;
+	h *= ((tl_u64)0xff51afd7UL << 32) | 0xed558ccdUL;
+	h ^= h >> 33;
+	h *= ((tl_u64)0xc4ceb9feUL << 32) | 0x1a85ec53UL;
+	h ^= h >> 33;
+	return h;
+}
+
+/* index of the lowest set bit, the mask must not be zero */
+static TL_INLINE unsigned int lowest_bit(unsigned int mask)
+{
+#ifdef __GNUC__
+	return __builtin_ctz(mask);
+#else
+	unsigned int i = 0;
+
+	while (!(mask & 1)) {
+		mask >>= 1;
+		++i;
+	}
+	return i;
+#endif
+}
+
+/* store the lowest bytes of a value in little endian byte order */
+static TL_INLINE void write_le(unsigned char *ptr, tl_u64 value,
+			       size_t bytes)
+{
+	size_t i;
+
+	for (i = 0; i < bytes; ++i) {
+		ptr[i] = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+/* read a little endian value of the given number of bytes */
+static TL_INLINE tl_u64 read_le(const unsigned char *ptr, size_t bytes)
+{
+	tl_u64 value = 0;
+
+	while (bytes--)
+		value = (value << 8) | ptr[bytes];
+
+	return value;
+}
+
+#endif /* UTIL_H */
@@ -0,0 +1,257 @@
+/*
+ * tl_filearray.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file tl_filearray.h
+ *
+ * \brief Contains an array that stores its elements in a mapped file
+ */
+#ifndef TOOLS_FILEARRAY_H
+#define TOOLS_FILEARRAY_H
+
+/**
+ * \page containers Containers
+ *
+ * \section tl_filearray File backed array
+ *
+ * A \ref tl_array keeps its elements on the heap, so it cannot hold more
+ * data than fits into memory. The tl_filearray instead stores its elements
+ * in a file that is mapped into memory using \ref tl_file. The operating
+ * system pages the data in and out of the page cache as needed, which
+ * allows working with data sets larger than the physical memory.
+ *
+ * The file starts with a small header that records the element size and
+ * the number of elements, so a file written earlier can be opened again and
+ * its elements are immediately accessible.
+ *
+ * When the array runs out of space, the file is extended and mapped again.
+ * Like a \ref tl_array, the reserved space grows in powers of two, so
+ * appending has constant amortized cost.
+ *
+ * Changes are written back to the file by the operating system at some
+ * point, \ref tl_filearray_flush can be used to write them back right away.
+ *
+ * The elements are stored byte-wise in the file, in the byte order of the
+ * machine. Since the file contents are accessed through pointers, elements
+ * must not contain pointers and there is no allocator support.
+ *
+ * \note Never keep pointers to elements inside a tl_filearray. When the file
+ *       is mapped again, the memory location of the data can change,
+ *       rendering the pointers invalid.
+ */
+
+#include "tl_predef.h"
+#include "tl_file.h"
+
+/**
+ * \struct tl_filearray
+ *
+ * \brief An array that stores its elements in a memory mapped file
+ *
+ * For a detailed description, see \ref tl_filearray.
+ */
+struct tl_filearray {
+	/** \brief The underlying file */
+	tl_file *file;
+
+	/** \brief The current mapping of the file */
+	const tl_file_mapping *mapping;
+
+	/** \brief Pointer to the first element, inside the mapping */
+	void *data;
+
+	/** \brief Number of elements the mapping has room for */
+	size_t reserved;
+
+	/** \brief Number of elements used */
+	size_t used;
+
+	/** \brief Size of a single element in bytes */
+	size_t unitsize;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Open or create a file backed array
+ *
+ * \memberof tl_filearray
+ *
+ * If the file is empty, a new array is created in it. Otherwise, the file
+ * must contain an array with the same element size.
+ *
+ * \param arr         A pointer to an uninitialized file backed array
+ * \param path        An UTF-8 encoded path of the file
+ * \param elementsize The size of a single element in bytes
+ * \param flags       Either zero or a combination of \ref TL_CREATE to
+ *                    create the file if it does not exist and
+ *                    \ref TL_OVERWRITE to drop the contents of an existing
+ *                    file
+ *
+ * \return Zero on success, a negative \ref TL_ERROR_CODE value on failure.
+ *         \ref TL_ERR_ARG if the file does not contain a valid array with
+ *         the given element size.
+ */
+TLOSAPI int tl_filearray_open(tl_filearray *arr, const char *path,
+			      size_t elementsize, int flags);
+
+/**
+ * \brief Unmap and close a file backed array
+ *
+ * \memberof tl_filearray
+ *
+ * The elements are kept in the file. This does not wait for the data to be
+ * written, use \ref tl_filearray_flush for that.
+ *
+ * \param arr A pointer to a file backed array
+ */
+TLOSAPI void tl_filearray_cleanup(tl_filearray *arr);
+
+/**
+ * \brief Make sure a file backed array has room for a number of elements
+ *        without remapping the file
+ *
+ * \memberof tl_filearray
+ *
+ * \param arr  A pointer to a file backed array
+ * \param size The number of elements to reserve space for
+ *
+ * \return Zero on success, a negative \ref TL_ERROR_CODE value on failure
+ */
+TLOSAPI int tl_filearray_reserve(tl_filearray *arr, size_t size);
+
+/**
+ * \brief Change the number of elements in a file backed array
+ *
+ * \memberof tl_filearray
+ *
+ * New elements are initialized to zero. Shrinking the array does not
+ * shrink the file.
+ *
+ * \param arr  A pointer to a file backed array
+ * \param size The new number of elements
+ *
+ * \return Zero on success, a negative \ref TL_ERROR_CODE value on failure
+ */
+TLOSAPI int tl_filearray_resize(tl_filearray *arr, size_t size);
+
+/**
+ * \brief Append an element to a file backed array
+ *
+ * \memberof tl_filearray
+ *
+ * \note This function runs in constant amortized time
+ *
+ * \param arr     A pointer to a file backed array
+ * \param element A pointer to the element to copy into the array
+ *
+ * \return Zero on success, a negative \ref TL_ERROR_CODE value on failure
+ */
+TLOSAPI int tl_filearray_append(tl_filearray *arr, const void *element);
+
+/**
+ * \brief Append a range of elements to a file backed array
+ *
+ * \memberof tl_filearray
+ *
+ * \note This function runs in linear time
+ *
+ * \param arr   A pointer to a file backed array
+ * \param data  A pointer to the elements to copy into the array
+ * \param count The number of elements to append
+ *
+ * \return Zero on success, a negative \ref TL_ERROR_CODE value on failure
+ */
+TLOSAPI int tl_filearray_append_array(tl_filearray *arr, const void *data,
+				      size_t count);
+
+/**
+ * \brief Write the contents of a file backed array back to the file
+ *
+ * \memberof tl_filearray
+ *
+ * \note This function blocks until the data has been written
+ *
+ * \param arr A pointer to a file backed array
+ */
+TLOSAPI void tl_filearray_flush(tl_filearray *arr);
+
+/**
+ * \brief Get a pointer to an element in a file backed array
+ *
+ * \memberof tl_filearray
+ *
+ * \param arr A pointer to a file backed array
+ * \param idx The index of the element
+ *
+ * \return A pointer to the element or NULL if the index is out of bounds
+ */
+static TL_INLINE void *tl_filearray_at(const tl_filearray *arr, size_t idx)
+{
+	assert(arr);
+
+	if (idx >= arr->used)
+		return NULL;
+
+	return (char *)arr->data + idx * arr->unitsize;
+}
+
+/**
+ * \brief Get the number of elements currently in a file backed array
+ *
+ * \memberof tl_filearray
+ *
+ * \param arr A pointer to a file backed array
+ *
+ * \return The number of elements in the array
+ */
+static TL_INLINE size_t tl_filearray_get_size(const tl_filearray *arr)
+{
+	assert(arr);
+	return arr->used;
+}
+
+/**
+ * \brief Returns non-zero if a given file backed array contains no elements
+ *
+ * \memberof tl_filearray
+ *
+ * \param arr A pointer to a file backed array
+ *
+ * \return Non-zero if the array is empty, zero if not
+ */
+static TL_INLINE int tl_filearray_is_empty(const tl_filearray *arr)
+{
+	assert(arr);
+	return arr->used == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOOLS_FILEARRAY_H */
+
@@ -0,0 +1,94 @@
+/*
+ * tl_parallel.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_parallel.h
+ *
+ * \brief Contains bulk operations that run in parallel on a thread pool
+ */
+#ifndef TOOLS_PARALLEL_H
+#define TOOLS_PARALLEL_H
+
+/**
+ * \page conc Concurrency
+ *
+ * \section parallel Parallel bulk operations
+ *
+ * Some data structures can be built much faster from a large amount of
+ * data at once, if the work is split up into independent pieces that are
+ * processed by the worker threads of a \ref tl_threadpool.
+ *
+ * The following bulk operations are currently available:
+ * \li \ref tl_hashmap_from_arrays fills a \ref tl_hashmap from an array of
+ *     keys and an array of values
+ */
+
+#include "tl_predef.h"
+#include "tl_threadpool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Fill an empty hash map from an array of keys and an array of values
+ *
+ * \memberof tl_hashmap
+ *
+ * \note This function runs in linear time, divided by the number of worker
+ *       threads of the pool.
+ *
+ * The result is the same as inserting the key value pairs in array order
+ * using \ref tl_hashmap_insert, i.e. if a key occurs multiple times, the
+ * last occurrence shadows the others.
+ *
+ * The bins of the map are first resized to hold all entries within the
+ * maximum load set with \ref tl_hashmap_set_max_load (or one entry per bin
+ * if the map does not grow), but never shrunk. The keys are then hashed
+ * in parallel, partitioned by disjoint ranges of bins and each range is
+ * filled by a different task, each with its own block of overflow entries.
+ *
+ * If the map uses allocators, their copy functions are called from
+ * multiple worker threads simultaneously.
+ *
+ * \param map    A pointer to an initialized, empty hash map
+ * \param keys   An array of key objects, with the key size of the map
+ * \param values An array of value objects, with the value size of the map
+ *               and the same number of elements as the key array
+ * \param pool   A pointer to a thread pool to run the work on
+ *
+ * \return Non-zero on success, zero if out of memory or the map is not
+ *         empty. On failure, the map is left unchanged.
+ */
+TLOSAPI int tl_hashmap_from_arrays(tl_hashmap *map, const tl_array *keys,
+				   const tl_array *values,
+				   tl_threadpool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOOLS_PARALLEL_H */
+
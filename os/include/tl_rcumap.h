@@ -0,0 +1,237 @@
+/*
+ * tl_rcumap.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_rcumap.h
+ *
+ * \brief Contains a read mostly hash map with lock free readers
+ */
+#ifndef TOOLS_RCUMAP_H
+#define TOOLS_RCUMAP_H
+
+/**
+ * \page conc Concurrency
+ *
+ * \section rcumap Read mostly hash map
+ *
+ * A tl_rcumap is a hash map for data that is read very frequently by
+ * multiple threads, but only updated occasionally, e.g. a routing table.
+ *
+ * The map holds a pointer to the current version of a \ref tl_hashmap,
+ * which is never modified once it is published. A writer creates a copy of
+ * the current version, modifies the copy using the regular \ref tl_hashmap
+ * functions and then atomically replaces the pointer to the current version
+ * with a pointer to the copy. Writers are serialized by a \ref tl_mutex.
+ *
+ * Readers never take a lock. Every reader thread registers a
+ * \ref tl_rcumap_reader with the map once. A read side critical section,
+ * started with \ref tl_rcumap_read_begin and ended with
+ * \ref tl_rcumap_read_end, only loads the current version pointer and
+ * stores the current epoch in the reader object. The reader object is
+ * padded to a cache line of its own, so readers never write to memory that
+ * is shared with another thread and never wait for anything.
+ *
+ * Whenever a new version is published, the epoch is incremented and the
+ * old version is retired. A retired version is freed by a later writer,
+ * once every reader is either outside of a critical section or has entered
+ * its current one after the version was retired (epoch based reclamation).
+ *
+ * A reader must not hold on to pointers into a version after ending its
+ * critical section. A critical section should be kept short, since it
+ * delays freeing of retired versions.
+ */
+
+#include "tl_predef.h"
+
+/**
+ * \struct tl_rcumap
+ *
+ * \brief A read mostly hash map with lock free readers
+ *
+ * For a detailed description, see \ref rcumap
+ */
+
+/**
+ * \struct tl_rcumap_reader
+ *
+ * \brief A registered reader of a tl_rcumap, used by a single thread
+ *
+ * For a detailed description, see \ref rcumap
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Create a read mostly hash map
+ *
+ * \memberof tl_rcumap
+ *
+ * The arguments are passed on to \ref tl_hashmap_init for the initial,
+ * empty version of the map. Later versions are copies of their predecessor.
+ *
+ * \param keysize    The size of a key object
+ * \param objsize    The size of a value object
+ * \param bincount   The initial number of bins
+ * \param keyhash    A function to compute a hash of a key
+ * \param keycompare A function to compare two key objects for equality
+ * \param keyalloc   A pointer to an allocator for keys or NULL if not used
+ * \param valalloc   A pointer to an allocator for values or NULL if not used
+ *
+ * \return A pointer to a read mostly hash map on success, NULL on failure
+ */
+TLOSAPI tl_rcumap *tl_rcumap_create(size_t keysize, size_t objsize,
+				    size_t bincount, tl_hash keyhash,
+				    tl_compare keycompare,
+				    tl_allocator *keyalloc,
+				    tl_allocator *valalloc);
+
+/**
+ * \brief Destroy a read mostly hash map and all its versions
+ *
+ * \memberof tl_rcumap
+ *
+ * \note This function is NOT thread safe. All readers must have been
+ *       destroyed and no other thread may access the map while or after it
+ *       is destroyed.
+ *
+ * \param map A pointer to a read mostly hash map
+ */
+TLOSAPI void tl_rcumap_destroy(tl_rcumap *map);
+
+/**
+ * \brief Register a reader with a read mostly hash map
+ *
+ * \memberof tl_rcumap
+ *
+ * This function is thread safe, but may wait for a writer.
+ *
+ * \param map A pointer to a read mostly hash map
+ *
+ * \return A pointer to a reader object or NULL on failure
+ */
+TLOSAPI tl_rcumap_reader *tl_rcumap_reader_create(tl_rcumap *map);
+
+/**
+ * \brief Unregister and destroy a reader of a read mostly hash map
+ *
+ * \memberof tl_rcumap_reader
+ *
+ * This function is thread safe, but may wait for a writer. The reader must
+ * not be inside a critical section.
+ *
+ * \param reader A pointer to a reader object
+ */
+TLOSAPI void tl_rcumap_reader_destroy(tl_rcumap_reader *reader);
+
+/**
+ * \brief Start a read side critical section and get the current version
+ *
+ * \memberof tl_rcumap_reader
+ *
+ * This function is wait free. It does not take any locks and only writes to
+ * the reader object. Critical sections of the same reader cannot be nested.
+ *
+ * \param reader A pointer to a reader object
+ *
+ * \return A pointer to the current version of the map. The version must not
+ *         be modified and remains valid until \ref tl_rcumap_read_end is
+ *         called.
+ */
+TLOSAPI const tl_hashmap *tl_rcumap_read_begin(tl_rcumap_reader *reader);
+
+/**
+ * \brief End a read side critical section
+ *
+ * \memberof tl_rcumap_reader
+ *
+ * This function is wait free.
+ *
+ * \param reader A pointer to a reader object
+ */
+TLOSAPI void tl_rcumap_read_end(tl_rcumap_reader *reader);
+
+/**
+ * \brief Start modifying a read mostly hash map
+ *
+ * \memberof tl_rcumap
+ *
+ * Locks out other writers and creates a copy of the current version of the
+ * map. The copy can be modified using the regular \ref tl_hashmap functions
+ * and has to be published with \ref tl_rcumap_update_commit or discarded
+ * with \ref tl_rcumap_update_abort.
+ *
+ * \note This function runs in linear time
+ *
+ * \param map A pointer to a read mostly hash map
+ *
+ * \return A pointer to the new version of the map or NULL if out of memory
+ */
+TLOSAPI tl_hashmap *tl_rcumap_update_begin(tl_rcumap *map);
+
+/**
+ * \brief Publish the version created by \ref tl_rcumap_update_begin
+ *
+ * \memberof tl_rcumap
+ *
+ * The new version becomes visible to all readers that start a critical
+ * section afterwards. The previous version is retired and all retired
+ * versions that are no longer in use are freed.
+ *
+ * \param map A pointer to a read mostly hash map
+ */
+TLOSAPI void tl_rcumap_update_commit(tl_rcumap *map);
+
+/**
+ * \brief Discard the version created by \ref tl_rcumap_update_begin
+ *
+ * \memberof tl_rcumap
+ *
+ * \param map A pointer to a read mostly hash map
+ */
+TLOSAPI void tl_rcumap_update_abort(tl_rcumap *map);
+
+/**
+ * \brief Free all retired versions of a map that are no longer in use
+ *
+ * \memberof tl_rcumap
+ *
+ * This is done automatically when publishing a new version, but can be used
+ * to release memory earlier once readers have left their critical sections.
+ * This function is thread safe, but may wait for a writer.
+ *
+ * \param map A pointer to a read mostly hash map
+ *
+ * \return The number of retired versions that are still in use
+ */
+TLOSAPI size_t tl_rcumap_reclaim(tl_rcumap *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOOLS_RCUMAP_H */
+
@@ -0,0 +1,193 @@
+/*
+ * tl_sharedcache.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_sharedcache.h
+ *
+ * \brief Contains a thread safe LRU cache implementation
+ */
+#ifndef TOOLS_SHAREDCACHE_H
+#define TOOLS_SHAREDCACHE_H
+
+/**
+ * \page conc Concurrency
+ *
+ * \section sharedcache Shared LRU cache
+ *
+ * A tl_sharedcache is an LRU cache that can be accessed by multiple threads
+ * simultaneously, for instance by the worker threads of a
+ * \ref tl_threadpool.
+ *
+ * Like the \ref sharedmap, the cache is split up into a number of shards,
+ * each of which is a \ref tl_lrucache of its own, protected by its own
+ * \ref tl_mutex. The shard of an entry is determined from the hash of its
+ * key and the capacity is evenly divided among the shards.
+ *
+ * Since every lookup also updates the order of use, the shards use plain
+ * mutexes instead of read/write locks. Eviction happens independently per
+ * shard, so the evicted entry is the least recently used one within its
+ * shard, which approximates the global LRU order for well distributed keys.
+ *
+ * Values are copied into and out of the cache under the lock of their shard.
+ *
+ * For a function reference, see \ref tl_sharedcache.
+ */
+
+#include "tl_predef.h"
+
+/**
+ * \struct tl_sharedcache
+ *
+ * \brief A sharded, thread safe LRU cache
+ *
+ * For a detailed description, see \ref sharedcache
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Create a shared LRU cache
+ *
+ * \memberof tl_sharedcache
+ *
+ * \param keysize    The size of a key object
+ * \param objsize    The size of a value object
+ * \param capacity   The maximum sum of the costs of all entries, divided
+ *                   evenly among the shards
+ * \param shards     The number of independently locked shards. Zero to use
+ *                   a default value.
+ * \param keyhash    A function to compute a hash of a key
+ * \param keycompare A function to compare two key objects for equality
+ * \param keyalloc   A pointer to an allocator for keys or NULL if not used
+ * \param valalloc   A pointer to an allocator for values or NULL if not used
+ *
+ * \return A pointer to a shared LRU cache on success, NULL on failure
+ */
+TLOSAPI tl_sharedcache *tl_sharedcache_create(size_t keysize, size_t objsize,
+					      size_t capacity,
+					      unsigned int shards,
+					      tl_hash keyhash,
+					      tl_compare keycompare,
+					      tl_allocator *keyalloc,
+					      tl_allocator *valalloc);
+
+/**
+ * \brief Destroy a shared LRU cache and free all its entries
+ *
+ * \memberof tl_sharedcache
+ *
+ * \note This function is NOT thread safe. No other thread may access the
+ *       cache while or after it is destroyed.
+ *
+ * \param cache A pointer to a shared LRU cache
+ */
+TLOSAPI void tl_sharedcache_destroy(tl_sharedcache *cache);
+
+/**
+ * \brief Remove all entries from a shared LRU cache
+ *
+ * \memberof tl_sharedcache
+ *
+ * This function is thread safe. The shards are cleared one after another,
+ * so other threads may observe a partially cleared cache.
+ *
+ * \param cache A pointer to a shared LRU cache
+ */
+TLOSAPI void tl_sharedcache_clear(tl_sharedcache *cache);
+
+/**
+ * \brief Add or overwrite an entry in a shared LRU cache
+ *
+ * \memberof tl_sharedcache
+ *
+ * This function is thread safe. See \ref tl_lrucache_put for details.
+ *
+ * \param cache  A pointer to a shared LRU cache
+ * \param key    A pointer to the key object
+ * \param object A pointer to the value object to copy into the cache
+ * \param cost   The cost of the entry, counted against the capacity
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLOSAPI int tl_sharedcache_put(tl_sharedcache *cache, const void *key,
+			       const void *object, size_t cost);
+
+/**
+ * \brief Get a copy of a value stored in a shared LRU cache
+ *
+ * \memberof tl_sharedcache
+ *
+ * This function is thread safe. The entry is marked as most recently used
+ * within its shard.
+ *
+ * \param cache  A pointer to a shared LRU cache
+ * \param key    A pointer to the key object to look for
+ * \param object If not NULL, receives a copy of the stored value, created
+ *               using the value allocator of the cache.
+ *
+ * \return Non-zero if the key was found, zero if not
+ */
+TLOSAPI int tl_sharedcache_get(tl_sharedcache *cache, const void *key,
+			       void *object);
+
+/**
+ * \brief Remove an entry from a shared LRU cache
+ *
+ * \memberof tl_sharedcache
+ *
+ * This function is thread safe.
+ *
+ * \param cache  A pointer to a shared LRU cache
+ * \param key    A pointer to the key object to look for
+ * \param object If not NULL, the value is memcopied to this location
+ *               instead of being cleaned up.
+ *
+ * \return Non-zero if the entry was found, zero if not
+ */
+TLOSAPI int tl_sharedcache_remove(tl_sharedcache *cache, const void *key,
+				  void *object);
+
+/**
+ * \brief Get the number of entries in a shared LRU cache
+ *
+ * \memberof tl_sharedcache
+ *
+ * This function is thread safe. If other threads modify the cache
+ * concurrently, the result is only a snapshot.
+ *
+ * \param cache A pointer to a shared LRU cache
+ *
+ * \return The number of entries stored in the cache
+ */
+TLOSAPI size_t tl_sharedcache_count(tl_sharedcache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOOLS_SHAREDCACHE_H */
+
@@ -0,0 +1,192 @@
+/*
+ * tl_sharedmap.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_sharedmap.h
+ *
+ * \brief Contains a thread safe hash map implementation
+ */
+#ifndef TOOLS_SHAREDMAP_H
+#define TOOLS_SHAREDMAP_H
+
+/**
+ * \page conc Concurrency
+ *
+ * \section sharedmap Shared hash map
+ *
+ * A tl_sharedmap is a hash map that can be accessed by multiple threads
+ * simultaneously, for instance by the worker threads of a \ref tl_threadpool.
+ *
+ * Instead of protecting an entire \ref tl_hashmap with a single lock, the
+ * shared map is split up into a number of stripes, each of which is a hash
+ * map of its own, protected by its own \ref tl_rwlock. The stripe of an entry
+ * is determined from the hash of its key. Threads accessing keys in
+ * different stripes never wait for each other and lookups of keys within
+ * the same stripe can still run in parallel.
+ *
+ * Since other threads can modify or remove entries at any time, a shared
+ * map never hands out pointers to the values stored in it. Instead, values
+ * are copied into and out of the map under the lock of their stripe.
+ *
+ * For a function reference, see \ref tl_sharedmap.
+ */
+
+#include "tl_predef.h"
+
+/**
+ * \struct tl_sharedmap
+ *
+ * \brief A lock striped, thread safe hash map
+ *
+ * For a detailed description, see \ref sharedmap
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Create a shared hash map
+ *
+ * \memberof tl_sharedmap
+ *
+ * Every stripe of the map is a \ref tl_hashmap that grows automatically
+ * once it holds on average more than one entry per bin.
+ *
+ * \param keysize    The size of a key object
+ * \param objsize    The size of a value object
+ * \param stripes    The number of independently locked stripes. Zero to use
+ *                   a default value.
+ * \param keyhash    A function to compute a hash of a key
+ * \param keycompare A function to compare two key objects for equality
+ * \param keyalloc   A pointer to an allocator for keys or NULL if not used
+ * \param valalloc   A pointer to an allocator for values or NULL if not used
+ *
+ * \return A pointer to a shared hash map on success, NULL on failure
+ */
+TLOSAPI tl_sharedmap *tl_sharedmap_create(size_t keysize, size_t objsize,
+					  unsigned int stripes,
+					  tl_hash keyhash,
+					  tl_compare keycompare,
+					  tl_allocator *keyalloc,
+					  tl_allocator *valalloc);
+
+/**
+ * \brief Destroy a shared hash map and free all its entries
+ *
+ * \memberof tl_sharedmap
+ *
+ * \note This function is NOT thread safe. No other thread may access the
+ *       map while or after it is destroyed.
+ *
+ * \param map A pointer to a shared hash map
+ */
+TLOSAPI void tl_sharedmap_destroy(tl_sharedmap *map);
+
+/**
+ * \brief Remove all entries from a shared hash map
+ *
+ * \memberof tl_sharedmap
+ *
+ * This function is thread safe. The stripes are cleared one after another,
+ * so other threads may observe a partially cleared map.
+ *
+ * \param map A pointer to a shared hash map
+ */
+TLOSAPI void tl_sharedmap_clear(tl_sharedmap *map);
+
+/**
+ * \brief Add an object to a shared hash map or overwrite an existing one
+ *
+ * \memberof tl_sharedmap
+ *
+ * This function is thread safe.
+ *
+ * Unlike \ref tl_hashmap_insert, a key is stored only once. If an entry with
+ * an equivalent key already exists, its value is overwritten.
+ *
+ * \param map    A pointer to a shared hash map
+ * \param key    The key to asociate the object with
+ * \param object The object to store in the map
+ *
+ * \return Non-zero on success, zero if out of memory
+ */
+TLOSAPI int tl_sharedmap_insert(tl_sharedmap *map, const void *key,
+				const void *object);
+
+/**
+ * \brief Get a copy of an object stored in a shared hash map
+ *
+ * \memberof tl_sharedmap
+ *
+ * This function is thread safe.
+ *
+ * \param map    A pointer to a shared hash map
+ * \param key    A pointer to the key object to look for
+ * \param object If not NULL, receives a copy of the stored object, created
+ *               using the value allocator of the map.
+ *
+ * \return Non-zero if the key was found, zero if not
+ */
+TLOSAPI int tl_sharedmap_get(tl_sharedmap *map, const void *key,
+			     void *object);
+
+/**
+ * \brief Remove an object stored in a shared hash map
+ *
+ * \memberof tl_sharedmap
+ *
+ * This function is thread safe.
+ *
+ * \param map    A pointer to a shared hash map
+ * \param key    A pointer to the key object to look for
+ * \param object If not NULL, the object stored in the map is memcopied to
+ *               this location.
+ *
+ * \return Non-zero if the object was found, zero if not
+ */
+TLOSAPI int tl_sharedmap_remove(tl_sharedmap *map, const void *key,
+				void *object);
+
+/**
+ * \brief Get the number of entries in a shared hash map
+ *
+ * \memberof tl_sharedmap
+ *
+ * This function is thread safe. If other threads modify the map
+ * concurrently, the result is only a snapshot.
+ *
+ * \param map A pointer to a shared hash map
+ *
+ * \return The number of entries stored in the map
+ */
+TLOSAPI size_t tl_sharedmap_count(tl_sharedmap *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOOLS_SHAREDMAP_H */
+
@@ -0,0 +1,187 @@
+/*
+ * tl_snapshot.h
+ * This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file tl_snapshot.h
+ *
+ * \brief Contains functions to store hash maps in memory mappable files
+ */
+#ifndef TOOLS_SNAPSHOT_H
+#define TOOLS_SNAPSHOT_H
+
+/**
+ * \page kvcontainers Key-Value-Containers
+ *
+ * \section tl_hashmap_snapshot Hash map snapshots
+ *
+ * A \ref tl_hashmap with plain data keys and values (i.e. no allocators) can
+ * be written to a \ref tl_iostream, usually a \ref tl_file, as a snapshot
+ * using \ref tl_hashmap_snapshot_write.
+ *
+ * The snapshot does not contain any pointers. It consists of a header, an
+ * array with the index of the first entry of every bin and the entries
+ * themselves, each holding the hash value of the key, the key and the value,
+ * grouped by bin.
+ *
+ * Using \ref tl_hashmap_snapshot_load, a snapshot file is mapped into memory
+ * read-only and can immediately be queried with
+ * \ref tl_hashmap_snapshot_at, without inserting the entries into a
+ * \ref tl_hashmap first. The operating system only loads the pages that are
+ * actually accessed from disk.
+ *
+ * The snapshot is stored in the byte order and type sizes of the machine
+ * that wrote it. The hash function used for lookups has to produce the same
+ * hash values as the one of the original map, i.e. it must not depend on
+ * pointers or other per process state.
+ */
+
+#include "tl_predef.h"
+#include "tl_file.h"
+
+/**
+ * \struct tl_hashmap_snapshot
+ *
+ * \brief A read only hash map snapshot, mapped from a file
+ *
+ * For a detailed description, see \ref tl_hashmap_snapshot.
+ */
+struct tl_hashmap_snapshot {
+	/** \brief The mapping of the snapshot file */
+	const tl_file_mapping *mapping;
+
+	/** \brief Index of the first entry of every bin, plus the count */
+	const tl_u64 *bins;
+
+	/** \brief Pointer to the first entry */
+	const char *entries;
+
+	/** \brief The number of bins */
+	size_t bincount;
+
+	/** \brief The number of entries */
+	size_t count;
+
+	/** \brief The size of a key object */
+	size_t keysize;
+
+	/** \brief The size of a value object */
+	size_t objsize;
+
+	/** \brief The offset of the key within an entry */
+	size_t keyoffset;
+
+	/** \brief The offset of the value within an entry */
+	size_t objoffset;
+
+	/** \brief The size of a single entry */
+	size_t entrysize;
+
+	/** \brief A function used to compute the hash value of a key object */
+	tl_hash hash;
+
+	/** \brief A function used to compare two key objects */
+	tl_compare compare;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Write a snapshot of a hash map to a stream
+ *
+ * \memberof tl_hashmap_snapshot
+ *
+ * \note This function runs in linear time
+ *
+ * If the same key has been inserted multiple times, all entries are written
+ * and a lookup in the snapshot yields the most recently inserted one, just
+ * like \ref tl_hashmap_at.
+ *
+ * \param map    A pointer to a hash map. Keys and values must be plain
+ *               data, the map must not use allocators.
+ * \param stream A pointer to a stream to write to, usually a \ref tl_file
+ *               opened for writing.
+ *
+ * \return Zero on success, a negative \ref TL_ERROR_CODE value on failure
+ */
+TLOSAPI int tl_hashmap_snapshot_write(const tl_hashmap *map,
+				      tl_iostream *stream);
+
+/**
+ * \brief Map a hash map snapshot file into memory
+ *
+ * \memberof tl_hashmap_snapshot
+ *
+ * \note This function runs in constant time
+ *
+ * The snapshot is read from the start of the file. After loading, the file
+ * object can be destroyed, the mapping stays valid until
+ * \ref tl_hashmap_snapshot_cleanup is called.
+ *
+ * \param snap    A pointer to an uninitialized snapshot structure
+ * \param file    A pointer to a file opened for reading
+ * \param keyhash A function to compute a hash of a key, must compute the
+ *                same values as the hash function of the original map
+ * \param keycompare A function to compare two key objects for equality
+ *
+ * \return Zero on success, a negative \ref TL_ERROR_CODE value on failure.
+ *         \ref TL_ERR_ARG if the file is not a valid snapshot.
+ */
+TLOSAPI int tl_hashmap_snapshot_load(tl_hashmap_snapshot *snap,
+				     tl_file *file, tl_hash keyhash,
+				     tl_compare keycompare);
+
+/**
+ * \brief Unmap a hash map snapshot
+ *
+ * \memberof tl_hashmap_snapshot
+ *
+ * \param snap A pointer to a snapshot
+ */
+TLOSAPI void tl_hashmap_snapshot_cleanup(tl_hashmap_snapshot *snap);
+
+/**
+ * \brief Get an object stored in a hash map snapshot by its key
+ *
+ * \memberof tl_hashmap_snapshot
+ *
+ * \note This function runs roughly in constant time, like
+ *       \ref tl_hashmap_at
+ *
+ * \param snap A pointer to a snapshot
+ * \param key  A pointer to the key object to look for
+ *
+ * \return A read only pointer to the object or NULL if not found
+ */
+TLOSAPI const void *tl_hashmap_snapshot_at(const tl_hashmap_snapshot *snap,
+					   const void *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOOLS_SNAPSHOT_H */
+
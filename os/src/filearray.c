@@ -0,0 +1,310 @@
+/* filearray.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_OS_EXPORT
+#include "tl_filearray.h"
+#include "tl_blob.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FILEARRAY_MAGIC 0x52414C54UL
+#define FILEARRAY_VERSION 1
+
+/* the elements start after the header, at a cache line boundary */
+#define HEADER_SIZE 64
+
+/* the smallest amount of element data to map */
+#define MIN_MAP_BYTES 65536
+
+typedef struct {
+	tl_u32 magic;
+	tl_u32 version;
+	tl_u64 unitsize;
+	tl_u64 used;
+	tl_u64 reserved;
+} file_header;
+
+static file_header *get_header(const tl_filearray *this)
+{
+	return (file_header *)((const tl_blob *)this->mapping)->data;
+}
+
+static void sync_header(tl_filearray *this)
+{
+	file_header *hdr = get_header(this);
+
+	hdr->magic = FILEARRAY_MAGIC;
+	hdr->version = FILEARRAY_VERSION;
+	hdr->unitsize = this->unitsize;
+	hdr->used = this->used;
+	hdr->reserved = this->reserved;
+}
+
+static int read_all(tl_iostream *stream, void *data, size_t size,
+		    size_t *total)
+{
+	size_t actual;
+	int ret;
+
+	for (*total = 0; *total < size; *total += actual) {
+		ret = stream->read(stream, (char *)data + *total,
+				   size - *total, &actual);
+		if (ret == TL_EOF)
+			break;
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static size_t max_elements(size_t unitsize)
+{
+	return (((size_t)-1) - HEADER_SIZE) / unitsize;
+}
+
+/* map the header and a number of elements, replacing the old mapping */
+static int map_file(tl_filearray *this, size_t reserved)
+{
+	const tl_file_mapping *mapping;
+
+	mapping = this->file->map(this->file, 0,
+				  HEADER_SIZE + reserved * this->unitsize,
+				  TL_MAP_READ | TL_MAP_WRITE);
+	if (!mapping)
+		return TL_ERR_INTERNAL;
+
+	if (this->mapping)
+		this->mapping->destroy(this->mapping);
+
+	this->mapping = mapping;
+	this->data = (char *)((const tl_blob *)mapping)->data + HEADER_SIZE;
+	this->reserved = reserved;
+	return 0;
+}
+
+/*
+    The file is extended by writing its new last byte, the space in between
+    reads as zero. On most file systems, no disk space is allocated for it
+    until it is actually written to.
+ */
+static int grow(tl_filearray *this, size_t size)
+{
+	size_t newsize, actual;
+	char zero = 0;
+	tl_u64 end;
+	int ret;
+
+	newsize = this->reserved ? this->reserved : 1;
+
+	if (!this->reserved && this->unitsize < MIN_MAP_BYTES)
+		newsize = MIN_MAP_BYTES / this->unitsize;
+
+	while (newsize < size) {
+		if (newsize > max_elements(this->unitsize) / 2)
+			return TL_ERR_TOO_LARGE;
+		newsize *= 2;
+	}
+
+	if (newsize > max_elements(this->unitsize))
+		return TL_ERR_TOO_LARGE;
+
+	end = HEADER_SIZE + (tl_u64)newsize * this->unitsize;
+
+	ret = this->file->seek(this->file, end - 1);
+	if (ret)
+		return ret;
+
+	ret = ((tl_iostream *)this->file)->write((tl_iostream *)this->file,
+						 &zero, 1, &actual);
+	if (ret)
+		return ret;
+	if (actual != 1)
+		return TL_ERR_INTERNAL;
+
+	ret = map_file(this, newsize);
+	if (ret)
+		return ret;
+
+	sync_header(this);
+	return 0;
+}
+
+static int load(tl_filearray *this)
+{
+	tl_iostream *stream = (tl_iostream *)this->file;
+	size_t actual;
+	file_header hdr;
+	char last;
+	int ret;
+
+	ret = read_all(stream, &hdr, sizeof(hdr), &actual);
+	if (ret)
+		return ret;
+
+	/* an empty file gets a new array */
+	if (actual == 0)
+		return grow(this, 1);
+
+	if (actual != sizeof(hdr) || hdr.magic != FILEARRAY_MAGIC ||
+	    hdr.version != FILEARRAY_VERSION) {
+		return TL_ERR_ARG;
+	}
+
+	if (hdr.unitsize != this->unitsize || hdr.used > hdr.reserved ||
+	    !hdr.reserved) {
+		return TL_ERR_ARG;
+	}
+
+	if (hdr.reserved > max_elements(this->unitsize))
+		return TL_ERR_TOO_LARGE;
+
+	/* accessing a mapping past the end of the file would crash */
+	ret = this->file->seek(this->file, HEADER_SIZE - 1 +
+			       hdr.reserved * this->unitsize);
+	if (ret)
+		return ret;
+
+	ret = read_all(stream, &last, 1, &actual);
+	if (ret)
+		return ret;
+	if (actual != 1)
+		return TL_ERR_ARG;
+
+	ret = map_file(this, (size_t)hdr.reserved);
+	if (ret)
+		return ret;
+
+	this->used = (size_t)hdr.used;
+	return 0;
+}
+
+/****************************************************************************/
+
+int tl_filearray_open(tl_filearray *this, const char *path,
+		      size_t elementsize, int flags)
+{
+	tl_iostream *stream;
+	int ret;
+
+	assert(this && path && elementsize);
+
+	memset(this, 0, sizeof(*this));
+
+	if (flags & ~(TL_CREATE | TL_OVERWRITE))
+		return TL_ERR_ARG;
+
+	ret = tl_file_open(path, &this->file, TL_READ | TL_WRITE | flags);
+	if (ret)
+		return ret;
+
+	this->unitsize = elementsize;
+
+	ret = load(this);
+	if (ret) {
+		if (this->mapping)
+			this->mapping->destroy(this->mapping);
+
+		stream = (tl_iostream *)this->file;
+		stream->destroy(stream);
+		memset(this, 0, sizeof(*this));
+	}
+
+	return ret;
+}
+
+void tl_filearray_cleanup(tl_filearray *this)
+{
+	assert(this && this->file && this->mapping);
+
+	sync_header(this);
+
+	this->mapping->destroy(this->mapping);
+	((tl_iostream *)this->file)->destroy((tl_iostream *)this->file);
+
+	memset(this, 0, sizeof(*this));
+}
+
+int tl_filearray_reserve(tl_filearray *this, size_t size)
+{
+	assert(this);
+
+	return size <= this->reserved ? 0 : grow(this, size);
+}
+
+int tl_filearray_resize(tl_filearray *this, size_t size)
+{
+	int ret;
+
+	assert(this);
+
+	if (size > this->reserved) {
+		ret = grow(this, size);
+		if (ret)
+			return ret;
+	}
+
+	/* elements left behind by a previous shrink have to be cleared */
+	if (size > this->used) {
+		memset((char *)this->data + this->used * this->unitsize, 0,
+		       (size - this->used) * this->unitsize);
+	}
+
+	this->used = size;
+	return 0;
+}
+
+int tl_filearray_append(tl_filearray *this, const void *element)
+{
+	int ret;
+
+	assert(this && element);
+
+	if (this->used == this->reserved) {
+		ret = grow(this, this->used + 1);
+		if (ret)
+			return ret;
+	}
+
+	memcpy((char *)this->data + this->used * this->unitsize, element,
+	       this->unitsize);
+	this->used += 1;
+	return 0;
+}
+
+int tl_filearray_append_array(tl_filearray *this, const void *data,
+			      size_t count)
+{
+	int ret;
+
+	assert(this && (data || !count));
+
+	if (!count)
+		return 0;
+	if ((this->used + count) < this->used)
+		return TL_ERR_TOO_LARGE;
+
+	ret = tl_filearray_reserve(this, this->used + count);
+	if (ret)
+		return ret;
+
+	memcpy((char *)this->data + this->used * this->unitsize, data,
+	       count * this->unitsize);
+	this->used += count;
+	return 0;
+}
+
+void tl_filearray_flush(tl_filearray *this)
+{
+	assert(this && this->mapping);
+
+	sync_header(this);
+
+	this->mapping->flush(this->mapping, 0,
+			     HEADER_SIZE + this->used * this->unitsize);
+}
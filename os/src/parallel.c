@@ -0,0 +1,190 @@
+/* parallel.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_OS_EXPORT
+#include "tl_parallel.h"
+#include "tl_allocator.h"
+#include "tl_array.h"
+#include "tl_hashmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* number of tasks the work of a single step is split into */
+#define NUM_TASKS 64
+
+typedef struct {
+	tl_hashmap *map;
+	const char *keys;
+	const char *values;
+	unsigned long *hashes;
+	size_t *indices;
+
+	tl_monitor *monitor;
+	size_t pending;
+} build_ctx;
+
+typedef struct {
+	build_ctx *ctx;
+
+	/* range of pairs, or of entries of the index array */
+	size_t first;
+	size_t last;
+
+	/* index of the bin range of the map filled by the task */
+	size_t range;
+	int ret;
+} build_task;
+
+static void task_done(build_ctx *ctx)
+{
+	tl_monitor_lock(ctx->monitor, 0);
+	ctx->pending -= 1;
+	tl_monitor_notify_all(ctx->monitor);
+	tl_monitor_unlock(ctx->monitor);
+}
+
+static void hash_task(void *arg)
+{
+	build_task *task = arg;
+	build_ctx *ctx = task->ctx;
+	size_t i, keysize = ctx->map->keysize;
+
+	for (i = task->first; i < task->last; ++i)
+		ctx->hashes[i] = ctx->map->hash(ctx->keys + i * keysize);
+
+	task_done(ctx);
+}
+
+static void fill_task(void *arg)
+{
+	build_task *task = arg;
+	build_ctx *ctx = task->ctx;
+
+	task->ret = tl_hashmap_bulk_fill(ctx->map, task->range, ctx->keys,
+					 ctx->values, ctx->hashes,
+					 ctx->indices + task->first,
+					 task->last - task->first);
+
+	task_done(ctx);
+}
+
+static void run_tasks(build_ctx *ctx, tl_threadpool *pool,
+		      tl_threadpool_worker_cb function,
+		      build_task *tasks, size_t count)
+{
+	size_t i;
+
+	ctx->pending = count;
+
+	for (i = 0; i < count; ++i) {
+		if (!tl_threadpool_add_task(pool, function, tasks + i, 0, NULL))
+			function(tasks + i);
+	}
+
+	/* the pool only tells us if the queue is empty, not if tasks are */
+	tl_monitor_lock(ctx->monitor, 0);
+
+	while (ctx->pending)
+		tl_monitor_wait(ctx->monitor, 0);
+
+	tl_monitor_unlock(ctx->monitor);
+}
+
+static size_t get_bincount(const tl_hashmap *map, size_t count)
+{
+	size_t bincount = count;
+
+	if (map->max_load)
+		bincount = (size_t)((tl_u64)count * 100 / map->max_load) + 1;
+
+	return bincount > map->bincount ? bincount : map->bincount;
+}
+
+/****************************************************************************/
+
+int tl_hashmap_from_arrays(tl_hashmap *map, const tl_array *keys,
+			   const tl_array *values, tl_threadpool *pool)
+{
+	size_t i, n, part, width, ntasks = NUM_TASKS, *offsets = NULL;
+	build_task tasks[NUM_TASKS];
+	build_ctx ctx;
+	int ret = 0;
+
+	assert(map && keys && values && pool);
+	assert(keys->unitsize == map->keysize);
+	assert(values->unitsize == map->objsize);
+	assert(keys->used == values->used);
+
+	if (!tl_hashmap_is_empty(map))
+		return 0;
+
+	n = keys->used;
+	if (!n)
+		return 1;
+
+	memset(&ctx, 0, sizeof(ctx));
+	memset(tasks, 0, sizeof(tasks));
+	ctx.map = map;
+	ctx.keys = keys->data;
+	ctx.values = values->data;
+
+	ctx.monitor = tl_monitor_create();
+	ctx.hashes = malloc(n * sizeof(ctx.hashes[0]));
+	ctx.indices = malloc(n * sizeof(ctx.indices[0]));
+	offsets = calloc(NUM_TASKS + 1, sizeof(offsets[0]));
+
+	if (!ctx.monitor || !ctx.hashes || !ctx.indices || !offsets)
+		goto out;
+
+	/* the map splits its new table into ranges that can be filled apart */
+	width = tl_hashmap_bulk_begin(map, get_bincount(map, n), &ntasks);
+	if (!width)
+		goto out;
+
+	/* hash all keys */
+	for (i = 0; i < ntasks; ++i) {
+		tasks[i].ctx = &ctx;
+		tasks[i].first = (size_t)((tl_u64)n * i / ntasks);
+		tasks[i].last = (size_t)((tl_u64)n * (i + 1) / ntasks);
+	}
+
+	run_tasks(&ctx, pool, hash_task, tasks, ntasks);
+
+	/* partition the pairs by bin range, keeping them in array order */
+	for (i = 0; i < n; ++i)
+		offsets[(ctx.hashes[i] % map->bincount) / width + 1] += 1;
+
+	for (i = 0; i < ntasks; ++i) {
+		offsets[i + 1] += offsets[i];
+
+		tasks[i].first = offsets[i];
+		tasks[i].last = offsets[i + 1];
+		tasks[i].range = i;
+	}
+
+	for (i = 0; i < n; ++i) {
+		part = (ctx.hashes[i] % map->bincount) / width;
+		ctx.indices[offsets[part]++] = i;
+	}
+
+	/* fill the ranges, keeping the result only if all of them worked */
+	run_tasks(&ctx, pool, fill_task, tasks, ntasks);
+
+	for (ret = 1, i = 0; i < ntasks; ++i)
+		ret = ret && tasks[i].ret;
+
+	tl_hashmap_bulk_end(map, ret);
+out:
+	if (ctx.monitor)
+		tl_monitor_destroy(ctx.monitor);
+
+	free(offsets);
+	free(ctx.indices);
+	free(ctx.hashes);
+	return ret;
+}
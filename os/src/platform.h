@@ -24,6 +24,11 @@ extern "C" {
 int __tl_os_splice(tl_iostream *out, tl_iostream *in,
 		   size_t count, size_t *actual);
 
+/* Mix up the bits of a key hash and reduce it to an index in [0, count).
+   Used to select a lock stripe or shard for a key, where the per stripe
+   hash maps already use the plain hash modulo their bin count. */
+unsigned int __tl_os_select_stripe(unsigned long hash, unsigned int count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,302 @@
+/* rcumap.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_OS_EXPORT
+#include "tl_rcumap.h"
+#include "tl_hashmap.h"
+#include "tl_thread.h"
+
+#include <stdlib.h>
+
+#ifdef _MSC_VER
+#include <windows.h>
+
+#define MEMORY_BARRIER() MemoryBarrier()
+#else
+#define MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+#define CACHE_LINE 64
+
+/* epoch value of a reader that is not inside a critical section */
+#define EPOCH_IDLE 0
+
+typedef struct version {
+	tl_hashmap map;
+
+	/* the epoch in which the version was replaced by a newer one */
+	unsigned long retired;
+
+	struct version *next;
+} version;
+
+/*
+    The epoch is the only field written by the reading thread. It is surrounded
+    by padding, so that it never shares a cache line with anything another
+    thread writes to.
+ */
+struct tl_rcumap_reader {
+	char pad0[CACHE_LINE];
+	volatile unsigned long epoch;
+	char pad1[CACHE_LINE];
+
+	tl_rcumap *map;
+	tl_rcumap_reader *next;
+};
+
+struct tl_rcumap {
+	version *volatile current;
+	volatile unsigned long epoch;
+
+	tl_mutex *lock;
+	tl_rcumap_reader *readers;
+
+	/* retired versions, newest first */
+	version *retired;
+
+	/* the version being prepared by the writer holding the lock */
+	version *update;
+};
+
+static void version_destroy(version *v)
+{
+	tl_hashmap_cleanup(&v->map);
+	free(v);
+}
+
+/*
+    A reader that announced an epoch newer than the one a version was retired
+    in loaded the version pointer after the version was replaced, so it cannot
+    have seen the retired version. Since the retired list is sorted newest
+    first, everything past the first version that is safe to free is safe as
+    well.
+ */
+static size_t reclaim(tl_rcumap *this)
+{
+	unsigned long oldest = this->epoch, e;
+	tl_rcumap_reader *r;
+	version *v, **it;
+	size_t count = 0;
+
+	MEMORY_BARRIER();
+
+	for (r = this->readers; r != NULL; r = r->next) {
+		e = r->epoch;
+
+		if (e != EPOCH_IDLE && e < oldest)
+			oldest = e;
+	}
+
+	for (it = &this->retired; *it != NULL; it = &(*it)->next) {
+		if ((*it)->retired < oldest)
+			break;
+		++count;
+	}
+
+	v = *it;
+	*it = NULL;
+
+	while (v != NULL) {
+		version *next = v->next;
+
+		version_destroy(v);
+		v = next;
+	}
+
+	return count;
+}
+
+tl_rcumap *tl_rcumap_create(size_t keysize, size_t objsize,
+			    size_t bincount, tl_hash keyhash,
+			    tl_compare keycompare, tl_allocator *keyalloc,
+			    tl_allocator *valalloc)
+{
+	tl_rcumap *this;
+	version *v;
+
+	assert(keysize && objsize && keyhash && keycompare);
+
+	this = calloc(1, sizeof(*this));
+	if (!this)
+		return NULL;
+
+	v = calloc(1, sizeof(*v));
+	if (!v)
+		goto fail;
+
+	if (!tl_hashmap_init(&v->map, keysize, objsize, bincount, keyhash,
+			     keycompare, keyalloc, valalloc)) {
+		free(v);
+		goto fail;
+	}
+
+	this->lock = tl_mutex_create(0);
+	if (!this->lock) {
+		version_destroy(v);
+		goto fail;
+	}
+
+	this->current = v;
+	this->epoch = EPOCH_IDLE + 1;
+	return this;
+fail:
+	free(this);
+	return NULL;
+}
+
+void tl_rcumap_destroy(tl_rcumap *this)
+{
+	version *v;
+
+	assert(this);
+	assert(this->readers == NULL && this->update == NULL);
+
+	while (this->retired != NULL) {
+		v = this->retired;
+		this->retired = v->next;
+		version_destroy(v);
+	}
+
+	version_destroy(this->current);
+	tl_mutex_destroy(this->lock);
+	free(this);
+}
+
+tl_rcumap_reader *tl_rcumap_reader_create(tl_rcumap *map)
+{
+	tl_rcumap_reader *this;
+
+	assert(map);
+
+	this = calloc(1, sizeof(*this));
+	if (!this)
+		return NULL;
+
+	this->map = map;
+
+	tl_mutex_lock(map->lock, 0);
+	this->next = map->readers;
+	map->readers = this;
+	tl_mutex_unlock(map->lock);
+	return this;
+}
+
+void tl_rcumap_reader_destroy(tl_rcumap_reader *this)
+{
+	tl_rcumap_reader **it;
+
+	assert(this);
+	assert(this->epoch == EPOCH_IDLE);
+
+	tl_mutex_lock(this->map->lock, 0);
+
+	for (it = &this->map->readers; *it != this; it = &(*it)->next)
+		;
+
+	*it = this->next;
+	tl_mutex_unlock(this->map->lock);
+	free(this);
+}
+
+/*
+    The epoch has to be visible to writers before the version pointer is
+    loaded. Otherwise, a writer could replace the version and free it in
+    between, while still treating the reader as idle.
+ */
+const tl_hashmap *tl_rcumap_read_begin(tl_rcumap_reader *this)
+{
+	version *v;
+
+	assert(this);
+	assert(this->epoch == EPOCH_IDLE);
+
+	this->epoch = this->map->epoch;
+	MEMORY_BARRIER();
+
+	v = this->map->current;
+	return &v->map;
+}
+
+void tl_rcumap_read_end(tl_rcumap_reader *this)
+{
+	assert(this);
+
+	MEMORY_BARRIER();
+	this->epoch = EPOCH_IDLE;
+}
+
+tl_hashmap *tl_rcumap_update_begin(tl_rcumap *this)
+{
+	version *v;
+
+	assert(this);
+
+	tl_mutex_lock(this->lock, 0);
+
+	v = calloc(1, sizeof(*v));
+	if (!v)
+		goto fail;
+
+	if (!tl_hashmap_copy(&v->map, &this->current->map)) {
+		free(v);
+		goto fail;
+	}
+
+	this->update = v;
+	return &v->map;
+fail:
+	tl_mutex_unlock(this->lock);
+	return NULL;
+}
+
+void tl_rcumap_update_commit(tl_rcumap *this)
+{
+	version *old;
+
+	assert(this && this->update);
+
+	old = this->current;
+
+	/* the new version must be complete before it can be seen */
+	MEMORY_BARRIER();
+	this->current = this->update;
+	this->update = NULL;
+
+	old->retired = this->epoch;
+	old->next = this->retired;
+	this->retired = old;
+
+	/* a reader that sees the new epoch must also see the new version */
+	MEMORY_BARRIER();
+	this->epoch += 1;
+	if (this->epoch == EPOCH_IDLE)
+		this->epoch += 1;
+
+	reclaim(this);
+	tl_mutex_unlock(this->lock);
+}
+
+void tl_rcumap_update_abort(tl_rcumap *this)
+{
+	assert(this && this->update);
+
+	version_destroy(this->update);
+	this->update = NULL;
+	tl_mutex_unlock(this->lock);
+}
+
+size_t tl_rcumap_reclaim(tl_rcumap *this)
+{
+	size_t count;
+
+	assert(this);
+
+	tl_mutex_lock(this->lock, 0);
+	count = reclaim(this);
+	tl_mutex_unlock(this->lock);
+	return count;
+}
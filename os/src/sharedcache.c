@@ -0,0 +1,186 @@
+/* sharedcache.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_OS_EXPORT
+#include "tl_sharedcache.h"
+#include "tl_allocator.h"
+#include "tl_lrucache.h"
+#include "tl_thread.h"
+#include "platform.h"
+
+#include <stdlib.h>
+
+#define DEFAULT_SHARDS 16
+
+typedef struct {
+	tl_mutex *lock;
+	tl_lrucache cache;
+} shard;
+
+struct tl_sharedcache {
+	tl_hash hash;
+	unsigned int shardcount;
+	shard shards[1];
+};
+
+static shard *get_shard(tl_sharedcache *this, const void *key)
+{
+	unsigned long h = this->hash(key);
+
+	return this->shards + __tl_os_select_stripe(h, this->shardcount);
+}
+
+tl_sharedcache *tl_sharedcache_create(size_t keysize, size_t objsize,
+				      size_t capacity, unsigned int shards,
+				      tl_hash keyhash, tl_compare keycompare,
+				      tl_allocator *keyalloc,
+				      tl_allocator *valalloc)
+{
+	tl_sharedcache *this;
+	unsigned int i;
+
+	assert(keysize && objsize && keyhash && keycompare);
+
+	if (!shards)
+		shards = DEFAULT_SHARDS;
+
+	this = calloc(1, sizeof(*this) + (shards - 1) * sizeof(shard));
+	if (!this)
+		return NULL;
+
+	this->hash = keyhash;
+	capacity = capacity / shards + (capacity % shards ? 1 : 0);
+
+	for (i = 0; i < shards; ++i) {
+		if (!tl_lrucache_init(&this->shards[i].cache, keysize, objsize,
+				      capacity, keyhash, keycompare,
+				      keyalloc, valalloc)) {
+			goto fail;
+		}
+
+		this->shardcount = i + 1;
+
+		this->shards[i].lock = tl_mutex_create(0);
+		if (!this->shards[i].lock)
+			goto fail;
+	}
+
+	return this;
+fail:
+	tl_sharedcache_destroy(this);
+	return NULL;
+}
+
+void tl_sharedcache_destroy(tl_sharedcache *this)
+{
+	unsigned int i;
+
+	assert(this);
+
+	for (i = 0; i < this->shardcount; ++i) {
+		if (this->shards[i].lock)
+			tl_mutex_destroy(this->shards[i].lock);
+
+		tl_lrucache_cleanup(&this->shards[i].cache);
+	}
+
+	free(this);
+}
+
+void tl_sharedcache_clear(tl_sharedcache *this)
+{
+	unsigned int i;
+
+	assert(this);
+
+	for (i = 0; i < this->shardcount; ++i) {
+		if (!tl_mutex_lock(this->shards[i].lock, 0))
+			continue;
+
+		tl_lrucache_clear(&this->shards[i].cache);
+		tl_mutex_unlock(this->shards[i].lock);
+	}
+}
+
+int tl_sharedcache_put(tl_sharedcache *this, const void *key,
+		       const void *object, size_t cost)
+{
+	shard *s;
+	int ret;
+
+	assert(this && key && object);
+
+	s = get_shard(this, key);
+
+	if (!tl_mutex_lock(s->lock, 0))
+		return 0;
+
+	ret = tl_lrucache_put(&s->cache, key, object, cost);
+
+	tl_mutex_unlock(s->lock);
+	return ret;
+}
+
+int tl_sharedcache_get(tl_sharedcache *this, const void *key, void *object)
+{
+	shard *s;
+	void *ptr;
+
+	assert(this && key);
+
+	s = get_shard(this, key);
+
+	if (!tl_mutex_lock(s->lock, 0))
+		return 0;
+
+	ptr = tl_lrucache_get(&s->cache, key);
+
+	if (ptr && object) {
+		tl_allocator_copy(s->cache.objalloc, object, ptr,
+				  s->cache.objsize, 1);
+	}
+
+	tl_mutex_unlock(s->lock);
+	return ptr != NULL;
+}
+
+int tl_sharedcache_remove(tl_sharedcache *this, const void *key,
+			  void *object)
+{
+	shard *s;
+	int ret;
+
+	assert(this && key);
+
+	s = get_shard(this, key);
+
+	if (!tl_mutex_lock(s->lock, 0))
+		return 0;
+
+	ret = tl_lrucache_remove(&s->cache, key, object);
+
+	tl_mutex_unlock(s->lock);
+	return ret;
+}
+
+size_t tl_sharedcache_count(tl_sharedcache *this)
+{
+	size_t count = 0;
+	unsigned int i;
+
+	assert(this);
+
+	for (i = 0; i < this->shardcount; ++i) {
+		if (!tl_mutex_lock(this->shards[i].lock, 0))
+			continue;
+
+		count += tl_lrucache_count(&this->shards[i].cache);
+		tl_mutex_unlock(this->shards[i].lock);
+	}
+
+	return count;
+}
@@ -0,0 +1,214 @@
+/* sharedmap.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_OS_EXPORT
+#include "tl_sharedmap.h"
+#include "tl_allocator.h"
+#include "tl_hashmap.h"
+#include "tl_thread.h"
+#include "platform.h"
+
+#include <stdlib.h>
+
+#define DEFAULT_STRIPES 64
+#define STRIPE_BINS 16
+
+typedef struct {
+	tl_rwlock *lock;
+	tl_hashmap map;
+} stripe;
+
+struct tl_sharedmap {
+	tl_hash hash;
+	unsigned int stripecount;
+	stripe stripes[1];
+};
+
+static stripe *get_stripe(tl_sharedmap *this, const void *key)
+{
+	unsigned long h = this->hash(key);
+
+	return this->stripes + __tl_os_select_stripe(h, this->stripecount);
+}
+
+/****************************************************************************/
+
+/*
+    The stripe maps index their bins with the plain key hash modulo the bin
+    count. Selecting the stripe with the same modulo would leave most bins of
+    a stripe unused, so the hash is mixed up with the MurmurHash3 finalizer
+    first.
+ */
+unsigned int __tl_os_select_stripe(unsigned long hash, unsigned int count)
+{
+	tl_u32 x = (tl_u32)hash ^ (tl_u32)((hash >> 16) >> 16);
+
+	x ^= x >> 16;
+	x *= 0x85ebca6bUL;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35UL;
+	x ^= x >> 16;
+
+	return x % count;
+}
+
+tl_sharedmap *tl_sharedmap_create(size_t keysize, size_t objsize,
+				  unsigned int stripes, tl_hash keyhash,
+				  tl_compare keycompare, tl_allocator *keyalloc,
+				  tl_allocator *valalloc)
+{
+	tl_sharedmap *this;
+	unsigned int i;
+
+	assert(keysize && objsize && keyhash && keycompare);
+
+	if (!stripes)
+		stripes = DEFAULT_STRIPES;
+
+	this = calloc(1, sizeof(*this) + (stripes - 1) * sizeof(stripe));
+	if (!this)
+		return NULL;
+
+	this->hash = keyhash;
+
+	for (i = 0; i < stripes; ++i) {
+		if (!tl_hashmap_init(&this->stripes[i].map, keysize, objsize,
+				     STRIPE_BINS, keyhash, keycompare,
+				     keyalloc, valalloc)) {
+			goto fail;
+		}
+
+		tl_hashmap_set_max_load(&this->stripes[i].map, 100);
+		this->stripecount = i + 1;
+
+		this->stripes[i].lock = tl_rwlock_create();
+		if (!this->stripes[i].lock)
+			goto fail;
+	}
+
+	return this;
+fail:
+	tl_sharedmap_destroy(this);
+	return NULL;
+}
+
+void tl_sharedmap_destroy(tl_sharedmap *this)
+{
+	unsigned int i;
+
+	assert(this);
+
+	for (i = 0; i < this->stripecount; ++i) {
+		if (this->stripes[i].lock)
+			tl_rwlock_destroy(this->stripes[i].lock);
+
+		tl_hashmap_cleanup(&this->stripes[i].map);
+	}
+
+	free(this);
+}
+
+void tl_sharedmap_clear(tl_sharedmap *this)
+{
+	unsigned int i;
+
+	assert(this);
+
+	for (i = 0; i < this->stripecount; ++i) {
+		if (!tl_rwlock_lock_write(this->stripes[i].lock, 0))
+			continue;
+
+		tl_hashmap_clear(&this->stripes[i].map);
+		tl_rwlock_unlock_write(this->stripes[i].lock);
+	}
+}
+
+int tl_sharedmap_insert(tl_sharedmap *this, const void *key,
+			const void *object)
+{
+	stripe *s;
+	void *ptr;
+
+	assert(this && key && object);
+
+	s = get_stripe(this, key);
+
+	if (!tl_rwlock_lock_write(s->lock, 0))
+		return 0;
+
+	/* a new value is constructed by the map, so both cases are the same */
+	ptr = tl_hashmap_emplace(&s->map, key, NULL);
+
+	if (ptr) {
+		tl_allocator_cleanup(s->map.objalloc, ptr, s->map.objsize, 1);
+		tl_allocator_copy(s->map.objalloc, ptr, object,
+				  s->map.objsize, 1);
+	}
+
+	tl_rwlock_unlock_write(s->lock);
+	return ptr != NULL;
+}
+
+int tl_sharedmap_get(tl_sharedmap *this, const void *key, void *object)
+{
+	stripe *s;
+	void *ptr;
+
+	assert(this && key);
+
+	s = get_stripe(this, key);
+
+	/* lookups never perform growing steps, so they can run in parallel */
+	if (!tl_rwlock_lock_read(s->lock, 0))
+		return 0;
+
+	ptr = tl_hashmap_at(&s->map, key);
+
+	if (ptr && object) {
+		tl_allocator_copy(s->map.objalloc, object, ptr,
+				  s->map.objsize, 1);
+	}
+
+	tl_rwlock_unlock_read(s->lock);
+	return ptr != NULL;
+}
+
+int tl_sharedmap_remove(tl_sharedmap *this, const void *key, void *object)
+{
+	stripe *s;
+	int ret;
+
+	assert(this && key);
+
+	s = get_stripe(this, key);
+
+	if (!tl_rwlock_lock_write(s->lock, 0))
+		return 0;
+
+	ret = tl_hashmap_remove(&s->map, key, object);
+
+	tl_rwlock_unlock_write(s->lock);
+	return ret;
+}
+
+size_t tl_sharedmap_count(tl_sharedmap *this)
+{
+	size_t count = 0;
+	unsigned int i;
+
+	assert(this);
+
+	for (i = 0; i < this->stripecount; ++i) {
+		if (!tl_rwlock_lock_read(this->stripes[i].lock, 0))
+			continue;
+
+		count += this->stripes[i].map.count;
+		tl_rwlock_unlock_read(this->stripes[i].lock);
+	}
+
+	return count;
+}
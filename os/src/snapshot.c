@@ -0,0 +1,318 @@
+/* snapshot.c -- This file is part of ctools
+ *
+ * Copyright (C) 2015 - David Oberhollenzer
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+#define TL_OS_EXPORT
+#include "tl_snapshot.h"
+#include "tl_iterator.h"
+#include "tl_hashmap.h"
+#include "tl_blob.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_MAGIC 0x534D4C54UL
+#define SNAPSHOT_VERSION 1
+
+#define BUFFER_SIZE 65536
+
+#define PAD8(x) (((x) + 7) & ~((size_t)7))
+
+typedef struct {
+	tl_u32 magic;
+	tl_u32 version;
+	tl_u32 keysize;
+	tl_u32 objsize;
+	tl_u64 bincount;
+	tl_u64 count;
+	tl_u64 size;
+} snap_header;
+
+typedef struct {
+	tl_u64 hash;
+	const void *key;
+	const void *value;
+} snap_entry;
+
+typedef struct {
+	tl_iostream *stream;
+	char *buffer;
+	size_t used;
+	size_t size;
+	int ret;
+} writer;
+
+static int write_all(tl_iostream *stream, const void *data, size_t size)
+{
+	const char *ptr = data;
+	size_t actual;
+	int ret;
+
+	while (size) {
+		ret = stream->write(stream, ptr, size, &actual);
+		if (ret)
+			return ret;
+		if (!actual)
+			return TL_ERR_INTERNAL;
+
+		ptr += actual;
+		size -= actual;
+	}
+
+	return 0;
+}
+
+static void flush_buffer(writer *w)
+{
+	if (!w->ret && w->used)
+		w->ret = write_all(w->stream, w->buffer, w->used);
+
+	w->used = 0;
+}
+
+static void write_entry(writer *w, const tl_hashmap *map,
+			const snap_entry *ent, size_t entrysize)
+{
+	char *ptr;
+
+	if (w->size - w->used < entrysize)
+		flush_buffer(w);
+
+	ptr = w->buffer + w->used;
+	memset(ptr, 0, entrysize);
+	memcpy(ptr, &ent->hash, sizeof(ent->hash));
+
+	ptr += sizeof(ent->hash);
+	memcpy(ptr, ent->key, map->keysize);
+
+	ptr += PAD8(map->keysize);
+	memcpy(ptr, ent->value, map->objsize);
+
+	w->used += entrysize;
+}
+
+/*
+    Collect all entries in iteration order. While a map is growing, the
+    iterator visits the new table before the old one and every chain from
+    the most recent entry on, so the most recent duplicate of a key always
+    comes first.
+ */
+static size_t collect_entries(const tl_hashmap *map, snap_entry *entries,
+			      tl_u64 *bins, size_t bincount)
+{
+	tl_iterator *it;
+	size_t count = 0;
+
+	/* the iterator is only used for reading */
+	it = tl_hashmap_get_iterator((tl_hashmap *)map);
+	if (!it)
+		return (size_t)-1;
+
+	for (; it->has_data(it) && count < map->count; it->next(it)) {
+		entries[count].key = it->get_key(it);
+		entries[count].value = it->get_value(it);
+		entries[count].hash = map->hash(entries[count].key);
+
+		bins[entries[count].hash % bincount + 1] += 1;
+		++count;
+	}
+
+	it->destroy(it);
+	return count;
+}
+
+/****************************************************************************/
+
+int tl_hashmap_snapshot_write(const tl_hashmap *map, tl_iostream *stream)
+{
+	size_t i, count, entrysize, bincount = map->bincount, *order = NULL;
+	snap_entry *entries = NULL;
+	tl_u64 *bins, *pos = NULL;
+	snap_header hdr;
+	writer w;
+
+	assert(map && stream);
+
+	if (map->keyalloc || map->objalloc)
+		return TL_ERR_ARG;
+
+	entrysize = sizeof(tl_u64) + PAD8(map->keysize) + PAD8(map->objsize);
+
+	w.buffer = NULL;
+	w.ret = TL_ERR_ALLOC;
+
+	bins = calloc(bincount + 1, sizeof(bins[0]));
+	pos = malloc(bincount * sizeof(pos[0]));
+	entries = malloc((map->count + 1) * sizeof(entries[0]));
+	order = malloc((map->count + 1) * sizeof(order[0]));
+
+	if (!bins || !pos || !entries || !order)
+		goto out;
+
+	/* count the entries per bin, then turn the counts into indices */
+	count = collect_entries(map, entries, bins, bincount);
+	if (count == (size_t)-1)
+		goto out;
+
+	for (i = 0; i < bincount; ++i) {
+		bins[i + 1] += bins[i];
+		pos[i] = bins[i];
+	}
+
+	/* a stable sort by bin keeps the most recent duplicate in front */
+	for (i = 0; i < count; ++i)
+		order[pos[entries[i].hash % bincount]++] = i;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = SNAPSHOT_MAGIC;
+	hdr.version = SNAPSHOT_VERSION;
+	hdr.keysize = map->keysize;
+	hdr.objsize = map->objsize;
+	hdr.bincount = bincount;
+	hdr.count = count;
+	hdr.size = sizeof(hdr) + (tl_u64)(bincount + 1) * sizeof(tl_u64) +
+		   hdr.count * entrysize;
+
+	w.stream = stream;
+	w.used = 0;
+	w.size = entrysize > BUFFER_SIZE ? entrysize : BUFFER_SIZE;
+	w.buffer = malloc(w.size);
+
+	if (!w.buffer)
+		goto out;
+
+	w.ret = write_all(stream, &hdr, sizeof(hdr));
+
+	if (!w.ret) {
+		w.ret = write_all(stream, bins,
+				  (bincount + 1) * sizeof(bins[0]));
+	}
+
+	for (i = 0; i < count && !w.ret; ++i)
+		write_entry(&w, map, entries + order[i], entrysize);
+
+	flush_buffer(&w);
+out:
+	free(w.buffer);
+	free(order);
+	free(entries);
+	free(pos);
+	free(bins);
+	return w.ret;
+}
+
+int tl_hashmap_snapshot_load(tl_hashmap_snapshot *this, tl_file *file,
+			     tl_hash keyhash, tl_compare keycompare)
+{
+	tl_iostream *stream = (tl_iostream *)file;
+	size_t actual, total = 0, entrysize;
+	const tl_file_mapping *mapping;
+	snap_header hdr;
+	const char *ptr;
+	tl_u64 size;
+	char last;
+	int ret;
+
+	assert(this && file && keyhash && keycompare);
+
+	ret = file->seek(file, 0);
+	if (ret)
+		return ret;
+
+	while (total < sizeof(hdr)) {
+		ret = stream->read(stream, (char *)&hdr + total,
+				   sizeof(hdr) - total, &actual);
+		if (ret)
+			return ret == TL_EOF ? TL_ERR_ARG : ret;
+		total += actual;
+	}
+
+	if (hdr.magic != SNAPSHOT_MAGIC || hdr.version != SNAPSHOT_VERSION)
+		return TL_ERR_ARG;
+	if (!hdr.keysize || !hdr.objsize || !hdr.bincount)
+		return TL_ERR_ARG;
+
+	entrysize = sizeof(tl_u64) + PAD8(hdr.keysize) + PAD8(hdr.objsize);
+
+	size = sizeof(hdr) + (hdr.bincount + 1) * sizeof(tl_u64) +
+	       hdr.count * entrysize;
+
+	if (size != hdr.size || size != (tl_u64)(size_t)size)
+		return TL_ERR_ARG;
+
+	/* accessing a mapping past the end of the file would crash */
+	if (file->seek(file, size - 1))
+		return TL_ERR_ARG;
+
+	if (stream->read(stream, &last, 1, &actual) || actual != 1)
+		return TL_ERR_ARG;
+
+	mapping = file->map(file, 0, (size_t)size, TL_MAP_READ);
+	if (!mapping)
+		return TL_ERR_INTERNAL;
+
+	ptr = ((const tl_blob *)mapping)->data;
+
+	memset(this, 0, sizeof(*this));
+	this->mapping = mapping;
+	this->bins = (const tl_u64 *)(ptr + sizeof(hdr));
+	this->entries = ptr + sizeof(hdr) + (hdr.bincount + 1) *
+					    sizeof(tl_u64);
+	this->bincount = hdr.bincount;
+	this->count = hdr.count;
+	this->keysize = hdr.keysize;
+	this->objsize = hdr.objsize;
+	this->keyoffset = sizeof(tl_u64);
+	this->objoffset = sizeof(tl_u64) + PAD8(hdr.keysize);
+	this->entrysize = entrysize;
+	this->hash = keyhash;
+	this->compare = keycompare;
+
+	if (this->bins[0] != 0 || this->bins[this->bincount] != hdr.count) {
+		tl_hashmap_snapshot_cleanup(this);
+		return TL_ERR_ARG;
+	}
+
+	return 0;
+}
+
+void tl_hashmap_snapshot_cleanup(tl_hashmap_snapshot *this)
+{
+	assert(this);
+
+	if (this->mapping)
+		this->mapping->destroy(this->mapping);
+
+	memset(this, 0, sizeof(*this));
+}
+
+const void *tl_hashmap_snapshot_at(const tl_hashmap_snapshot *this,
+				   const void *key)
+{
+	tl_u64 hash, i, end;
+	const char *ent;
+
+	assert(this && key);
+
+	hash = this->hash(key);
+	i = this->bins[hash % this->bincount];
+	end = this->bins[hash % this->bincount + 1];
+
+	/* a corrupted file must not make us read beyond the mapping */
+	if (end > this->count)
+		end = this->count;
+
+	for (ent = this->entries + i * this->entrysize; i < end;
+	     ++i, ent += this->entrysize) {
+		if (*((const tl_u64 *)ent) != hash)
+			continue;
+
+		if (this->compare(ent + this->keyoffset, key) == 0)
+			return ent + this->objoffset;
+	}
+
+	return NULL;
+}
@@ -13,6 +13,7 @@ int compare_ints( const void* a, const void* b )
 int main( void )
 {
     int i, j, vals[10] = { 20, 21, 22, 23, 24, 25, 26, 27, 28, 29 };
+    int buffer[8], batch[500];
     tl_array avec, bvec;
 
     tl_array_init( &avec, sizeof(int), NULL );
@@ -355,6 +356,33 @@ int main( void )
 
     tl_array_cleanup( &avec );
 
+    /* insert sorted in batches */
+    tl_array_init( &avec, sizeof(int), NULL );
+
+    for( i=0; i<500; ++i )
+        batch[i] = 1000 - 2 * i;
+
+    if( !tl_array_insert_sorted_batch( &avec, compare_ints, batch, 500 ) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<500; ++i )
+        batch[i] = 1 + 2 * ((i * 7) % 500);
+
+    if( !tl_array_insert_sorted_batch( &avec, compare_ints, batch, 250 ) ||
+        !tl_array_insert_sorted_batch( &avec, compare_ints, batch+250, 250 ) )
+        return EXIT_FAILURE;
+
+    if( avec.used!=1000 )
+        return EXIT_FAILURE;
+
+    for( i=1; i<=1000; ++i )
+    {
+        if( *((int*)tl_array_at( &avec, i-1 ))!=i )
+            return EXIT_FAILURE;
+    }
+
+    tl_array_cleanup( &avec );
+
     /* append array */
     tl_array_init( &avec, sizeof(int), NULL );
 
@@ -380,6 +408,46 @@ int main( void )
 
     tl_array_cleanup( &avec );
 
+    /* inline buffer */
+    tl_array_init_inline( &avec, sizeof(int), NULL, buffer, 8 );
+
+    for( i=0; i<8; ++i )
+        tl_array_append( &avec, vals+i );
+
+    if( avec.data != buffer || avec.used != 8 || buffer[7] != vals[7] )
+        return EXIT_FAILURE;
+
+    tl_array_remove( &avec, 1, 6 );
+    tl_array_prepend( &avec, vals+9 );
+
+    if( avec.data != buffer || avec.used != 3 || buffer[0] != vals[9] ||
+        buffer[1] != vals[0] || buffer[2] != vals[7] )
+        return EXIT_FAILURE;
+
+    /* spill over to the heap */
+    tl_array_append_array( &avec, vals, 10 );
+
+    if( avec.data == buffer || avec.used != 13 ||
+        *((int*)tl_array_at( &avec, 1 )) != vals[0] ||
+        *((int*)tl_array_at( &avec, 12 )) != vals[9] )
+        return EXIT_FAILURE;
+
+    tl_array_cleanup( &avec );
+
+    tl_array_init_inline( &avec, sizeof(int), NULL, buffer, 8 );
+    tl_array_init( &bvec, sizeof(int), NULL );
+    tl_array_append_array( &bvec, vals, 10 );
+
+    if( !tl_array_copy_range( &avec, &bvec, 0, 4 ) || avec.data != buffer )
+        return EXIT_FAILURE;
+
+    if( !tl_array_copy( &avec, &bvec ) || avec.data == buffer ||
+        avec.used != 10 || *((int*)tl_array_at( &avec, 9 )) != vals[9] )
+        return EXIT_FAILURE;
+
+    tl_array_cleanup( &avec );
+    tl_array_cleanup( &bvec );
+
     return EXIT_SUCCESS;
 }
 
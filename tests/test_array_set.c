@@ -0,0 +1,263 @@
+#include "tl_array.h"
+
+#include <stdlib.h>
+
+
+
+static unsigned long seed = 1;
+
+static unsigned long random_number( void )
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return (seed >> 8) & 0xFFFF;
+}
+
+static int compare_u64( const void* a, const void* b )
+{
+    tl_u64 x = *((const tl_u64*)a), y = *((const tl_u64*)b);
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int contains( const tl_array* arr, tl_u64 value )
+{
+    return tl_array_search( arr, compare_u64, &value ) != NULL;
+}
+
+/* fill a sorted set of 64 bit values, roughly count elements below range */
+static void make_set( tl_array* arr, size_t count, unsigned long range )
+{
+    tl_u64 value;
+    size_t i;
+
+    tl_array_clear( arr );
+
+    for( i=0; i<count; ++i )
+    {
+        value = random_number( ) % range;
+        tl_array_append( arr, &value );
+    }
+
+    tl_array_sort( arr, compare_u64 );
+    tl_array_unique( arr, NULL );
+}
+
+/*
+    fill a sorted set of 64 bit values above 2^32, where the low halves are
+    drawn from a small range so they collide across elements and only the
+    high halves tell them apart
+ */
+static void make_wide_set( tl_array* arr, size_t count, unsigned long hirange,
+                           unsigned long lorange )
+{
+    tl_u64 value;
+    size_t i;
+
+    tl_array_clear( arr );
+
+    for( i=0; i<count; ++i )
+    {
+        value = (tl_u64)(random_number( ) % hirange + 1) << 32;
+        value |= random_number( ) % lorange;
+        tl_array_append( arr, &value );
+    }
+
+    tl_array_sort( arr, compare_u64 );
+    tl_array_unique( arr, NULL );
+}
+
+/* convert a set of 64 bit values to 32 bit values */
+static void narrow( tl_array* dst, const tl_array* src )
+{
+    tl_u32 value;
+    size_t i;
+
+    tl_array_init( dst, sizeof(tl_u32), NULL );
+
+    for( i=0; i<src->used; ++i )
+    {
+        value = *((tl_u64*)tl_array_at( src, i ));
+        tl_array_append( dst, &value );
+    }
+}
+
+static tl_u64 get( const tl_array* arr, size_t i )
+{
+    if( arr->unitsize == sizeof(tl_u32) )
+        return *((tl_u32*)tl_array_at( arr, i ));
+    return *((tl_u64*)tl_array_at( arr, i ));
+}
+
+/* check a result against the definition, using the 64 bit inputs */
+static int check( const tl_array* res, const tl_array* a, const tl_array* b,
+                  int op )
+{
+    size_t i, count = 0;
+    tl_u64 x;
+
+    for( i=0; i<res->used; ++i )
+    {
+        x = get( res, i );
+
+        if( i > 0 && get( res, i - 1 ) >= x )
+            return 0;
+
+        if( op == 0 && !contains( a, x ) && !contains( b, x ) )
+            return 0;
+        if( op == 1 && !(contains( a, x ) && contains( b, x )) )
+            return 0;
+        if( op == 2 && !(contains( a, x ) && !contains( b, x )) )
+            return 0;
+    }
+
+    for( i=0; i<a->used; ++i )
+    {
+        x = *((tl_u64*)tl_array_at( a, i ));
+        count += (op == 0) || (op == 1 && contains( b, x )) ||
+                 (op == 2 && !contains( b, x ));
+    }
+
+    if( op == 0 )
+    {
+        for( i=0; i<b->used; ++i )
+            count += !contains( a, *((tl_u64*)tl_array_at( b, i )) );
+    }
+
+    return res->used == count;
+}
+
+/* generic and 64 bit integer code paths */
+static int run_u64( const tl_array* a, const tl_array* b )
+{
+    tl_array res;
+    int ret = 0;
+
+    tl_array_init( &res, sizeof(tl_u64), NULL );
+
+    if( !tl_array_union( &res, a, b, compare_u64 ) || !check( &res, a, b, 0 ) )
+        goto out;
+    if( !tl_array_union( &res, a, b, NULL ) || !check( &res, a, b, 0 ) )
+        goto out;
+
+    if( !tl_array_intersection( &res, a, b, compare_u64 ) ||
+        !check( &res, a, b, 1 ) )
+        goto out;
+    if( !tl_array_intersection( &res, a, b, NULL ) || !check( &res, a, b, 1 ) )
+        goto out;
+
+    if( !tl_array_difference( &res, a, b, compare_u64 ) ||
+        !check( &res, a, b, 2 ) )
+        goto out;
+    if( !tl_array_difference( &res, a, b, NULL ) || !check( &res, a, b, 2 ) )
+        goto out;
+
+    ret = 1;
+out:
+    tl_array_cleanup( &res );
+    return ret;
+}
+
+/* all of the above, plus the 32 bit integer code path */
+static int run( const tl_array* a, const tl_array* b )
+{
+    tl_array a32, b32, res32;
+    int ret = 0;
+
+    if( !run_u64( a, b ) )
+        return 0;
+
+    narrow( &a32, a );
+    narrow( &b32, b );
+    tl_array_init( &res32, sizeof(tl_u32), NULL );
+
+    if( !tl_array_union( &res32, &a32, &b32, NULL ) ||
+        !check( &res32, a, b, 0 ) )
+        goto out;
+    if( !tl_array_intersection( &res32, &a32, &b32, NULL ) ||
+        !check( &res32, a, b, 1 ) )
+        goto out;
+    if( !tl_array_difference( &res32, &a32, &b32, NULL ) ||
+        !check( &res32, a, b, 2 ) )
+        goto out;
+
+    ret = 1;
+out:
+    tl_array_cleanup( &a32 );
+    tl_array_cleanup( &b32 );
+    tl_array_cleanup( &res32 );
+    return ret;
+}
+
+
+
+int main( void )
+{
+    tl_array a, b;
+    size_t i, j;
+    int vals[10] = { 1, 1, 2, 3, 3, 3, 4, 5, 5, 6 };
+
+    /* unique */
+    tl_array_init( &a, sizeof(int), NULL );
+    tl_array_append_array( &a, vals, 10 );
+    tl_array_unique( &a, NULL );
+
+    if( a.used != 6 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<6; ++i )
+    {
+        if( *((int*)tl_array_at( &a, i )) != (int)i + 1 )
+            return EXIT_FAILURE;
+    }
+
+    tl_array_cleanup( &a );
+
+    /* similar sizes, skewed sizes and empty sets */
+    tl_array_init( &a, sizeof(tl_u64), NULL );
+    tl_array_init( &b, sizeof(tl_u64), NULL );
+
+    for( i=0; i<6; ++i )
+    {
+        for( j=0; j<6; ++j )
+        {
+            make_set( &a, i * i * 40, 2000 );
+            make_set( &b, j * j * 40, 2000 );
+
+            if( !run( &a, &b ) )
+                return EXIT_FAILURE;
+        }
+    }
+
+    /* one set much larger than the other, partially a subset */
+    make_set( &b, 20000, 60000 );
+    make_set( &a, 20, 60000 );
+
+    for( i=0; i<b.used; i+=1000 )
+        tl_array_insert_sorted( &a, compare_u64, tl_array_at( &b, i ) );
+
+    tl_array_unique( &a, NULL );
+
+    if( !run( &a, &b ) || !run( &b, &a ) )
+        return EXIT_FAILURE;
+
+    /* values above 2^32, equal low halves but different high halves */
+    for( i=0; i<6; ++i )
+    {
+        make_wide_set( &a, 100 + i * 200, 64, 4 );
+        make_wide_set( &b, 100 + (5 - i) * 200, 64, 4 );
+
+        if( !run_u64( &a, &b ) || !run_u64( &b, &a ) )
+            return EXIT_FAILURE;
+    }
+
+    /* the high half of one element equal to the low half of another */
+    make_wide_set( &a, 500, 8, 16 );
+    make_wide_set( &b, 500, 16, 8 );
+
+    if( !run_u64( &a, &b ) || !run_u64( &b, &a ) )
+        return EXIT_FAILURE;
+
+    tl_array_cleanup( &a );
+    tl_array_cleanup( &b );
+    return EXIT_SUCCESS;
+}
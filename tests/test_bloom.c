@@ -0,0 +1,123 @@
+#include "tl_bloom.h"
+#include "tl_blob.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_KEYS 10000
+#define NUM_PROBES 100000
+
+
+
+int main( void )
+{
+    tl_bloom bloom, copy;
+    size_t fp = 0;
+    tl_blob blob;
+    long i;
+
+    /* invalid rates */
+    if( tl_bloom_init( &bloom, NUM_KEYS, 0.0, 0 ) )
+        return EXIT_FAILURE;
+    if( tl_bloom_init( &bloom, NUM_KEYS, 1.0, 0 ) )
+        return EXIT_FAILURE;
+
+    if( !tl_bloom_init( &bloom, NUM_KEYS, 0.01, 1234 ) )
+        return EXIT_FAILURE;
+
+    if( bloom.k != 7 || !bloom.blockcount )
+        return EXIT_FAILURE;
+    if( ((size_t)bloom.blocks) % (TL_BLOOM_BLOCK_WORDS * sizeof(tl_u64)) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        if( tl_bloom_contains( &bloom, &i, sizeof(i) ) )
+            return EXIT_FAILURE;
+    }
+
+    /* no false negatives */
+    for( i=0; i<NUM_KEYS; i+=2 )
+        tl_bloom_add( &bloom, &i, sizeof(i) );
+
+    if( bloom.count != NUM_KEYS / 2 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_KEYS; i+=2 )
+    {
+        if( !tl_bloom_contains( &bloom, &i, sizeof(i) ) )
+            return EXIT_FAILURE;
+    }
+
+    /* fill up to the capacity and measure the false positive rate */
+    for( i=1; i<NUM_KEYS; i+=2 )
+        tl_bloom_add( &bloom, &i, sizeof(i) );
+
+    for( i=NUM_KEYS; i<NUM_KEYS+NUM_PROBES; ++i )
+    {
+        if( tl_bloom_contains( &bloom, &i, sizeof(i) ) )
+            ++fp;
+    }
+
+    if( fp > NUM_PROBES / 100 )
+        return EXIT_FAILURE;
+
+    /* serialize and restore */
+    if( !tl_bloom_serialize( &bloom, &blob ) )
+        return EXIT_FAILURE;
+
+    if( !tl_bloom_deserialize( &copy, &blob ) )
+        return EXIT_FAILURE;
+
+    if( copy.blockcount != bloom.blockcount || copy.k != bloom.k ||
+        copy.seed != bloom.seed || copy.count != bloom.count )
+        return EXIT_FAILURE;
+
+    if( memcmp( copy.blocks, bloom.blocks,
+                bloom.blockcount * TL_BLOOM_BLOCK_WORDS * sizeof(tl_u64) ) )
+        return EXIT_FAILURE;
+
+    tl_bloom_cleanup( &copy );
+
+    ((unsigned char*)blob.data)[0] = 'X';
+    if( tl_bloom_deserialize( &copy, &blob ) )
+        return EXIT_FAILURE;
+
+    ((unsigned char*)blob.data)[0] = 'T';
+    blob.size -= 1;
+    if( tl_bloom_deserialize( &copy, &blob ) )
+        return EXIT_FAILURE;
+    tl_blob_cleanup( &blob );
+
+    /* merge */
+    tl_bloom_init( &copy, NUM_KEYS, 0.01, 1234 );
+    i = -1;
+    tl_bloom_add( &copy, &i, sizeof(i) );
+
+    if( tl_bloom_contains( &bloom, &i, sizeof(i) ) )
+        return EXIT_FAILURE;
+    if( !tl_bloom_merge( &bloom, &copy ) )
+        return EXIT_FAILURE;
+    if( !tl_bloom_contains( &bloom, &i, sizeof(i) ) )
+        return EXIT_FAILURE;
+
+    tl_bloom_cleanup( &copy );
+    tl_bloom_init( &copy, NUM_KEYS, 0.01, 4321 );
+
+    if( tl_bloom_merge( &bloom, &copy ) )
+        return EXIT_FAILURE;
+
+    tl_bloom_cleanup( &copy );
+
+    /* clear */
+    tl_bloom_clear( &bloom );
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        if( tl_bloom_contains( &bloom, &i, sizeof(i) ) )
+            return EXIT_FAILURE;
+    }
+
+    tl_bloom_cleanup( &bloom );
+    return EXIT_SUCCESS;
+}
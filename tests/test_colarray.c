@@ -0,0 +1,260 @@
+#include "tl_colarray.h"
+#include "tl_array.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+typedef struct
+{
+    tl_u32 u32;
+    tl_s32 s32;
+    float f;
+    double d;
+    tl_u64 u64;
+    tl_s64 s64;
+}
+record;
+
+static const tl_colarray_field fields[ ] =
+{
+    { offsetof(record, u32), sizeof(tl_u32) },
+    { offsetof(record, s32), sizeof(tl_s32) },
+    { offsetof(record, f),   sizeof(float)  },
+    { offsetof(record, d),   sizeof(double) },
+    { offsetof(record, u64), sizeof(tl_u64) },
+    { offsetof(record, s64), sizeof(tl_s64) },
+};
+
+static const TL_COLUMN_TYPE types[ ] =
+{
+    TL_COLUMN_U32, TL_COLUMN_S32, TL_COLUMN_FLOAT,
+    TL_COLUMN_DOUBLE, TL_COLUMN_U64, TL_COLUMN_S64
+};
+
+#define NUM_COLS (sizeof(fields) / sizeof(fields[0]))
+#define NUM_ROWS 1000
+
+
+
+static void make_record( record* r, size_t i )
+{
+    memset( r, 0, sizeof(*r) );
+    r->u32 = (tl_u32)((i * 7919) % 100) + ((i & 1) ? 0x80000000UL : 0);
+    r->s32 = (tl_s32)((i * 31) % 100) - 50;
+    r->f   = (float)((i * 13) % 50) - 25.0f;
+    r->d   = (double)((i * 17) % 60) / 4.0 - 7.5;
+    r->u64 = ((tl_u64)((i * 3) % 20) << 32) | (tl_u64)(i % 5);
+    r->s64 = (tl_s64)((i * 11) % 40) - 20;
+}
+
+static int compare_values( const record* r, size_t col, const record* v )
+{
+    double a, b;
+
+    switch( col )
+    {
+    case 0: a = r->u32; b = v->u32; break;
+    case 1: a = r->s32; b = v->s32; break;
+    case 2: a = r->f;   b = v->f;   break;
+    case 3: a = r->d;   b = v->d;   break;
+    case 4:
+        return r->u64 < v->u64 ? -1 : (r->u64 > v->u64 ? 1 : 0);
+    default:
+        return r->s64 < v->s64 ? -1 : (r->s64 > v->s64 ? 1 : 0);
+    }
+
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static int matches( const record* r, size_t col, TL_SCAN_OP op,
+                    const record* v )
+{
+    int c = compare_values( r, col, v );
+
+    switch( op )
+    {
+    case TL_SCAN_LESS:          return c <  0;
+    case TL_SCAN_LESS_EQUAL:    return c <= 0;
+    case TL_SCAN_GREATER:       return c >  0;
+    case TL_SCAN_GREATER_EQUAL: return c >= 0;
+    case TL_SCAN_EQUAL:         return c == 0;
+    default:                    return c != 0;
+    }
+}
+
+static const void* get_field( const record* r, size_t col )
+{
+    return (const char*)r + fields[col].offset;
+}
+
+static int check_scan( tl_colarray* arr, const record* recs, size_t count )
+{
+    size_t col, i, j, *idx;
+    record value;
+    tl_array out;
+    int op;
+
+    tl_array_init( &out, sizeof(size_t), NULL );
+
+    for( col=0; col<NUM_COLS; ++col )
+    {
+        for( op=TL_SCAN_LESS; op<=TL_SCAN_NOT_EQUAL; ++op )
+        {
+            make_record( &value, 42 );
+
+            tl_array_clear( &out );
+            if( !tl_colarray_scan( arr, col, types[col], (TL_SCAN_OP)op,
+                                   get_field( &value, col ), &out ) )
+                return 0;
+
+            idx = out.data;
+
+            for( i=0, j=0; i<count; ++i )
+            {
+                if( !matches( recs+i, col, (TL_SCAN_OP)op, &value ) )
+                    continue;
+                if( j >= out.used || idx[j] != i )
+                    return 0;
+                ++j;
+            }
+
+            if( j != out.used )
+                return 0;
+        }
+    }
+
+    tl_array_cleanup( &out );
+    return 1;
+}
+
+
+
+int main( void )
+{
+    record recs[ NUM_ROWS ], r, v;
+    size_t i, j, *idx;
+    tl_colarray arr;
+    tl_array out;
+
+    for( i=0; i<NUM_ROWS; ++i )
+        make_record( recs+i, i );
+
+    /* append and get */
+    if( !tl_colarray_init( &arr, fields, NUM_COLS ) )
+        return EXIT_FAILURE;
+    if( !tl_colarray_is_empty( &arr ) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_ROWS/2; ++i )
+    {
+        if( !tl_colarray_append( &arr, recs+i ) )
+            return EXIT_FAILURE;
+    }
+
+    if( !tl_colarray_append_array( &arr, recs+NUM_ROWS/2, sizeof(record),
+                                   NUM_ROWS - NUM_ROWS/2 ) )
+        return EXIT_FAILURE;
+
+    if( tl_colarray_get_size( &arr ) != NUM_ROWS )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_ROWS; ++i )
+    {
+        memset( &r, 0, sizeof(r) );
+        if( !tl_colarray_get( &arr, i, &r ) )
+            return EXIT_FAILURE;
+        if( memcmp( &r, recs+i, sizeof(r) ) )
+            return EXIT_FAILURE;
+        if( *((tl_s32*)tl_colarray_at( &arr, 1, i )) != recs[i].s32 )
+            return EXIT_FAILURE;
+    }
+
+    if( ((double*)tl_colarray_column( &arr, 3 ))[7] != recs[7].d )
+        return EXIT_FAILURE;
+    if( tl_colarray_get( &arr, NUM_ROWS, &r ) )
+        return EXIT_FAILURE;
+    if( tl_colarray_at( &arr, 0, NUM_ROWS ) )
+        return EXIT_FAILURE;
+
+    /* scan every column with every operator, compare to brute force */
+    if( !check_scan( &arr, recs, NUM_ROWS ) )
+        return EXIT_FAILURE;
+
+    /* combine conditions on two columns */
+    tl_array_init( &out, sizeof(size_t), NULL );
+    make_record( &v, 42 );
+
+    if( !tl_colarray_scan( &arr, 1, TL_COLUMN_S32, TL_SCAN_GREATER, &v.s32,
+                           &out ) )
+        return EXIT_FAILURE;
+
+    tl_colarray_filter( &arr, 3, TL_COLUMN_DOUBLE, TL_SCAN_GREATER_EQUAL,
+                        &v.d, &out );
+
+    idx = out.data;
+
+    for( i=0, j=0; i<NUM_ROWS; ++i )
+    {
+        if( !matches( recs+i, 1, TL_SCAN_GREATER, &v ) ||
+            !matches( recs+i, 3, TL_SCAN_GREATER_EQUAL, &v ) )
+            continue;
+        if( j >= out.used || idx[j] != i )
+            return EXIT_FAILURE;
+        ++j;
+    }
+
+    if( j != out.used || j == 0 )
+        return EXIT_FAILURE;
+
+    tl_array_cleanup( &out );
+
+    /* set and remove keep all columns in sync */
+    make_record( &r, 5 );
+    if( !tl_colarray_set( &arr, 0, &r ) )
+        return EXIT_FAILURE;
+    if( tl_colarray_set( &arr, NUM_ROWS, &r ) )
+        return EXIT_FAILURE;
+    recs[0] = r;
+
+    tl_colarray_remove( &arr, 100, 237 );
+    memmove( recs+100, recs+337, (NUM_ROWS - 337) * sizeof(record) );
+
+    if( tl_colarray_get_size( &arr ) != NUM_ROWS - 237 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_ROWS-237; ++i )
+    {
+        memset( &r, 0, sizeof(r) );
+        if( !tl_colarray_get( &arr, i, &r ) )
+            return EXIT_FAILURE;
+        if( memcmp( &r, recs+i, sizeof(r) ) )
+            return EXIT_FAILURE;
+    }
+
+    if( !check_scan( &arr, recs, NUM_ROWS - 237 ) )
+        return EXIT_FAILURE;
+
+    /* removing past the end truncates */
+    tl_colarray_remove( &arr, 10, NUM_ROWS );
+    if( tl_colarray_get_size( &arr ) != 10 )
+        return EXIT_FAILURE;
+    if( !check_scan( &arr, recs, 10 ) )
+        return EXIT_FAILURE;
+
+    tl_colarray_remove( &arr, 0, 10 );
+    if( !tl_colarray_is_empty( &arr ) )
+        return EXIT_FAILURE;
+
+    /* reserving more rows than a column can address must fail */
+    if( tl_colarray_reserve( &arr, ((size_t)-1) / sizeof(double) + 1 ) )
+        return EXIT_FAILURE;
+    if( !tl_colarray_append( &arr, recs ) || !check_scan( &arr, recs, 1 ) )
+        return EXIT_FAILURE;
+
+    tl_colarray_cleanup( &arr );
+    return EXIT_SUCCESS;
+}
+
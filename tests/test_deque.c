@@ -0,0 +1,166 @@
+#include "tl_iterator.h"
+#include "tl_deque.h"
+
+#include <stdlib.h>
+
+
+
+static int check( const tl_deque* deque, int first, size_t count )
+{
+    size_t i, idx, run;
+    int* ptr;
+
+    if( deque->used != count || tl_deque_at( deque, count ) )
+        return 0;
+
+    for( i=0; i<count; ++i )
+    {
+        if( *((int*)tl_deque_at( deque, i )) != first + (int)i )
+            return 0;
+    }
+
+    /* the same elements, visited segment wise */
+    for( idx=0; idx<count; idx+=run )
+    {
+        ptr = tl_deque_get_segment( deque, idx, &run );
+
+        if( !ptr || !run )
+            return 0;
+
+        for( i=0; i<run; ++i )
+        {
+            if( ptr[i] != first + (int)(idx + i) )
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+
+int main( void )
+{
+    int i, vals[100], out[100];
+    tl_iterator* it;
+    tl_deque dq;
+
+    for( i=0; i<100; ++i )
+        vals[i] = i;
+
+    tl_deque_init( &dq, sizeof(int), NULL );
+
+    if( !tl_deque_is_empty( &dq ) || tl_deque_get_first( &dq ) ||
+        tl_deque_get_last( &dq ) || tl_deque_drop_first( &dq, out, 10 ) )
+        return EXIT_FAILURE;
+
+    /* FIFO that keeps wrapping around */
+    for( i=0; i<1000; ++i )
+    {
+        if( !tl_deque_append( &dq, &i ) )
+            return EXIT_FAILURE;
+
+        if( i >= 5 )
+        {
+            if( *((int*)tl_deque_get_first( &dq )) != i - 5 )
+                return EXIT_FAILURE;
+            tl_deque_remove_first( &dq );
+        }
+    }
+
+    if( dq.reserved != 8 || !check( &dq, 995, 5 ) )
+        return EXIT_FAILURE;
+
+    /* grow while wrapped around, from both ends */
+    for( i=994; i>=950; --i )
+    {
+        if( !tl_deque_prepend( &dq, &i ) )
+            return EXIT_FAILURE;
+    }
+
+    if( !check( &dq, 950, 50 ) || !tl_deque_append_array( &dq, vals, 100 ) )
+        return EXIT_FAILURE;
+
+    if( tl_deque_drop_first( &dq, out, 50 ) != 50 || !check( &dq, 0, 100 ) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<50; ++i )
+    {
+        if( out[i] != 950 + i )
+            return EXIT_FAILURE;
+    }
+
+    /* take from the back */
+    if( tl_deque_drop_last( &dq, out, 10 ) != 10 || !check( &dq, 0, 90 ) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<10; ++i )
+    {
+        if( out[i] != 90 + i )
+            return EXIT_FAILURE;
+    }
+
+    tl_deque_remove_last( &dq );
+
+    if( *((int*)tl_deque_get_last( &dq )) != 88 || !check( &dq, 0, 89 ) )
+        return EXIT_FAILURE;
+
+    /* remove ranges near the front and near the back */
+    tl_deque_remove( &dq, 1, 2 );
+    tl_deque_remove( &dq, 84, 10 );
+    tl_deque_to_array( &dq, out );
+
+    if( dq.used != 84 || out[0] != 0 || out[1] != 3 || out[83] != 85 )
+        return EXIT_FAILURE;
+
+    for( i=1; i<84; ++i )
+    {
+        if( out[i] != i + 2 )
+            return EXIT_FAILURE;
+    }
+
+    /* iterate forward, removing every other element */
+    it = tl_deque_first( &dq );
+
+    for( i=0; it->has_data( it ); ++i )
+    {
+        if( *((int*)it->get_value( it )) != out[i] )
+            return EXIT_FAILURE;
+
+        if( i & 1 )
+        {
+            it->remove( it );
+        }
+        else
+        {
+            it->next( it );
+        }
+    }
+    it->destroy( it );
+
+    if( i != 84 || dq.used != 42 )
+        return EXIT_FAILURE;
+
+    /* iterate backwards */
+    it = tl_deque_last( &dq );
+
+    for( i=41; it->has_data( it ); --i )
+    {
+        if( *((int*)it->get_value( it )) != out[i * 2] )
+            return EXIT_FAILURE;
+        it->next( it );
+    }
+    it->destroy( it );
+
+    if( i != -1 )
+        return EXIT_FAILURE;
+
+    tl_deque_clear( &dq );
+
+    if( !tl_deque_is_empty( &dq ) || !tl_deque_reserve( &dq, 1000 ) ||
+        dq.reserved != 1024 )
+        return EXIT_FAILURE;
+
+    tl_deque_cleanup( &dq );
+    return EXIT_SUCCESS;
+}
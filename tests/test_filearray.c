@@ -0,0 +1,135 @@
+#include "tl_filearray.h"
+#include "tl_file.h"
+#include "tl_fs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FILENAME "filearray.bin"
+#define COUNT 100000
+
+
+
+int main( void )
+{
+    tl_filearray arr;
+    tl_u64 buffer[ 100 ];
+    tl_file* file;
+    tl_u64 i, j;
+
+    tl_fs_delete( FILENAME );
+
+    /* the file has to exist unless it should be created */
+    if( tl_filearray_open( &arr, FILENAME, sizeof(tl_u64), 0 ) == 0 )
+        return EXIT_FAILURE;
+
+    if( tl_filearray_open( &arr, FILENAME, sizeof(tl_u64), TL_READ ) !=
+        TL_ERR_ARG )
+        return EXIT_FAILURE;
+
+    /* append, growing the file a few times */
+    if( tl_filearray_open( &arr, FILENAME, sizeof(tl_u64), TL_CREATE ) )
+        return EXIT_FAILURE;
+
+    if( !tl_filearray_is_empty( &arr ) || arr.reserved == 0 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<COUNT/2; ++i )
+    {
+        j = i * 3;
+        if( tl_filearray_append( &arr, &j ) )
+            return EXIT_FAILURE;
+    }
+
+    for( ; i<COUNT; i+=100 )
+    {
+        for( j=0; j<100; ++j )
+            buffer[j] = (i + j) * 3;
+
+        if( tl_filearray_append_array( &arr, buffer, 100 ) )
+            return EXIT_FAILURE;
+    }
+
+    if( tl_filearray_get_size( &arr ) != COUNT || arr.reserved < COUNT )
+        return EXIT_FAILURE;
+
+    for( i=0; i<COUNT; ++i )
+    {
+        if( *((tl_u64*)tl_filearray_at( &arr, i )) != i * 3 )
+            return EXIT_FAILURE;
+    }
+
+    if( tl_filearray_at( &arr, COUNT ) )
+        return EXIT_FAILURE;
+
+    tl_filearray_flush( &arr );
+    tl_filearray_cleanup( &arr );
+
+    /* reopen it, the elements are still there */
+    if( tl_filearray_open( &arr, FILENAME, sizeof(tl_u64), 0 ) )
+        return EXIT_FAILURE;
+
+    if( tl_filearray_get_size( &arr ) != COUNT )
+        return EXIT_FAILURE;
+
+    for( i=0; i<COUNT; ++i )
+    {
+        if( *((tl_u64*)tl_filearray_at( &arr, i )) != i * 3 )
+            return EXIT_FAILURE;
+    }
+
+    /* shrinking and growing again clears the elements */
+    if( tl_filearray_resize( &arr, 10 ) || tl_filearray_get_size( &arr ) != 10 )
+        return EXIT_FAILURE;
+
+    if( tl_filearray_resize( &arr, 4 * COUNT ) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<4*COUNT; ++i )
+    {
+        j = *((tl_u64*)tl_filearray_at( &arr, i ));
+
+        if( j != (i < 10 ? i * 3 : 0) )
+            return EXIT_FAILURE;
+    }
+
+    tl_filearray_cleanup( &arr );
+
+    /* the element size has to match */
+    if( tl_filearray_open( &arr, FILENAME, sizeof(tl_u32), 0 ) != TL_ERR_ARG )
+        return EXIT_FAILURE;
+
+    if( tl_filearray_open( &arr, FILENAME, sizeof(tl_u64), 0 ) )
+        return EXIT_FAILURE;
+
+    if( tl_filearray_get_size( &arr ) != 4 * COUNT )
+        return EXIT_FAILURE;
+
+    tl_filearray_cleanup( &arr );
+
+    /* overwriting starts a new array */
+    if( tl_filearray_open( &arr, FILENAME, sizeof(tl_u32), TL_OVERWRITE ) )
+        return EXIT_FAILURE;
+
+    if( !tl_filearray_is_empty( &arr ) )
+        return EXIT_FAILURE;
+
+    tl_filearray_cleanup( &arr );
+
+    /* a file that is not an array is rejected */
+    if( tl_file_open( FILENAME, &file, TL_WRITE|TL_OVERWRITE ) )
+        return EXIT_FAILURE;
+
+    if( ((tl_iostream*)file)->write( (tl_iostream*)file, "not an array",
+                                     12, NULL ) )
+        return EXIT_FAILURE;
+
+    ((tl_iostream*)file)->destroy( (tl_iostream*)file );
+
+    if( tl_filearray_open( &arr, FILENAME, sizeof(tl_u64), 0 ) != TL_ERR_ARG )
+        return EXIT_FAILURE;
+
+    tl_fs_delete( FILENAME );
+    return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,170 @@
+#include "tl_iterator.h"
+#include "tl_flatmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    return (*((unsigned long*)obj)) / 10;
+}
+
+
+
+int main( void )
+{
+    long test_keys[ ] = {   5,   6,   7,  12,  20 };
+    long test_vals[ ] = { 100, 200, 300, 400, 500 };
+    tl_flatmap map, copy;
+    tl_iterator* it;
+    long i, j, l;
+
+    /* insert and retrieve */
+    tl_flatmap_init(&map,sizeof(long),sizeof(long),10,hash,compare,NULL,NULL);
+
+    if( !tl_flatmap_is_empty( &map ) || map.bincount != 16 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<5; ++i )
+    {
+        if( tl_flatmap_at( &map, test_keys+i ) )
+            return EXIT_FAILURE;
+
+        tl_flatmap_insert( &map, test_keys+i, test_vals+i );
+
+        if( !tl_flatmap_at( &map, test_keys+i ) )
+            return EXIT_FAILURE;
+
+        if( *((long*)tl_flatmap_at( &map, test_keys+i )) != test_vals[i] )
+            return EXIT_FAILURE;
+    }
+
+    if( map.count != 5 )
+        return EXIT_FAILURE;
+
+    /* inserting an existing key overwrites it */
+    tl_flatmap_insert( &map, test_keys, test_vals+4 );
+
+    if( map.count != 5 )
+        return EXIT_FAILURE;
+    if( *((long*)tl_flatmap_at( &map, test_keys )) != test_vals[4] )
+        return EXIT_FAILURE;
+
+    if( !tl_flatmap_set( &map, test_keys, test_vals ) )
+        return EXIT_FAILURE;
+    if( *((long*)tl_flatmap_at( &map, test_keys )) != test_vals[0] )
+        return EXIT_FAILURE;
+
+    /* remove */
+    for( i=0; i<5; ++i )
+    {
+        if( !tl_flatmap_remove( &map, test_keys+i, &l ) || l!=test_vals[i] )
+            return EXIT_FAILURE;
+
+        if( tl_flatmap_remove( &map, test_keys+i, NULL ) )
+            return EXIT_FAILURE;
+
+        for( j=0; j<5; ++j )
+        {
+            if( (j <= i) != !tl_flatmap_at( &map, test_keys+j ) )
+                return EXIT_FAILURE;
+        }
+    }
+
+    if( !tl_flatmap_is_empty( &map ) )
+        return EXIT_FAILURE;
+
+    if( tl_flatmap_set( &map, test_keys, test_vals ) )
+        return EXIT_FAILURE;
+
+    /* growing and tombstone reuse */
+    for( i=0; i<10000; ++i )
+    {
+        l = i * 3;
+        if( !tl_flatmap_insert( &map, &i, &l ) )
+            return EXIT_FAILURE;
+
+        if( (i % 3) == 0 && !tl_flatmap_remove( &map, &i, NULL ) )
+            return EXIT_FAILURE;
+    }
+
+    if( map.count != 6666 || map.bincount < 6666 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<10000; ++i )
+    {
+        if( (i % 3) == 0 )
+        {
+            if( tl_flatmap_at( &map, &i ) )
+                return EXIT_FAILURE;
+        }
+        else if( *((long*)tl_flatmap_at( &map, &i )) != i * 3 )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* copy */
+    memset( &copy, 0, sizeof(copy) );
+
+    if( !tl_flatmap_copy( &copy, &map ) || copy.count != map.count )
+        return EXIT_FAILURE;
+
+    for( i=1; i<10000; i+=3 )
+    {
+        if( *((long*)tl_flatmap_at( &copy, &i )) != i * 3 )
+            return EXIT_FAILURE;
+    }
+
+    /* iterate and remove */
+    it = tl_flatmap_get_iterator( &copy );
+
+    for( j=0; it->has_data( it ); ++j )
+    {
+        i = *((long*)it->get_key( it ));
+        l = *((long*)it->get_value( it ));
+
+        if( (i % 3) == 0 || l != i * 3 )
+            return EXIT_FAILURE;
+
+        if( i & 1 )
+        {
+            it->remove( it );
+        }
+        else
+        {
+            it->next( it );
+        }
+    }
+
+    if( j != 6666 || copy.count != 3333 )
+        return EXIT_FAILURE;
+
+    it->reset( it );
+    for( j=0; it->has_data( it ); ++j )
+    {
+        if( *((long*)it->get_key( it )) & 1 )
+            return EXIT_FAILURE;
+        it->next( it );
+    }
+    it->destroy( it );
+
+    if( j != 3333 )
+        return EXIT_FAILURE;
+
+    tl_flatmap_clear( &copy );
+
+    if( !tl_flatmap_is_empty( &copy ) || tl_flatmap_at( &copy, test_keys ) )
+        return EXIT_FAILURE;
+
+    tl_flatmap_cleanup( &map );
+    tl_flatmap_cleanup( &copy );
+    return EXIT_SUCCESS;
+}
@@ -1,3 +1,5 @@
+#include "tl_allocator.h"
+#include "tl_iterator.h"
 #include "tl_hashmap.h"
 
 #include <stdlib.h>
@@ -16,6 +18,20 @@ unsigned long hash( const void* obj )
     return (*((unsigned long*)obj)) / 10;
 }
 
+static size_t hash_calls = 0, compare_calls = 0;
+
+static int counting_compare( const void* a, const void* b )
+{
+    ++compare_calls;
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long counting_hash( const void* obj )
+{
+    ++hash_calls;
+    return *((unsigned long*)obj);
+}
+
 static int compare_structure( const tl_hashmap* a, const tl_hashmap* b )
 {
     tl_hashmap_entry *ait, *bit;
@@ -62,6 +78,342 @@ static int compare_structure( const tl_hashmap* a, const tl_hashmap* b )
     return 1;
 }
 
+static int test_grow( void )
+{
+    tl_hashmap map, copy;
+    tl_iterator* it;
+    long i, j, l;
+
+    tl_hashmap_init(&map,sizeof(long),sizeof(long),4,hash,compare,NULL,NULL);
+    tl_hashmap_set_max_load( &map, 75 );
+    memset( &copy, 0, sizeof(copy) );
+
+    for( i=0; i<5000; ++i )
+    {
+        l = i * 3;
+        if( !tl_hashmap_insert( &map, &i, &l ) )
+            return 0;
+
+        /* a key inserted twice must shadow the older entry */
+        if( (i % 100) == 0 )
+        {
+            l = -i;
+            tl_hashmap_insert( &map, &i, &l );
+        }
+
+        if( map.count != (size_t)(i + 1 + i / 100 + 1) )
+            return 0;
+
+        if( (i % 97) == 0 )
+        {
+            for( j=0; j<=i; ++j )
+            {
+                l = (j % 100) == 0 ? -j : j * 3;
+                if( !tl_hashmap_at( &map, &j ) )
+                    return 0;
+                if( *((long*)tl_hashmap_at( &map, &j )) != l )
+                    return 0;
+            }
+        }
+    }
+
+    if( map.bincount <= 4 || map.count != 5050 )
+        return 0;
+
+    /* copies and iterators must cover both tables */
+    if( !tl_hashmap_copy( &copy, &map ) || copy.count != map.count )
+        return 0;
+
+    it = tl_hashmap_get_iterator( &copy );
+    for( j=0; it->has_data( it ); ++j )
+        it->next( it );
+    it->destroy( it );
+
+    if( j != 5050 )
+        return 0;
+
+    /* remove the shadowing entries, then everything else */
+    for( i=0; i<5000; i+=100 )
+    {
+        if( !tl_hashmap_remove( &map, &i, &l ) || l != -i )
+            return 0;
+        if( *((long*)tl_hashmap_at( &map, &i )) != i * 3 )
+            return 0;
+    }
+
+    for( i=0; i<5000; ++i )
+    {
+        if( !tl_hashmap_remove( &map, &i, &l ) || l != i * 3 )
+            return 0;
+        if( tl_hashmap_at( &map, &i ) )
+            return 0;
+    }
+
+    if( !tl_hashmap_is_empty( &map ) )
+        return 0;
+
+    /* removing through an iterator while the copy may still grow */
+    it = tl_hashmap_get_iterator( &copy );
+    while( it->has_data( it ) )
+        it->remove( it );
+    it->destroy( it );
+
+    if( !tl_hashmap_is_empty( &copy ) )
+        return 0;
+
+    tl_hashmap_cleanup( &map );
+    tl_hashmap_cleanup( &copy );
+    return 1;
+}
+
+static int test_emplace( void )
+{
+    tl_hashmap map;
+    int created;
+    long i, key;
+    long* ptr;
+
+    tl_hashmap_init( &map, sizeof(long), sizeof(long), 4,
+                     counting_hash, counting_compare, NULL, NULL );
+    tl_hashmap_set_max_load( &map, 75 );
+    hash_calls = 0;
+
+    /* count how often every key occurs, hashing each key only once */
+    for( i=0; i<3000; ++i )
+    {
+        key = i % 1000;
+        ptr = tl_hashmap_emplace( &map, &key, &created );
+
+        if( !ptr || created != (i < 1000) )
+            return 0;
+        if( created && *ptr != 0 )
+            return 0;
+
+        *ptr += 1;
+    }
+
+    if( hash_calls != 3000 || map.count != 1000 )
+        return 0;
+
+    for( i=0; i<1000; ++i )
+    {
+        if( *((long*)tl_hashmap_at( &map, &i )) != 3 )
+            return 0;
+    }
+
+    tl_hashmap_cleanup( &map );
+    return 1;
+}
+
+static size_t init_calls = 0, cleanup_calls = 0;
+
+static int value_init( tl_allocator* alc, void* ptr )
+{
+    (void)alc;
+    *((long*)ptr) = 42;
+    ++init_calls;
+    return 1;
+}
+
+static void value_cleanup( tl_allocator* alc, void* ptr )
+{
+    (void)alc;
+    if( *((long*)ptr) >= 42 )
+        ++cleanup_calls;
+}
+
+static int test_emplace_alloc( void )
+{
+    tl_allocator alloc;
+    tl_hashmap map;
+    long i, key;
+    long* ptr;
+
+    memset( &alloc, 0, sizeof(alloc) );
+    alloc.init = value_init;
+    alloc.cleanup = value_cleanup;
+
+    tl_hashmap_init( &map, sizeof(long), sizeof(long), 16,
+                     hash, compare, NULL, &alloc );
+
+    /* new values are constructed by the allocator */
+    for( i=0; i<200; ++i )
+    {
+        key = i % 100;
+        ptr = tl_hashmap_emplace( &map, &key, NULL );
+
+        if( !ptr || *ptr < 42 )
+            return 0;
+
+        *ptr += 1;
+    }
+
+    if( init_calls != 100 )
+        return 0;
+
+    key = 7;
+    if( !tl_hashmap_remove( &map, &key, NULL ) || cleanup_calls != 1 )
+        return 0;
+
+    /* every cleanup matches an init */
+    tl_hashmap_cleanup( &map );
+    return cleanup_calls == 100;
+}
+
+static int test_bulk( void )
+{
+    unsigned long hashes[ 1000 ];
+    size_t i, j, n, width, ranges = 8, indices[ 1000 ];
+    long keys[ 1000 ], vals[ 1000 ];
+    tl_hashmap map;
+    long* ptr;
+
+    for( i=0; i<1000; ++i )
+    {
+        keys[ i ] = i % 800;
+        vals[ i ] = i;
+        hashes[ i ] = hash( keys + i );
+    }
+
+    tl_hashmap_init(&map,sizeof(long),sizeof(long),16,hash,compare,NULL,NULL);
+
+    /* discarding a bulk fill leaves the map as it was */
+    width = tl_hashmap_bulk_begin( &map, 200, &ranges );
+    if( !width || ranges > 8 || width * ranges < 200 )
+        return 0;
+
+    /* the hash is key / 10, so the first width * 10 pairs go to range 0 */
+    for( i=0; i<1000; ++i )
+        indices[ i ] = i;
+
+    if( !tl_hashmap_bulk_fill( &map, 0, keys, vals, hashes, indices,
+                               width * 10 ) )
+        return 0;
+
+    tl_hashmap_bulk_end( &map, 0 );
+
+    if( map.bincount != 16 || map.count || map.bulk )
+        return 0;
+    if( tl_hashmap_get_bin( &map, 0 ) )
+        return 0;
+
+    /* fill every range with its pairs, in array order */
+    width = tl_hashmap_bulk_begin( &map, 200, &ranges );
+    if( !width )
+        return 0;
+
+    for( i=0; i<ranges; ++i )
+    {
+        for( n=0, j=0; j<1000; ++j )
+        {
+            if( (hashes[ j ] % map.bincount) / width == i )
+                indices[ n++ ] = j;
+        }
+
+        if( !tl_hashmap_bulk_fill( &map, i, keys, vals, hashes,
+                                   indices, n ) )
+            return 0;
+    }
+
+    tl_hashmap_bulk_end( &map, 1 );
+
+    if( map.bincount != 200 || map.count != 1000 )
+        return 0;
+
+    /* duplicates added later shadow the earlier ones */
+    for( i=0; i<800; ++i )
+    {
+        ptr = tl_hashmap_at( &map, keys + i );
+
+        if( !ptr || *ptr != (long)(i < 200 ? i + 800 : i) )
+            return 0;
+    }
+
+    tl_hashmap_cleanup( &map );
+    return 1;
+}
+
+static int test_stats( void )
+{
+    tl_hashmap_stats stats;
+    tl_hashmap map;
+    long i;
+
+    /* hash is key / 10, so 100 keys fill 10 bins with chains of 10 */
+    tl_hashmap_init(&map,sizeof(long),sizeof(long),16,hash,compare,NULL,NULL);
+
+    tl_hashmap_get_stats( &map, &stats );
+
+    if( stats.count != 0 || stats.bincount != 16 || stats.used_bins != 0 )
+        return 0;
+    if( stats.chain_histogram[0] != 16 || stats.overflow_bytes != 0 )
+        return 0;
+
+    for( i=0; i<100; ++i )
+        tl_hashmap_insert( &map, &i, &i );
+
+    tl_hashmap_get_stats( &map, &stats );
+
+    if( stats.count != 100 || stats.used_bins != 10 )
+        return 0;
+    if( stats.longest_chain != 10 || stats.load_factor != 100.0 / 16.0 )
+        return 0;
+    if( stats.chain_histogram[0] != 6 )
+        return 0;
+    if( stats.chain_histogram[TL_HASHMAP_HISTOGRAM_SIZE - 1] != 10 )
+        return 0;
+    if( stats.overflow_bytes < (90 + stats.overflow_free) * map.binsize )
+        return 0;
+
+    /* removed overflow entries are still allocated */
+    for( i=0; i<100; i+=10 )
+        tl_hashmap_remove( &map, &i, NULL );
+
+    tl_hashmap_get_stats( &map, &stats );
+
+    if( stats.count != 90 || stats.longest_chain != 9 )
+        return 0;
+    if( stats.chain_histogram[TL_HASHMAP_HISTOGRAM_SIZE - 1] != 10 )
+        return 0;
+
+    tl_hashmap_cleanup( &map );
+    return 1;
+}
+
+static int test_hash_cache( void )
+{
+    tl_hashmap map;
+    long i, l;
+
+    tl_hashmap_init( &map, sizeof(long), sizeof(long), 4,
+                     counting_hash, counting_compare, NULL, NULL );
+    tl_hashmap_set_max_load( &map, 75 );
+
+    /* growing must use the stored hashes instead of hashing again */
+    for( i=0; i<1000; ++i )
+    {
+        l = i * 3;
+        if( !tl_hashmap_insert( &map, &i, &l ) )
+            return 0;
+    }
+
+    if( map.bincount <= 4 || hash_calls != 1000 || compare_calls != 0 )
+        return 0;
+
+    /* keys with different hashes sharing a bin are never compared */
+    for( i=0; i<1000; ++i )
+    {
+        if( *((long*)tl_hashmap_at( &map, &i )) != i * 3 )
+            return 0;
+    }
+
+    if( compare_calls != 1000 )
+        return 0;
+
+    tl_hashmap_cleanup( &map );
+    return 1;
+}
+
 
 
 int main( void )
@@ -70,6 +422,7 @@ int main( void )
     long test_vals[ ] = { 100, 200, 300, 400, 500 };
     tl_hashmap map, copy;
     size_t i, j;
+    void* pool;
     long l;
 
     /* insert and retrieve */
@@ -235,6 +588,59 @@ int main( void )
     tl_hashmap_cleanup( &map );
     tl_hashmap_cleanup( &copy );
 
+    /* automatic growing */
+    if( !test_hash_cache( ) )
+        return EXIT_FAILURE;
+
+    if( !test_emplace( ) )
+        return EXIT_FAILURE;
+
+    if( !test_emplace_alloc( ) )
+        return EXIT_FAILURE;
+
+    if( !test_bulk( ) )
+        return EXIT_FAILURE;
+
+    if( !test_stats( ) )
+        return EXIT_FAILURE;
+
+    if( !test_grow( ) )
+        return EXIT_FAILURE;
+
+    /* removed overflow entries are reused */
+    tl_hashmap_init(&map,sizeof(long),sizeof(long),10,hash,compare,NULL,NULL);
+
+    for( j=0; j<10; ++j )
+    {
+        for( i=0; i<100; ++i )
+        {
+            l = j;
+            tl_hashmap_insert( &map, test_keys, &l );
+        }
+
+        if( j == 0 )
+            pool = map.pool;
+
+        if( map.pool != pool || map.free_list )
+            return EXIT_FAILURE;
+
+        for( i=0; i<100; ++i )
+        {
+            if( !tl_hashmap_remove( &map, test_keys, &l ) || l != (long)j )
+                return EXIT_FAILURE;
+        }
+
+        if( !tl_hashmap_is_empty( &map ) || !map.free_list )
+            return EXIT_FAILURE;
+    }
+
+    tl_hashmap_clear( &map );
+
+    if( map.pool || map.free_list )
+        return EXIT_FAILURE;
+
+    tl_hashmap_cleanup( &map );
+
     return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,122 @@
+#include "tl_hashmap.h"
+
+#include <stdlib.h>
+
+#define NUM_KEYS 1000000
+#define NUM_LOOKUPS 1000000
+#define BATCH 64
+
+
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    unsigned long x = *((unsigned long*)obj);
+
+    x ^= x >> 16;
+    x *= 0x45d9f3bUL;
+    x ^= x >> 16;
+    return x;
+}
+
+
+
+int main( void )
+{
+    long *keys, *vals, *lookup;
+    void* out[ BATCH ];
+    unsigned long sum0, sum1;
+    tl_hashmap map;
+    size_t i, j;
+
+    keys = malloc( NUM_KEYS * sizeof(long) );
+    vals = malloc( NUM_KEYS * sizeof(long) );
+    lookup = malloc( NUM_LOOKUPS * sizeof(long) );
+
+    if( !keys || !vals || !lookup )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        keys[i] = (long)i * 7;
+        vals[i] = (long)i;
+    }
+
+    /* every fourth lookup is a miss */
+    srand( 42 );
+    for( i=0; i<NUM_LOOKUPS; ++i )
+    {
+        lookup[i] = (long)(rand( ) % NUM_KEYS) * 7;
+        if( (i % 4) == 3 )
+            lookup[i] += 1;
+    }
+
+    /* batch insert into a growing map */
+    tl_hashmap_init(&map,sizeof(long),sizeof(long),16,hash,compare,NULL,NULL);
+    tl_hashmap_set_max_load( &map, 100 );
+
+    if( tl_hashmap_insert_batch( &map, keys, vals, NUM_KEYS ) != NUM_KEYS )
+        return EXIT_FAILURE;
+
+    if( map.count != NUM_KEYS )
+        return EXIT_FAILURE;
+
+    if( tl_hashmap_insert_batch( &map, keys, vals, 0 ) != 0 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        if( *((long*)tl_hashmap_at( &map, keys+i )) != vals[i] )
+            return EXIT_FAILURE;
+    }
+
+    /* batch lookup must agree with single lookups, including misses */
+    for( i=0; i<NUM_LOOKUPS; i+=BATCH )
+    {
+        if( tl_hashmap_at_batch( &map, lookup+i, BATCH, out ) !=
+            BATCH - BATCH / 4 )
+        {
+            return EXIT_FAILURE;
+        }
+
+        for( j=0; j<BATCH; ++j )
+        {
+            if( out[j] != tl_hashmap_at( &map, lookup+i+j ) )
+                return EXIT_FAILURE;
+        }
+    }
+
+    /* looped single lookups and batched lookups yield the same values */
+    sum0 = sum1 = 0;
+
+    for( i=0; i<NUM_LOOKUPS; ++i )
+    {
+        out[0] = tl_hashmap_at( &map, lookup+i );
+        if( out[0] )
+            sum0 += *((long*)out[0]);
+    }
+
+    for( i=0; i<NUM_LOOKUPS; i+=BATCH )
+    {
+        tl_hashmap_at_batch( &map, lookup+i, BATCH, out );
+
+        for( j=0; j<BATCH; ++j )
+        {
+            if( out[j] )
+                sum1 += *((long*)out[j]);
+        }
+    }
+
+    if( sum0 != sum1 )
+        return EXIT_FAILURE;
+
+    tl_hashmap_cleanup( &map );
+    free( lookup );
+    free( vals );
+    free( keys );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#include "tl_ihashmap.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+
+#define NUM_ITEMS 10000
+
+
+
+typedef struct
+{
+    long key;
+    long value;
+    tl_ihashmap_node link;
+}
+item;
+
+static int compare_item( const void* a, const void* b )
+{
+    return ((item*)a)->key != ((item*)b)->key;
+}
+
+static unsigned long hash_item( const void* obj )
+{
+    return ((unsigned long)((item*)obj)->key) / 10;
+}
+
+
+
+int main( void )
+{
+    item *items, dup, key, *it, *next;
+    tl_ihashmap map;
+    unsigned char* seen;
+    long i;
+
+    items = calloc( NUM_ITEMS, sizeof(item) );
+    seen = calloc( NUM_ITEMS, 1 );
+
+    if( !tl_ihashmap_init( &map, 16, offsetof(item, link),
+                           hash_item, compare_item ) )
+        return EXIT_FAILURE;
+
+    if( !tl_ihashmap_is_empty( &map ) || tl_ihashmap_get_next( &map, NULL ) )
+        return EXIT_FAILURE;
+
+    /* insert, the map grows along the way */
+    for( i=0; i<NUM_ITEMS; ++i )
+    {
+        items[i].key = i;
+        items[i].value = i * 3;
+
+        if( tl_ihashmap_insert( &map, items + i ) )
+            return EXIT_FAILURE;
+    }
+
+    if( map.count != NUM_ITEMS || map.bincount < NUM_ITEMS )
+        return EXIT_FAILURE;
+
+    /* keys are unique, the object is not linked */
+    dup.key = 42;
+    if( tl_ihashmap_insert( &map, &dup ) != items + 42 )
+        return EXIT_FAILURE;
+    if( map.count != NUM_ITEMS )
+        return EXIT_FAILURE;
+
+    /* lookup, no copies are made */
+    for( i=0; i<NUM_ITEMS; ++i )
+    {
+        key.key = i;
+        if( tl_ihashmap_find( &map, &key ) != items + i )
+            return EXIT_FAILURE;
+    }
+
+    key.key = NUM_ITEMS;
+    if( tl_ihashmap_find( &map, &key ) )
+        return EXIT_FAILURE;
+
+    /* remove every odd item, by key and by pointer */
+    for( i=1; i<NUM_ITEMS; i+=2 )
+    {
+        key.key = i;
+
+        if( tl_ihashmap_remove( &map, (i & 2) ? &key : items+i ) != items+i )
+            return EXIT_FAILURE;
+        if( tl_ihashmap_remove( &map, &key ) )
+            return EXIT_FAILURE;
+    }
+
+    if( map.count != NUM_ITEMS / 2 )
+        return EXIT_FAILURE;
+
+    /* iterate and remove, every object is visited once */
+    for( i=0, it=tl_ihashmap_get_next( &map, NULL ); it; it=next, ++i )
+    {
+        if( (it->key & 1) || seen[it->key] || it->value != it->key * 3 )
+            return EXIT_FAILURE;
+
+        seen[it->key] = 1;
+        next = tl_ihashmap_get_next( &map, it );
+
+        if( (it->key % 4) == 0 && tl_ihashmap_remove( &map, it ) != it )
+            return EXIT_FAILURE;
+    }
+
+    if( i != NUM_ITEMS / 2 || map.count != NUM_ITEMS / 4 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_ITEMS; ++i )
+    {
+        key.key = i;
+        it = tl_ihashmap_find( &map, &key );
+
+        if( (i % 4) == 2 ? (it != items + i) : (it != NULL) )
+            return EXIT_FAILURE;
+    }
+
+    tl_ihashmap_clear( &map );
+
+    if( !tl_ihashmap_is_empty( &map ) || tl_ihashmap_get_next( &map, NULL ) )
+        return EXIT_FAILURE;
+
+    tl_ihashmap_cleanup( &map );
+    free( items );
+    free( seen );
+    return EXIT_SUCCESS;
+}
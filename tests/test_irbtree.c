@@ -0,0 +1,188 @@
+#include "tl_irbtree.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+
+#define NUM_ITEMS 1000
+
+
+
+typedef struct
+{
+    int key;
+    tl_rbtree_node link;
+    int value;
+}
+item;
+
+static int compare_item( const void* a, const void* b )
+{
+    if( ((item*)a)->key < ((item*)b)->key ) return -1;
+    if( ((item*)a)->key > ((item*)b)->key ) return 1;
+    return 0;
+}
+
+static int get_key( tl_rbtree_node* n )
+{
+    return ((item*)((char*)n - offsetof(item, link)))->key;
+}
+
+static int is_bst( tl_rbtree_node* n, int min, int max )
+{
+    if( !n )
+        return 1;
+
+    if( get_key( n ) < min || get_key( n ) > max )
+        return 0;
+
+    return is_bst( n->left, min, get_key( n ) ) &&
+           is_bst( n->right, get_key( n ), max );
+}
+
+static int is_23( tl_irbtree* tree, tl_rbtree_node* n )
+{
+    if( !n )
+        return 1;
+    if( n->right && n->right->is_red )
+        return 0;
+    if( n!=tree->root && n->is_red && n->left && n->left->is_red )
+        return 0;
+    return is_23( tree, n->left ) && is_23( tree, n->right );
+}
+
+static int are_subtrees_balanced( tl_rbtree_node* n, int blackcount )
+{
+    if( !n )
+        return blackcount==0;
+
+    if( !n->is_red )
+        --blackcount;
+
+    return are_subtrees_balanced( n->left,  blackcount ) &&
+           are_subtrees_balanced( n->right, blackcount );
+}
+
+static int check_tree( tl_irbtree* tree )
+{
+    tl_rbtree_node* n;
+    int blackcount;
+
+    for( blackcount=0, n=tree->root; n; n=n->left )
+    {
+        if( !n->is_red )
+            ++blackcount;
+    }
+
+    return is_bst( tree->root, -1, NUM_ITEMS ) &&
+           is_23( tree, tree->root ) &&
+           are_subtrees_balanced( tree->root, blackcount );
+}
+
+int main( void )
+{
+    item items[ NUM_ITEMS ], dup, key, *it;
+    tl_irbtree tree;
+    int i, j;
+
+    tl_irbtree_init( &tree, offsetof(item, link), compare_item );
+
+    if( !tl_irbtree_is_empty( &tree ) || tl_irbtree_get_min( &tree ) )
+        return EXIT_FAILURE;
+
+    /* insert in a scrambled order */
+    for( i=0; i<NUM_ITEMS; ++i )
+    {
+        j = (i * 7) % NUM_ITEMS;
+        items[j].key = j;
+        items[j].value = j * 10;
+
+        if( tl_irbtree_insert( &tree, items + j ) )
+            return EXIT_FAILURE;
+        if( tree.size != (size_t)i + 1 || !check_tree( &tree ) )
+            return EXIT_FAILURE;
+    }
+
+    /* keys are unique, the object is not linked */
+    dup.key = 5;
+    if( tl_irbtree_insert( &tree, &dup ) != items + 5 )
+        return EXIT_FAILURE;
+    if( tree.size != NUM_ITEMS )
+        return EXIT_FAILURE;
+
+    /* lookup, no copies are made */
+    for( i=0; i<NUM_ITEMS; ++i )
+    {
+        key.key = i;
+        if( tl_irbtree_find( &tree, &key ) != items + i )
+            return EXIT_FAILURE;
+    }
+
+    key.key = NUM_ITEMS;
+    if( tl_irbtree_find( &tree, &key ) )
+        return EXIT_FAILURE;
+
+    if( tl_irbtree_get_min( &tree ) != items ||
+        tl_irbtree_get_max( &tree ) != items + NUM_ITEMS - 1 )
+        return EXIT_FAILURE;
+
+    /* in order iteration */
+    for( i=0, it=tl_irbtree_get_next( &tree, NULL ); it;
+         it=tl_irbtree_get_next( &tree, it ), ++i )
+    {
+        if( it != items + i )
+            return EXIT_FAILURE;
+    }
+
+    if( i != NUM_ITEMS )
+        return EXIT_FAILURE;
+
+    /* remove every odd item, by key and by pointer */
+    for( i=1; i<NUM_ITEMS; i+=2 )
+    {
+        key.key = i;
+
+        if( tl_irbtree_remove( &tree, (i & 2) ? &key : items+i ) != items+i )
+            return EXIT_FAILURE;
+        if( tl_irbtree_remove( &tree, &key ) )
+            return EXIT_FAILURE;
+        if( !check_tree( &tree ) )
+            return EXIT_FAILURE;
+    }
+
+    if( tree.size != NUM_ITEMS / 2 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_ITEMS; ++i )
+    {
+        key.key = i;
+        it = tl_irbtree_find( &tree, &key );
+
+        if( (i & 1) ? (it != NULL) : (it != items + i || it->value != i*10) )
+            return EXIT_FAILURE;
+    }
+
+    /* remove the rest while iterating */
+    for( it=tl_irbtree_get_min( &tree ); it;
+         it=tl_irbtree_get_next( &tree, it ) )
+    {
+        if( tl_irbtree_remove( &tree, it ) != it || !check_tree( &tree ) )
+            return EXIT_FAILURE;
+    }
+
+    if( !tl_irbtree_is_empty( &tree ) || tree.root )
+        return EXIT_FAILURE;
+
+    /* removed items can be linked again */
+    for( i=0; i<NUM_ITEMS; ++i )
+        tl_irbtree_insert( &tree, items + i );
+
+    if( tree.size != NUM_ITEMS || !check_tree( &tree ) )
+        return EXIT_FAILURE;
+
+    tl_irbtree_clear( &tree );
+
+    if( !tl_irbtree_is_empty( &tree ) )
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+#include "tl_allocator.h"
+#include "tl_lrucache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+
+static int cleanups = 0;
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    return *((unsigned long*)obj);
+}
+
+static int copy_inplace( tl_allocator* alc, void* dst, const void* src )
+{
+    (void)alc;
+    memcpy( dst, src, sizeof(long) );
+    return 1;
+}
+
+static int init( tl_allocator* alc, void* ptr )
+{
+    (void)alc;
+    memset( ptr, 0, sizeof(long) );
+    return 1;
+}
+
+static void cleanup( tl_allocator* alc, void* ptr )
+{
+    (void)alc; (void)ptr;
+    ++cleanups;
+}
+
+
+
+int main( void )
+{
+    tl_allocator alloc;
+    tl_lrucache cache;
+    long i, l;
+
+    alloc.copy_inplace = copy_inplace;
+    alloc.init = init;
+    alloc.cleanup = cleanup;
+
+    /* count based capacity */
+    if( !tl_lrucache_init( &cache, sizeof(long), sizeof(long), 100,
+                           hash, compare, NULL, &alloc ) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<100; ++i )
+    {
+        l = i * 3;
+        if( !tl_lrucache_put( &cache, &i, &l, 1 ) )
+            return EXIT_FAILURE;
+    }
+
+    if( tl_lrucache_count( &cache ) != 100 || cleanups != 0 )
+        return EXIT_FAILURE;
+
+    /* touch the even keys, the odd ones are evicted first */
+    for( i=0; i<100; i+=2 )
+    {
+        if( *((long*)tl_lrucache_get( &cache, &i )) != i * 3 )
+            return EXIT_FAILURE;
+    }
+
+    for( i=100; i<150; ++i )
+    {
+        l = i * 3;
+        if( !tl_lrucache_put( &cache, &i, &l, 1 ) )
+            return EXIT_FAILURE;
+    }
+
+    if( tl_lrucache_count( &cache ) != 100 || cache.used != 100 )
+        return EXIT_FAILURE;
+    if( cleanups != 50 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<150; ++i )
+    {
+        if( i < 100 && (i & 1) )
+        {
+            if( tl_lrucache_get( &cache, &i ) )
+                return EXIT_FAILURE;
+        }
+        else if( *((long*)tl_lrucache_get( &cache, &i )) != i * 3 )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* overwriting updates the value and the order */
+    i = 0;
+    l = 42;
+    if( !tl_lrucache_put( &cache, &i, &l, 1 ) || cleanups != 51 )
+        return EXIT_FAILURE;
+    if( tl_lrucache_count( &cache ) != 100 )
+        return EXIT_FAILURE;
+
+    i = 2;
+    if( !tl_lrucache_evict( &cache ) || tl_lrucache_get( &cache, &i ) )
+        return EXIT_FAILURE;
+    if( cleanups != 52 || tl_lrucache_count( &cache ) != 99 )
+        return EXIT_FAILURE;
+
+    /* remove */
+    i = 0;
+    if( !tl_lrucache_remove( &cache, &i, &l ) || l != 42 )
+        return EXIT_FAILURE;
+    if( tl_lrucache_remove( &cache, &i, NULL ) || cleanups != 52 )
+        return EXIT_FAILURE;
+
+    i = 4;
+    if( !tl_lrucache_remove( &cache, &i, NULL ) || cleanups != 53 )
+        return EXIT_FAILURE;
+
+    if( tl_lrucache_count( &cache ) != 97 || cache.used != 97 )
+        return EXIT_FAILURE;
+
+    tl_lrucache_clear( &cache );
+
+    if( tl_lrucache_count( &cache ) || cache.used || cleanups != 150 )
+        return EXIT_FAILURE;
+    if( tl_lrucache_evict( &cache ) )
+        return EXIT_FAILURE;
+
+    tl_lrucache_cleanup( &cache );
+
+    /* cost based capacity */
+    cleanups = 0;
+    tl_lrucache_init( &cache, sizeof(long), sizeof(long), 1000,
+                      hash, compare, NULL, &alloc );
+
+    for( i=0; i<10; ++i )
+    {
+        l = i;
+        tl_lrucache_put( &cache, &i, &l, 100 );
+    }
+
+    i = 10;
+    tl_lrucache_put( &cache, &i, &l, 250 );
+
+    if( tl_lrucache_count( &cache ) != 8 || cache.used != 950 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<3; ++i )
+    {
+        if( tl_lrucache_get( &cache, &i ) )
+            return EXIT_FAILURE;
+    }
+
+    /* a single entry larger than the capacity is kept */
+    i = 11;
+    tl_lrucache_put( &cache, &i, &l, 5000 );
+
+    if( tl_lrucache_count( &cache ) != 1 || !tl_lrucache_get( &cache, &i ) )
+        return EXIT_FAILURE;
+
+    tl_lrucache_cleanup( &cache );
+
+    if( cleanups != 12 )
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
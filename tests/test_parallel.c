@@ -0,0 +1,117 @@
+#include "tl_threadpool.h"
+#include "tl_parallel.h"
+#include "tl_iterator.h"
+#include "tl_hashmap.h"
+#include "tl_array.h"
+
+#include <stdlib.h>
+
+#define NUM_WORKERS 4
+#define NUM_PAIRS 1000000
+
+
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    return *((unsigned long*)obj);
+}
+
+
+
+int main( void )
+{
+    tl_hashmap map, ref;
+    tl_threadpool* pool;
+    tl_array keys, vals;
+    tl_iterator* it;
+    long i, k, l;
+
+    tl_array_init( &keys, sizeof(long), NULL );
+    tl_array_init( &vals, sizeof(long), NULL );
+
+    /* every 1000th key occurs twice, the last occurrence must win */
+    for( i=0; i<NUM_PAIRS; ++i )
+    {
+        k = (i * 7919) % NUM_PAIRS;
+        l = i;
+        tl_array_append( &keys, &k );
+        tl_array_append( &vals, &l );
+
+        if( (i % 1000) == 0 )
+        {
+            l = -i - 1;
+            tl_array_append( &keys, &k );
+            tl_array_append( &vals, &l );
+        }
+    }
+
+    pool = tl_threadpool_create( NUM_WORKERS, NULL, NULL, NULL, NULL );
+
+    /* sequential reference */
+    tl_hashmap_init(&ref,sizeof(long),sizeof(long),64,hash,compare,NULL,NULL);
+    tl_hashmap_set_max_load( &ref, 100 );
+
+    for( i=0; i<(long)keys.used; ++i )
+    {
+        tl_hashmap_insert( &ref, tl_array_at( &keys, i ),
+                           tl_array_at( &vals, i ) );
+    }
+
+    /* parallel bulk build */
+    tl_hashmap_init(&map,sizeof(long),sizeof(long),64,hash,compare,NULL,NULL);
+    tl_hashmap_set_max_load( &map, 100 );
+
+    if( !tl_hashmap_from_arrays( &map, &keys, &vals, pool ) )
+        return EXIT_FAILURE;
+
+    if( map.count != keys.used || map.count != ref.count )
+        return EXIT_FAILURE;
+    if( map.bincount < keys.used || map.old_bins )
+        return EXIT_FAILURE;
+
+    for( k=0; k<NUM_PAIRS; ++k )
+    {
+        if( *((long*)tl_hashmap_at( &map, &k )) !=
+            *((long*)tl_hashmap_at( &ref, &k )) )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* building into a non-empty map fails */
+    if( tl_hashmap_from_arrays( &map, &keys, &vals, pool ) )
+        return EXIT_FAILURE;
+
+    /* the map must behave normally afterwards */
+    for( i=0; i<NUM_PAIRS; i+=1000 )
+    {
+        k = (i * 7919) % NUM_PAIRS;
+        if( !tl_hashmap_remove( &map, &k, &l ) || l != -i - 1 )
+            return EXIT_FAILURE;
+        if( *((long*)tl_hashmap_at( &map, &k )) != i )
+            return EXIT_FAILURE;
+    }
+
+    for( k=NUM_PAIRS; k<NUM_PAIRS+1000; ++k )
+        tl_hashmap_insert( &map, &k, &k );
+
+    it = tl_hashmap_get_iterator( &map );
+    for( i=0; it->has_data( it ); ++i )
+        it->remove( it );
+    it->destroy( it );
+
+    if( i != NUM_PAIRS + 1000 || !tl_hashmap_is_empty( &map ) )
+        return EXIT_FAILURE;
+
+    tl_threadpool_destroy( pool );
+    tl_hashmap_cleanup( &map );
+    tl_hashmap_cleanup( &ref );
+    tl_array_cleanup( &keys );
+    tl_array_cleanup( &vals );
+    return EXIT_SUCCESS;
+}
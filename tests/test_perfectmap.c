@@ -0,0 +1,163 @@
+#include "tl_perfectmap.h"
+#include "tl_array.h"
+#include "tl_blob.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_KEYS 100000
+
+
+
+typedef struct
+{
+    char name[12];
+}
+keyword;
+
+static const char* keywords[] =
+{
+    "if", "else", "while", "for", "do", "switch", "case", "default",
+    "break", "continue", "return", "goto", "struct", "union", "enum",
+    "typedef", "static", "extern", "const", "volatile", "sizeof"
+};
+
+#define NUM_KEYWORDS (sizeof(keywords) / sizeof(keywords[0]))
+
+int main( void )
+{
+    tl_array keys, values;
+    tl_perfectmap map, copy;
+    unsigned char *used;
+    keyword kw;
+    tl_blob blob;
+    long i, l;
+
+    /* small table with string keys */
+    tl_array_init( &keys, sizeof(keyword), NULL );
+    tl_array_init( &values, sizeof(long), NULL );
+
+    for( i=0; i<(long)NUM_KEYWORDS; ++i )
+    {
+        memset( &kw, 0, sizeof(kw) );
+        strcpy( kw.name, keywords[i] );
+        tl_array_append( &keys, &kw );
+        tl_array_append( &values, &i );
+    }
+
+    if( !tl_perfectmap_init( &map, &keys, &values ) )
+        return EXIT_FAILURE;
+
+    if( map.count != NUM_KEYWORDS || map.keysize != sizeof(keyword) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<(long)NUM_KEYWORDS; ++i )
+    {
+        memset( &kw, 0, sizeof(kw) );
+        strcpy( kw.name, keywords[i] );
+
+        if( *((long*)tl_perfectmap_at( &map, &kw )) != i )
+            return EXIT_FAILURE;
+    }
+
+    memset( &kw, 0, sizeof(kw) );
+    strcpy( kw.name, "register" );
+    if( tl_perfectmap_at( &map, &kw ) )
+        return EXIT_FAILURE;
+
+    tl_perfectmap_cleanup( &map );
+
+    /* duplicate keys are rejected */
+    memcpy( &kw, tl_array_at( &keys, 3 ), sizeof(kw) );
+    tl_array_append( &keys, &kw );
+    tl_array_append( &values, &i );
+
+    if( tl_perfectmap_init( &map, &keys, &values ) )
+        return EXIT_FAILURE;
+
+    tl_array_cleanup( &keys );
+    tl_array_cleanup( &values );
+
+    /* empty map */
+    tl_array_init( &keys, sizeof(long), NULL );
+    tl_array_init( &values, sizeof(long), NULL );
+
+    if( !tl_perfectmap_init( &map, &keys, &values ) )
+        return EXIT_FAILURE;
+    if( map.count || tl_perfectmap_at( &map, &i ) )
+        return EXIT_FAILURE;
+    tl_perfectmap_cleanup( &map );
+
+    /* large table */
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        l = i * 7919;
+        tl_array_append( &keys, &l );
+        l = -i;
+        tl_array_append( &values, &l );
+    }
+
+    if( !tl_perfectmap_init( &map, &keys, &values ) )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        l = i * 7919;
+        if( *((long*)tl_perfectmap_at( &map, &l )) != -i )
+            return EXIT_FAILURE;
+
+        l += 1;
+        if( tl_perfectmap_at( &map, &l ) )
+            return EXIT_FAILURE;
+    }
+
+    /* every key occupies exactly one slot */
+    used = calloc( NUM_KEYS, 1 );
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        l = *((long*)tl_perfectmap_key_at( &map, i ));
+        if( (l % 7919) || used[l / 7919] )
+            return EXIT_FAILURE;
+        used[l / 7919] = 1;
+    }
+
+    free( used );
+
+    if( tl_perfectmap_key_at( &map, NUM_KEYS ) )
+        return EXIT_FAILURE;
+
+    /* serialize and restore */
+    if( !tl_perfectmap_serialize( &map, &blob ) )
+        return EXIT_FAILURE;
+
+    if( !tl_perfectmap_deserialize( &copy, &blob ) )
+        return EXIT_FAILURE;
+
+    if( copy.count != map.count || copy.seed != map.seed )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        l = i * 7919;
+        if( *((long*)tl_perfectmap_at( &copy, &l )) != -i )
+            return EXIT_FAILURE;
+    }
+
+    tl_perfectmap_cleanup( &copy );
+
+    blob.size -= 1;
+    if( tl_perfectmap_deserialize( &copy, &blob ) )
+        return EXIT_FAILURE;
+    blob.size += 1;
+
+    ((unsigned char*)blob.data)[0] = 'X';
+    if( tl_perfectmap_deserialize( &copy, &blob ) )
+        return EXIT_FAILURE;
+
+    tl_blob_cleanup( &blob );
+    tl_perfectmap_cleanup( &map );
+    tl_array_cleanup( &keys );
+    tl_array_cleanup( &values );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+#include "tl_hashmap.h"
+#include "tl_rcumap.h"
+#include "tl_thread.h"
+
+#include <stdlib.h>
+
+#define NUM_READERS 4
+#define NUM_KEYS 100
+#define NUM_UPDATES 500
+
+
+
+typedef struct
+{
+    tl_rcumap* map;
+    volatile int* done;
+    int failed;
+}
+reader_data;
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    return *((unsigned long*)obj);
+}
+
+/* every version maps all keys to the same generation number */
+static long check_version( const tl_hashmap* map )
+{
+    long i, *val, gen = -1;
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        val = tl_hashmap_at( map, &i );
+
+        if( !val || (gen >= 0 && *val != gen) )
+            return -1;
+
+        gen = *val;
+    }
+    return gen;
+}
+
+static void* reader_thread( void* arg )
+{
+    reader_data* data = arg;
+    tl_rcumap_reader* reader;
+    long gen, last = 0;
+
+    reader = tl_rcumap_reader_create( data->map );
+    if( !reader )
+    {
+        data->failed = 1;
+        return NULL;
+    }
+
+    while( !(*data->done) )
+    {
+        gen = check_version( tl_rcumap_read_begin( reader ) );
+        tl_rcumap_read_end( reader );
+
+        /* a reader never sees an older version than before */
+        if( gen < last )
+        {
+            data->failed = 1;
+            break;
+        }
+        last = gen;
+    }
+
+    tl_rcumap_reader_destroy( reader );
+    return NULL;
+}
+
+static int update( tl_rcumap* map, long gen, int commit )
+{
+    tl_hashmap* next;
+    long i;
+
+    next = tl_rcumap_update_begin( map );
+    if( !next )
+        return 0;
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        if( tl_hashmap_at( next, &i ) )
+            *((long*)tl_hashmap_at( next, &i )) = gen;
+        else if( !tl_hashmap_insert( next, &i, &gen ) )
+            return 0;
+    }
+
+    if( commit )
+    {
+        tl_rcumap_update_commit( map );
+    }
+    else
+    {
+        tl_rcumap_update_abort( map );
+    }
+    return 1;
+}
+
+
+
+int main( void )
+{
+    reader_data data[ NUM_READERS ];
+    tl_thread* threads[ NUM_READERS ];
+    const tl_hashmap* snapshot;
+    tl_rcumap_reader* reader;
+    volatile int done = 0;
+    tl_rcumap* map;
+    long i;
+
+    map = tl_rcumap_create( sizeof(long), sizeof(long), 16,
+                            hash, compare, NULL, NULL );
+    if( !map )
+        return EXIT_FAILURE;
+
+    if( !update( map, 0, 1 ) )
+        return EXIT_FAILURE;
+
+    /* a version stays alive while a reader uses it */
+    reader = tl_rcumap_reader_create( map );
+    if( !reader )
+        return EXIT_FAILURE;
+
+    snapshot = tl_rcumap_read_begin( reader );
+
+    if( !update( map, 1, 1 ) || !update( map, 2, 1 ) || !update( map, 3, 0 ) )
+        return EXIT_FAILURE;
+
+    if( tl_rcumap_reclaim( map ) != 2 || check_version( snapshot ) != 0 )
+        return EXIT_FAILURE;
+
+    tl_rcumap_read_end( reader );
+
+    if( tl_rcumap_reclaim( map ) != 0 )
+        return EXIT_FAILURE;
+
+    snapshot = tl_rcumap_read_begin( reader );
+    i = check_version( snapshot );
+    tl_rcumap_read_end( reader );
+
+    if( i != 2 )
+        return EXIT_FAILURE;
+
+    tl_rcumap_reader_destroy( reader );
+
+    /* concurrent readers while a writer keeps publishing new versions */
+    for( i=0; i<NUM_READERS; ++i )
+    {
+        data[i].map = map;
+        data[i].done = &done;
+        data[i].failed = 0;
+
+        threads[i] = tl_thread_create( reader_thread, data + i );
+        if( !threads[i] )
+            return EXIT_FAILURE;
+    }
+
+    for( i=3; i<NUM_UPDATES; ++i )
+    {
+        if( !update( map, i, (i % 10) != 0 ) )
+            return EXIT_FAILURE;
+    }
+
+    done = 1;
+
+    for( i=0; i<NUM_READERS; ++i )
+    {
+        tl_thread_join( threads[i], 0 );
+        tl_thread_destroy( threads[i] );
+
+        if( data[i].failed )
+            return EXIT_FAILURE;
+    }
+
+    if( tl_rcumap_reclaim( map ) != 0 )
+        return EXIT_FAILURE;
+
+    tl_rcumap_destroy( map );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+#include "tl_searchindex.h"
+#include "tl_array.h"
+
+#include <stdlib.h>
+
+
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+/* compare the index against a linear scan of the array */
+static int check( const tl_array* arr, long maxkey )
+{
+    size_t lower, upper;
+    tl_searchindex idx;
+    long key, *ptr;
+
+    if( !tl_searchindex_init( &idx, arr, compare ) )
+        return 0;
+
+    for( key=-2; key<=maxkey+2; ++key )
+    {
+        for( lower=0; lower<arr->used; ++lower )
+        {
+            if( *((long*)tl_array_at( arr, lower )) >= key )
+                break;
+        }
+
+        for( upper=lower; upper<arr->used; ++upper )
+        {
+            if( *((long*)tl_array_at( arr, upper )) > key )
+                break;
+        }
+
+        if( tl_searchindex_lower_bound( &idx, &key ) != lower )
+            return 0;
+        if( tl_searchindex_upper_bound( &idx, &key ) != upper )
+            return 0;
+
+        ptr = tl_searchindex_find( &idx, &key );
+
+        if( lower == upper ? (ptr != NULL) :
+                             (ptr != tl_array_at( arr, lower )) )
+            return 0;
+    }
+
+    tl_searchindex_cleanup( &idx );
+    return 1;
+}
+
+static tl_u64 get( const tl_array* arr, size_t i )
+{
+    if( arr->unitsize == sizeof(tl_u32) )
+        return *((tl_u32*)tl_array_at( arr, i ));
+    return *((tl_u64*)tl_array_at( arr, i ));
+}
+
+/* same as above, with the inline integer comparison of 32 or 64 bit */
+static int check_int( const tl_array* src, size_t unitsize, tl_u64 offset )
+{
+    size_t i, lower, upper;
+    tl_searchindex idx;
+    tl_u64 key, value;
+    tl_array arr;
+    tl_u32 key32;
+    void* ptr;
+    int ret = 0;
+
+    tl_array_init( &arr, unitsize, NULL );
+
+    for( i=0; i<src->used; ++i )
+    {
+        value = *((long*)tl_array_at( src, i )) + offset;
+        key32 = value;
+        tl_array_append( &arr, unitsize == sizeof(tl_u32) ?
+                               (void*)&key32 : (void*)&value );
+    }
+
+    if( !tl_searchindex_init( &idx, &arr, NULL ) )
+        goto out;
+
+    for( key=offset; key<=(arr.used ? get( &arr, arr.used-1 ) : offset)+2;
+         ++key )
+    {
+        for( lower=0; lower<arr.used && get( &arr, lower ) < key; ++lower )
+            ;
+        for( upper=lower; upper<arr.used && get( &arr, upper )<=key; ++upper )
+            ;
+
+        key32 = key;
+        ptr = unitsize == sizeof(tl_u32) ? (void*)&key32 : (void*)&key;
+
+        if( tl_searchindex_lower_bound( &idx, ptr ) != lower )
+            goto out_idx;
+        if( tl_searchindex_upper_bound( &idx, ptr ) != upper )
+            goto out_idx;
+
+        ptr = tl_searchindex_find( &idx, ptr );
+
+        if( lower == upper ? (ptr != NULL) :
+                             (ptr != tl_array_at( &arr, lower )) )
+            goto out_idx;
+    }
+
+    ret = 1;
+out_idx:
+    tl_searchindex_cleanup( &idx );
+out:
+    tl_array_cleanup( &arr );
+    return ret;
+}
+
+
+
+int main( void )
+{
+    tl_array arr;
+    long i, j;
+
+    tl_array_init( &arr, sizeof(long), NULL );
+
+    /* every tree shape up to a few levels, with and without duplicates */
+    for( i=0; i<70; ++i )
+    {
+        if( !check( &arr, 2 * i ) )
+            return EXIT_FAILURE;
+        if( !check_int( &arr, sizeof(tl_u32), 0 ) )
+            return EXIT_FAILURE;
+        if( !check_int( &arr, sizeof(tl_u64), 0 ) )
+            return EXIT_FAILURE;
+
+        j = 2 * i + (i % 3 == 0);
+        tl_array_append( &arr, &j );
+    }
+
+    tl_array_clear( &arr );
+
+    for( i=0; i<5000; ++i )
+    {
+        j = i / 7 * 3;
+        tl_array_append( &arr, &j );
+    }
+
+    if( !check( &arr, j ) )
+        return EXIT_FAILURE;
+
+    /* as 32 bit values, and as 64 bit values above 2^32 */
+    if( !check_int( &arr, sizeof(tl_u32), 0 ) )
+        return EXIT_FAILURE;
+    if( !check_int( &arr, sizeof(tl_u64), (tl_u64)3 << 32 ) )
+        return EXIT_FAILURE;
+
+    tl_array_cleanup( &arr );
+    return EXIT_SUCCESS;
+}
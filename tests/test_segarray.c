@@ -0,0 +1,109 @@
+#include "tl_segarray.h"
+
+#include <stdlib.h>
+
+
+
+int main( void )
+{
+    long i, vals[1000], *ptrs[1000], *ptr;
+    size_t idx, run;
+    tl_segarray arr;
+
+    for( i=0; i<1000; ++i )
+        vals[i] = i * 7;
+
+    tl_segarray_init( &arr, sizeof(long), 10, NULL );
+
+    if( arr.shift != 4 || !tl_segarray_is_empty( &arr ) ||
+        tl_segarray_at( &arr, 0 ) || tl_segarray_get_last( &arr ) )
+        return EXIT_FAILURE;
+
+    /* elements never move while the array grows */
+    for( i=0; i<1000; ++i )
+    {
+        if( !tl_segarray_append( &arr, vals + i ) )
+            return EXIT_FAILURE;
+
+        ptrs[i] = tl_segarray_get_last( &arr );
+    }
+
+    if( tl_segarray_get_size( &arr ) != 1000 || arr.chunkcount != 63 )
+        return EXIT_FAILURE;
+
+    for( i=0; i<1000; ++i )
+    {
+        if( tl_segarray_at( &arr, i ) != ptrs[i] || *ptrs[i] != i * 7 )
+            return EXIT_FAILURE;
+    }
+
+    if( tl_segarray_at( &arr, 1000 ) )
+        return EXIT_FAILURE;
+
+    /* bulk append across chunk boundaries */
+    tl_segarray_remove_last( &arr, 505 );
+
+    if( arr.used != 495 || tl_segarray_get_last( &arr ) != ptrs[494] )
+        return EXIT_FAILURE;
+
+    if( !tl_segarray_append_array( &arr, vals, 1000 ) || arr.used != 1495 )
+        return EXIT_FAILURE;
+
+    if( tl_segarray_at( &arr, 0 ) != ptrs[0] )
+        return EXIT_FAILURE;
+
+    /* scan chunk wise */
+    for( idx=0; idx<arr.used; idx+=run )
+    {
+        ptr = tl_segarray_get_segment( &arr, idx, &run );
+
+        if( !ptr || !run || run > 16 )
+            return EXIT_FAILURE;
+
+        for( i=0; i<(long)run; ++i )
+        {
+            if( idx + i < 495 )
+            {
+                if( ptr[i] != (long)(idx + i) * 7 )
+                    return EXIT_FAILURE;
+            }
+            else if( ptr[i] != (long)(idx + i - 495) * 7 )
+            {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if( idx != 1495 || tl_segarray_get_segment( &arr, idx, &run ) || run )
+        return EXIT_FAILURE;
+
+    /* clearing keeps the chunks around */
+    tl_segarray_clear( &arr );
+
+    if( !tl_segarray_is_empty( &arr ) || arr.chunkcount != 94 )
+        return EXIT_FAILURE;
+
+    if( !tl_segarray_reserve( &arr, 2000 ) || arr.chunkcount != 125 )
+        return EXIT_FAILURE;
+
+    tl_segarray_append( &arr, vals + 1 );
+
+    if( tl_segarray_get_last( &arr ) != ptrs[0] || *ptrs[0] != 7 )
+        return EXIT_FAILURE;
+
+    tl_segarray_cleanup( &arr );
+
+    /* default chunk size */
+    tl_segarray_init( &arr, 3000, 0, NULL );
+
+    if( arr.shift != 0 )
+        return EXIT_FAILURE;
+
+    tl_segarray_init( &arr, sizeof(long), 0, NULL );
+
+    if( ((size_t)1 << arr.shift) * sizeof(long) != 4096 )
+        return EXIT_FAILURE;
+
+    tl_segarray_cleanup( &arr );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "tl_threadpool.h"
+#include "tl_sharedcache.h"
+
+#include <stdlib.h>
+
+#define NUM_WORKERS 4
+#define KEYS_PER_TASK 20000
+#define CAPACITY 4096
+
+
+
+typedef struct
+{
+    tl_sharedcache* cache;
+    long first;
+    long count;
+    int failed;
+}
+task_data;
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    return *((unsigned long*)obj);
+}
+
+static void fill_task( void* arg )
+{
+    task_data* task = arg;
+    long i, l;
+
+    for( i=task->first; i<task->first+task->count; ++i )
+    {
+        l = i * 3;
+        if( !tl_sharedcache_put( task->cache, &i, &l, 1 ) )
+            task->failed = 1;
+
+        /* other threads may have evicted it already */
+        if( tl_sharedcache_get( task->cache, &i, &l ) && l != i * 3 )
+            task->failed = 1;
+    }
+}
+
+
+
+int main( void )
+{
+    task_data tasks[ NUM_WORKERS ];
+    tl_sharedcache* cache;
+    tl_threadpool* pool;
+    size_t count;
+    unsigned int i;
+    long k, l;
+
+    cache = tl_sharedcache_create( sizeof(long), sizeof(long), CAPACITY, 0,
+                                   hash, compare, NULL, NULL );
+    if( !cache )
+        return EXIT_FAILURE;
+
+    /* concurrent inserts and lookups on disjoint key ranges */
+    pool = tl_threadpool_create( NUM_WORKERS, NULL, NULL, NULL, NULL );
+
+    for( i=0; i<NUM_WORKERS; ++i )
+    {
+        tasks[i].cache = cache;
+        tasks[i].first = (long)i * KEYS_PER_TASK;
+        tasks[i].count = KEYS_PER_TASK;
+        tasks[i].failed = 0;
+        tl_threadpool_add_task( pool, fill_task, tasks + i, 0, NULL );
+    }
+
+    tl_threadpool_wait( pool, 0 );
+    tl_threadpool_destroy( pool );
+
+    for( i=0; i<NUM_WORKERS; ++i )
+    {
+        if( tasks[i].failed )
+            return EXIT_FAILURE;
+    }
+
+    /* every shard is at its capacity, the surviving values are intact */
+    count = tl_sharedcache_count( cache );
+
+    if( count > CAPACITY || count < CAPACITY / 2 )
+        return EXIT_FAILURE;
+
+    for( count=0, k=0; k<NUM_WORKERS * KEYS_PER_TASK; ++k )
+    {
+        if( tl_sharedcache_get( cache, &k, &l ) )
+        {
+            if( l != k * 3 )
+                return EXIT_FAILURE;
+            ++count;
+        }
+    }
+
+    if( count != tl_sharedcache_count( cache ) )
+        return EXIT_FAILURE;
+
+    /* remove and clear */
+    k = -1;
+    l = 42;
+    if( !tl_sharedcache_put( cache, &k, &l, 1 ) )
+        return EXIT_FAILURE;
+    if( !tl_sharedcache_remove( cache, &k, &l ) || l != 42 )
+        return EXIT_FAILURE;
+    if( tl_sharedcache_get( cache, &k, NULL ) )
+        return EXIT_FAILURE;
+
+    tl_sharedcache_clear( cache );
+
+    if( tl_sharedcache_count( cache ) != 0 )
+        return EXIT_FAILURE;
+
+    tl_sharedcache_destroy( cache );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+#include "tl_threadpool.h"
+#include "tl_sharedmap.h"
+
+#include <stdlib.h>
+
+#define NUM_WORKERS 4
+#define KEYS_PER_TASK 20000
+#define MIXED_KEYS 100000
+#define MIXED_OPS 400000
+
+
+
+typedef struct
+{
+    tl_sharedmap* map;
+    long first;
+    long count;
+    unsigned long seed;
+    int failed;
+}
+task_data;
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    return *((unsigned long*)obj);
+}
+
+static void fill_task( void* arg )
+{
+    task_data* task = arg;
+    long i, l;
+
+    for( i=task->first; i<task->first+task->count; ++i )
+    {
+        l = i * 3;
+        if( !tl_sharedmap_insert( task->map, &i, &l ) )
+            task->failed = 1;
+        if( !tl_sharedmap_get( task->map, &i, &l ) || l != i * 3 )
+            task->failed = 1;
+    }
+
+    /* remove every other key again */
+    for( i=task->first; i<task->first+task->count; i+=2 )
+    {
+        if( !tl_sharedmap_remove( task->map, &i, &l ) || l != i * 3 )
+            task->failed = 1;
+        if( tl_sharedmap_get( task->map, &i, NULL ) )
+            task->failed = 1;
+    }
+}
+
+/* mixed work load: 7 out of 8 operations are lookups */
+static void mixed_task( void* arg )
+{
+    task_data* task = arg;
+    long i, key, l;
+
+    for( i=0; i<task->count; ++i )
+    {
+        task->seed = task->seed * 1103515245UL + 12345UL;
+        key = (long)((task->seed >> 8) % MIXED_KEYS);
+
+        if( (i & 7) == 0 )
+        {
+            l = key;
+            tl_sharedmap_insert( task->map, &key, &l );
+        }
+        else if( !tl_sharedmap_get( task->map, &key, &l ) || l != key )
+        {
+            task->failed = 1;
+        }
+    }
+}
+
+
+
+int main( void )
+{
+    task_data tasks[ NUM_WORKERS ];
+    tl_threadpool* pool;
+    tl_sharedmap* map;
+    unsigned int i;
+    long k, l;
+
+    map = tl_sharedmap_create( sizeof(long), sizeof(long), 0,
+                               hash, compare, NULL, NULL );
+    if( !map )
+        return EXIT_FAILURE;
+
+    /* concurrent inserts, lookups and removals on disjoint key ranges */
+    pool = tl_threadpool_create( NUM_WORKERS, NULL, NULL, NULL, NULL );
+
+    for( i=0; i<NUM_WORKERS; ++i )
+    {
+        tasks[i].map = map;
+        tasks[i].first = (long)i * KEYS_PER_TASK;
+        tasks[i].count = KEYS_PER_TASK;
+        tasks[i].failed = 0;
+        tl_threadpool_add_task( pool, fill_task, tasks + i, 0, NULL );
+    }
+
+    tl_threadpool_wait( pool, 0 );
+    tl_threadpool_destroy( pool );
+
+    for( i=0; i<NUM_WORKERS; ++i )
+    {
+        if( tasks[i].failed )
+            return EXIT_FAILURE;
+    }
+
+    if( tl_sharedmap_count( map ) != NUM_WORKERS * KEYS_PER_TASK / 2 )
+        return EXIT_FAILURE;
+
+    for( k=0; k<NUM_WORKERS * KEYS_PER_TASK; ++k )
+    {
+        if( (k & 1) != tl_sharedmap_get( map, &k, &l ) )
+            return EXIT_FAILURE;
+        if( (k & 1) && l != k * 3 )
+            return EXIT_FAILURE;
+    }
+
+    /* inserting an existing key overwrites it */
+    k = 1;
+    l = 42;
+    if( !tl_sharedmap_insert( map, &k, &l ) || !tl_sharedmap_get(map,&k,&l) )
+        return EXIT_FAILURE;
+    if( l != 42 || tl_sharedmap_count( map ) != NUM_WORKERS*KEYS_PER_TASK/2 )
+        return EXIT_FAILURE;
+
+    tl_sharedmap_clear( map );
+
+    if( tl_sharedmap_count( map ) != 0 || tl_sharedmap_get( map, &k, NULL ) )
+        return EXIT_FAILURE;
+
+    /* concurrent lookups of overlapping keys mixed with overwrites */
+    for( k=0; k<MIXED_KEYS; ++k )
+        tl_sharedmap_insert( map, &k, &k );
+
+    pool = tl_threadpool_create( NUM_WORKERS, NULL, NULL, NULL, NULL );
+
+    for( i=0; i<NUM_WORKERS; ++i )
+    {
+        tasks[i].map = map;
+        tasks[i].count = MIXED_OPS / NUM_WORKERS;
+        tasks[i].seed = i;
+        tasks[i].failed = 0;
+        tl_threadpool_add_task( pool, mixed_task, tasks + i, 0, NULL );
+    }
+
+    tl_threadpool_wait( pool, 0 );
+    tl_threadpool_destroy( pool );
+
+    for( i=0; i<NUM_WORKERS; ++i )
+    {
+        if( tasks[i].failed )
+            return EXIT_FAILURE;
+    }
+
+    if( tl_sharedmap_count( map ) != MIXED_KEYS )
+        return EXIT_FAILURE;
+
+    tl_sharedmap_destroy( map );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+#include "tl_snapshot.h"
+#include "tl_hashmap.h"
+#include "tl_file.h"
+#include "tl_fs.h"
+
+#include <stdlib.h>
+
+#define FILENAME "snapshot.bin"
+#define TRUNCNAME "snapshot_trunc.bin"
+
+
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    return (*((unsigned long*)obj)) / 10;
+}
+
+/* copy the first size bytes of a file into a new file */
+static int copy_prefix( const char* src, const char* dst, size_t size )
+{
+    tl_file *in, *out;
+    char buffer[ 8192 ];
+    size_t actual;
+    int ret = 0;
+
+    if( size > sizeof(buffer) )
+        return 0;
+
+    if( tl_file_open( src, &in, TL_READ ) )
+        return 0;
+
+    if( tl_file_open( dst, &out, TL_WRITE|TL_CREATE|TL_OVERWRITE ) )
+    {
+        ((tl_iostream*)in)->destroy( (tl_iostream*)in );
+        return 0;
+    }
+
+    if( !((tl_iostream*)in)->read( (tl_iostream*)in, buffer, size,
+                                   &actual ) && actual == size &&
+        !((tl_iostream*)out)->write( (tl_iostream*)out, buffer, size,
+                                     &actual ) && actual == size )
+    {
+        ret = 1;
+    }
+
+    ((tl_iostream*)in)->destroy( (tl_iostream*)in );
+    ((tl_iostream*)out)->destroy( (tl_iostream*)out );
+    return ret;
+}
+
+
+
+int main( void )
+{
+    tl_hashmap_snapshot snap;
+    tl_hashmap map;
+    tl_file* file;
+    const long* ptr;
+    long i, l, n;
+
+    /* a growing map, with some shadowed duplicates */
+    tl_hashmap_init(&map,sizeof(long),sizeof(long),4,hash,compare,NULL,NULL);
+    tl_hashmap_set_max_load( &map, 100 );
+
+    for( i=0; i<10000; ++i )
+    {
+        l = i * 3;
+        tl_hashmap_insert( &map, &i, &l );
+
+        if( (i % 100) == 0 )
+        {
+            l = -i;
+            tl_hashmap_insert( &map, &i, &l );
+        }
+    }
+
+    /* keep going until the map is in the middle of growing */
+    for( n=10000; !map.old_bins; ++n )
+    {
+        l = n * 3;
+        tl_hashmap_insert( &map, &n, &l );
+    }
+
+    /* write the snapshot */
+    if( tl_file_open( FILENAME, &file, TL_WRITE|TL_CREATE|TL_OVERWRITE ) )
+        return EXIT_FAILURE;
+
+    if( tl_hashmap_snapshot_write( &map, (tl_iostream*)file ) != 0 )
+        return EXIT_FAILURE;
+
+    ((tl_iostream*)file)->destroy( (tl_iostream*)file );
+
+    /* map it back in and query it without the original map */
+    if( tl_file_open( FILENAME, &file, TL_READ ) )
+        return EXIT_FAILURE;
+
+    if( tl_hashmap_snapshot_load( &snap, file, hash, compare ) != 0 )
+        return EXIT_FAILURE;
+
+    ((tl_iostream*)file)->destroy( (tl_iostream*)file );
+
+    if( snap.count != map.count || snap.bincount != map.bincount )
+        return EXIT_FAILURE;
+
+    for( i=0; i<n; ++i )
+    {
+        ptr = tl_hashmap_snapshot_at( &snap, &i );
+
+        if( !ptr || *ptr != *((long*)tl_hashmap_at( &map, &i )) )
+            return EXIT_FAILURE;
+        if( *ptr != ((i < 10000 && (i % 100) == 0) ? -i : i * 3) )
+            return EXIT_FAILURE;
+    }
+
+    for( i=n; i<n+1000; ++i )
+    {
+        if( tl_hashmap_snapshot_at( &snap, &i ) )
+            return EXIT_FAILURE;
+    }
+
+    tl_hashmap_snapshot_cleanup( &snap );
+
+    /* a truncated snapshot is rejected instead of mapped */
+    if( !copy_prefix( FILENAME, TRUNCNAME, 8192 ) )
+        return EXIT_FAILURE;
+
+    if( tl_file_open( TRUNCNAME, &file, TL_READ ) )
+        return EXIT_FAILURE;
+
+    if( tl_hashmap_snapshot_load( &snap, file, hash, compare ) != TL_ERR_ARG )
+        return EXIT_FAILURE;
+
+    ((tl_iostream*)file)->destroy( (tl_iostream*)file );
+    tl_fs_delete( TRUNCNAME );
+
+    /* maps with allocators cannot be stored */
+    map.keyalloc = (tl_allocator*)&map;
+
+    if( tl_file_open( FILENAME, &file, TL_WRITE|TL_OVERWRITE ) )
+        return EXIT_FAILURE;
+
+    if( tl_hashmap_snapshot_write( &map, (tl_iostream*)file ) != TL_ERR_ARG )
+        return EXIT_FAILURE;
+
+    ((tl_iostream*)file)->destroy( (tl_iostream*)file );
+    map.keyalloc = NULL;
+
+    /* an empty file is not a snapshot */
+    if( tl_file_open( FILENAME, &file, TL_READ ) )
+        return EXIT_FAILURE;
+
+    if( tl_hashmap_snapshot_load( &snap, file, hash, compare ) != TL_ERR_ARG )
+        return EXIT_FAILURE;
+
+    ((tl_iostream*)file)->destroy( (tl_iostream*)file );
+
+    tl_fs_delete( FILENAME );
+    tl_hashmap_cleanup( &map );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+#include "tl_typedmap.h"
+#include "tl_hashmap.h"
+
+#include <stdlib.h>
+
+#define NUM_KEYS 500000
+
+
+
+static TL_INLINE unsigned long long_hash( long key )
+{
+    return (unsigned long)key / 10;
+}
+
+#define LONG_EQUAL( a, b ) ((a) == (b))
+
+TL_HASHMAP_DEFINE( longmap, long, long, long_hash, LONG_EQUAL )
+
+static int compare( const void* a, const void* b )
+{
+    return *((long*)a) - *((long*)b);
+}
+
+static unsigned long hash( const void* obj )
+{
+    return (*((unsigned long*)obj)) / 10;
+}
+
+static int test_semantics( void )
+{
+    long test_keys[ ] = {   5,   6,   7,  12,  20 };
+    long test_vals[ ] = { 100, 200, 300, 400, 500 };
+    longmap map;
+    long i, l;
+
+    if( !longmap_init( &map, 10 ) || !longmap_is_empty( &map ) )
+        return 0;
+
+    for( i=0; i<5; ++i )
+    {
+        if( longmap_at( &map, test_keys[i] ) )
+            return 0;
+
+        longmap_insert( &map, test_keys[i], test_vals[i] );
+
+        if( *longmap_at( &map, test_keys[i] ) != test_vals[i] )
+            return 0;
+    }
+
+    /* a key inserted twice shadows the older entry until removed */
+    longmap_insert( &map, test_keys[2], 42 );
+
+    if( map.count != 6 || *longmap_at( &map, test_keys[2] ) != 42 )
+        return 0;
+    if( !longmap_remove( &map, test_keys[2], &l ) || l != 42 )
+        return 0;
+    if( *longmap_at( &map, test_keys[2] ) != test_vals[2] )
+        return 0;
+
+    if( !longmap_set( &map, test_keys[0], 7 ) || longmap_set( &map, 1, 7 ) )
+        return 0;
+    if( *longmap_at( &map, test_keys[0] ) != 7 )
+        return 0;
+
+    for( i=0; i<5; ++i )
+    {
+        if( !longmap_remove( &map, test_keys[i], NULL ) )
+            return 0;
+        if( longmap_remove( &map, test_keys[i], NULL ) )
+            return 0;
+    }
+
+    if( !longmap_is_empty( &map ) )
+        return 0;
+
+    /* growing, with duplicates surviving the rehash in the right order */
+    longmap_set_max_load( &map, 75 );
+
+    for( i=0; i<5000; ++i )
+    {
+        longmap_insert( &map, i, i * 3 );
+
+        if( (i % 100) == 0 )
+            longmap_insert( &map, i, -i );
+    }
+
+    if( map.bincount <= 10 || map.count != 5050 )
+        return 0;
+
+    for( i=0; i<5000; ++i )
+    {
+        if( *longmap_at( &map, i ) != ((i % 100) == 0 ? -i : i * 3) )
+            return 0;
+    }
+
+    for( i=0; i<5000; i+=100 )
+    {
+        if( !longmap_remove( &map, i, &l ) || l != -i )
+            return 0;
+        if( *longmap_at( &map, i ) != i * 3 )
+            return 0;
+    }
+
+    longmap_clear( &map );
+
+    if( !longmap_is_empty( &map ) || longmap_at( &map, 1 ) )
+        return 0;
+
+    longmap_cleanup( &map );
+    return 1;
+}
+
+
+
+int main( void )
+{
+    unsigned long sum0 = 0, sum1 = 0;
+    tl_hashmap generic;
+    longmap typed;
+    long i, l;
+
+    if( !test_semantics( ) )
+        return EXIT_FAILURE;
+
+    /* must agree with the generic hash map on a large number of keys */
+    tl_hashmap_init( &generic, sizeof(long), sizeof(long), 1024,
+                     hash, compare, NULL, NULL );
+    tl_hashmap_set_max_load( &generic, 100 );
+
+    longmap_init( &typed, 1024 );
+    longmap_set_max_load( &typed, 100 );
+
+    for( i=0; i<NUM_KEYS; ++i )
+        tl_hashmap_insert( &generic, &i, &i );
+    for( i=0; i<NUM_KEYS; ++i )
+        sum0 += *((long*)tl_hashmap_at( &generic, &i ));
+
+    for( i=0; i<NUM_KEYS; ++i )
+        longmap_insert( &typed, i, i );
+    for( i=0; i<NUM_KEYS; ++i )
+        sum1 += *longmap_at( &typed, i );
+
+    if( sum0 != sum1 || typed.count != generic.count )
+        return EXIT_FAILURE;
+
+    for( i=0; i<NUM_KEYS; ++i )
+    {
+        if( !longmap_remove( &typed, i, &l ) || l != i )
+            return EXIT_FAILURE;
+    }
+
+    tl_hashmap_cleanup( &generic );
+    longmap_cleanup( &typed );
+    return EXIT_SUCCESS;
+}